@@ -27,6 +27,194 @@
 
 #include "advection.h"
 
+// Departure points of the scalar cells, shared by the temperature and the
+// trace substances of a time step, see set_departure_points()
+static DEPARTURE_TABLE scalar_departure = {NULL, NULL, 0, 0};
+static int departure_valid = 0; // 1 if the points belong to the velocity
+
+// Departure points of the velocity that is advected
+static DEPARTURE_TABLE velocity_departure = {NULL, NULL, 0, 0};
+
+///////////////////////////////////////////////////////////////////////////////
+/// Find the cell where the backward tracing stops in one direction
+///
+/// This is the cell where set_x_location(), set_y_location() or
+/// set_z_location() stop if no boundary is hit: the first cell c from i with
+/// x[c]<=OL if OL<x[i], or with x[c]>=OL if OL>x[i]. It is found by an
+/// exponential search on the 1D coordinates instead of stepping cell by cell,
+/// so that the cost grows with the logarithm of the distance.
+///
+///\param x Pointer to the 1D coordinates of the location
+///\param n Last index of the coordinates
+///\param i Index of the current cell
+///\param OL Location of the particle at time (t-1)
+///
+///\return Index of the cell
+///////////////////////////////////////////////////////////////////////////////
+static int search_location(REAL *x, int n, int i, REAL OL) {
+  int lo, hi, mid, step;
+
+  // Largest c<i with x[c]<=OL, or 0
+  if(OL<x[i]) {
+    // Bracket the cell with steps of growing size, then bisect
+    hi = i;
+    lo = i-1;
+    for(step=2; lo>0 && x[lo]>OL; step*=2) {
+      hi = lo;
+      lo = max(i-step, 0);
+    }
+    while(hi-lo>1) {
+      mid = (lo+hi) / 2;
+      if(x[mid]<=OL) lo = mid;
+      else hi = mid;
+    }
+    return lo;
+  }
+  // Smallest c>i with x[c]>=OL, or n
+  else if(OL>x[i]) {
+    lo = i;
+    hi = i+1;
+    for(step=2; hi<n && x[hi]<OL; step*=2) {
+      lo = hi;
+      hi = min(i+step, n);
+    }
+    while(hi-lo>1) {
+      mid = (lo+hi) / 2;
+      if(x[mid]>=OL) hi = mid;
+      else lo = mid;
+    }
+    return hi;
+  }
+  else
+    return i;
+} // End of search_location()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Find the departure cell without the step by step tracing
+///
+/// The cells found by search_location() are the result of the backward
+/// tracing if the path does not hit a boundary. Every cell visited by the
+/// tracing lies in the box between the current cell and those cells, so that
+/// the result is valid if the box has only fluid cells. Otherwise the caller
+/// has to do the tracing with set_x_location(), set_y_location() and
+/// set_z_location(). The cells are counted in the table of set_nonfluid(),
+/// which has to be built for the location of the variable.
+///
+///\param para Pointer to FFD parameters
+///\param x Pointer to the 1D coordinates of the location in X-direction
+///\param y Pointer to the 1D coordinates of the location in Y-direction
+///\param z Pointer to the 1D coordinates of the location in Z-direction
+///\param i I-index for cell at time t
+///\param j J-index for cell at time t
+///\param k K-index for cell at time t
+///\param OL Pointer to the locations of particle at time (t-1)
+///\param OC Pointer to the coordinates of particle at time (t-1)
+///
+///\return 1 if the departure cell was found, otherwise 0
+///////////////////////////////////////////////////////////////////////////////
+static int locate_departure(PARA_DATA *para, REAL *x, REAL *y, REAL *z,
+                            int i, int j, int k, REAL *OL, int *OC) {
+  int ci, cj, ck;
+
+  ci = search_location(x, para->geom->imax+1, i, OL[X]);
+  cj = search_location(y, para->geom->jmax+1, j, OL[Y]);
+  ck = search_location(z, para->geom->kmax+1, k, OL[Z]);
+
+  // The path may cross a solid, inlet or outlet cell
+  if(count_nonfluid(para, i, j, k, ci, cj, ck)!=0) return 0;
+
+  OC[X] = ci;
+  OC[Y] = cj;
+  OC[Z] = ck;
+  return 1;
+} // End of locate_departure()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of a table of departure points
+///
+///\param t Pointer to the table
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void free_departure_table(DEPARTURE_TABLE *t) {
+  if(t->point!=NULL) free(t->point);
+  if(t->start!=NULL) free(t->start);
+  t->point = NULL;
+  t->start = NULL;
+  t->nb_point = 0;
+  t->nb_start = 0;
+} // End of free_departure_table()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Prepare a table of departure points for the fluid cells of a location
+///
+/// The memory is only allocated again if the table is too small. The points
+/// of run r start at t->start[r], so that each run can be filled and
+/// interpolated independently of the others.
+///
+///\param t Pointer to the table
+///\param runs Pointer to the runs of the location
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int set_departure_table(DEPARTURE_TABLE *t, RUN_LIST *runs) {
+  int r, n = 0;
+
+  for(r=0; r<runs->nb_run; r++) n += runs->run[r].i2 - runs->run[r].i1 + 1;
+
+  if(n>t->nb_point || runs->nb_run+1>t->nb_start) {
+    free_departure_table(t);
+    t->point = (DEPARTURE_POINT *) malloc(max(n,1)*sizeof(DEPARTURE_POINT));
+    t->start = (int *) malloc((runs->nb_run+1)*sizeof(int));
+    if(t->point==NULL || t->start==NULL) {
+      ffd_log("set_departure_table(): Could not allocate memory for the "
+              "departure points.", FFD_ERROR);
+      free_departure_table(t);
+      return 1;
+    }
+    t->nb_point = n;
+    t->nb_start = runs->nb_run+1;
+  }
+
+  t->start[0] = 0;
+  for(r=0; r<runs->nb_run; r++)
+    t->start[r+1] = t->start[r] + runs->run[r].i2 - runs->run[r].i1 + 1;
+
+  return 0;
+} // End of set_departure_table()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Interpolate a variable at the departure points of all the runs
+///
+/// The interpolation method is selected once for the sweep and applied to
+/// whole runs of cells.
+///
+///\param para Pointer to FFD parameters
+///\param runs Pointer to the runs of the location
+///\param t Pointer to the departure points of the runs
+///\param d0 Pointer to the variable for interpolation
+///\param d Pointer to the interpolated variable
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int interpolate_runs(PARA_DATA *para, RUN_LIST *runs,
+                            DEPARTURE_TABLE *t, REAL *d0, REAL *d) {
+  int r;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  INTERPOLATION_KERNEL kernel = interpolation_kernel(para);
+
+  if(kernel==NULL) return 1;
+
+  // All the cells cost the same, unlike the tracing
+#pragma omp parallel for schedule(static)
+  for(r=0; r<runs->nb_run; r++)
+    kernel(para, d0, &t->point[t->start[r]], t->start[r+1]-t->start[r],
+           &d[IX(runs->run[r].i1, runs->run[r].j, runs->run[r].k)]);
+
+  return 0;
+} // End of interpolate_runs()
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Entrance of advection step
 ///
@@ -39,35 +227,37 @@
 ///\param index Index of trace substances or species
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int advect(PARA_DATA *para, REAL **var, int var_type, int index, 
-           REAL *d, REAL *d0, int **BINDEX) {
+           REAL *d, REAL *d0) {
   int flag;
+  // A new velocity field needs new departure points for the scalars
+  if(var_type==VX || var_type==VY || var_type==VZ) departure_valid = 0;
+
   switch (var_type) {
     case VX:
-      flag = trace_vx(para, var, var_type, d, d0, BINDEX);
+      flag = trace_vx(para, var, var_type, d, d0);
       if(flag!=0)
         ffd_log("advect(): Failed in advection for X-velocity.",
                 FFD_ERROR);
       break;
     case VY:
-      flag = trace_vy(para, var, var_type, d, d0, BINDEX);
+      flag = trace_vy(para, var, var_type, d, d0);
       if(flag!=0)
         ffd_log("advect(): Failed in advection for Y-velocity.",
                 FFD_ERROR);
       break;
     case VZ:
-      flag = trace_vz(para, var, var_type, d, d0, BINDEX);
+      flag = trace_vz(para, var, var_type, d, d0);
       if(flag!=0)
         ffd_log("advect(): Failed in advection for Z-velocity.",
                 FFD_ERROR);
       break;
     case TEMP:
     case TRACE:
-      flag = trace_scalar(para, var, var_type, index, d, d0, BINDEX);
+      flag = trace_scalar(para, var, var_type, index, d, d0);
       if(flag!=0) {
         sprintf(msg, 
                 "advect(): Failed in advection for scalar variable type %d.", 
@@ -93,48 +283,54 @@ int advect(PARA_DATA *para, REAL **var, int var_type, int index,
 ///\param var_type The type of variable for advection solver
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
-             int **BINDEX) {
-  int i, j, k;
-  int it;
+int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0) {
+  int i, j, k, r;
+  int it, fail = 0;
   int itmax = 20000; // Max number of iterations for backward tracing 
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL x_1, y_1, z_1;
   REAL dt = para->mytime->dt; 
   REAL u0, v0, w0;
-  REAL *x = var[X], *y = var[Y],  *z = var[Z]; 
-  REAL *gx = var[GX]; 
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
+  REAL *z = para->geom->mesh->z, *gx = para->geom->mesh->gx;
+  REAL *rdx = para->geom->mesh->rdx, *rdxc = para->geom->mesh->rdxc;
+  REAL *rdyc = para->geom->mesh->rdyc, *rdzc = para->geom->mesh->rdzc;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
-  REAL *flagu = var[FLAGU];
+  RUN_LIST *runs = cell_run(para, MASK_U);
+  CELL_MASK *mask = cell_mask(para);
   int  COOD[3], LOC[3];
   REAL OL[3];
   int  OC[3];
+  DEPARTURE_TABLE *t = &velocity_departure;
+  DEPARTURE_POINT *dp;
+
+  if(runs==NULL || mask==NULL) return 1;
+  if(set_departure_table(t, runs)!=0 || set_nonfluid(para, runs)!=0)
+    return 1;
 
-  FOR_U_CELL
-    if(flagu[IX(i,j,k)]>=0) continue;
+  // Only the fluid cells are traced
+#pragma omp parallel for private(i, j, k, it, u0, v0, w0, COOD, LOC, OL, OC, dp) schedule(dynamic, ADVECT_CHUNK)
+  FOR_EACH_RUN(runs)
     /*-----------------------------------------------------------------------
     | Step 1: Tracing Back
     -----------------------------------------------------------------------*/
     // Get velocities at the location of VX
     u0 = u[IX(i,j,k)];
     v0 = (REAL) 0.5 
-        * ((v[IX(i,  j,k)]+v[IX(i,  j-1,k)])*( x[IX(i+1,j,k)]-gx[IX(i,j,k)])
-          +(v[IX(i+1,j,k)]+v[IX(i+1,j-1,k)])*(gx[IX(i,  j,k)]- x[IX(i,j,k)])) 
-        / (x[IX(i+1,j,k)]-x[IX(i,j,k)]);
+        * ((v[IX(i,  j,k)]+v[IX(i,  j-1,k)])*( x[i+1]-gx[i])
+          +(v[IX(i+1,j,k)]+v[IX(i+1,j-1,k)])*(gx[i]- x[i])) 
+        * rdxc[i];
     w0 = (REAL) 0.5 
-        * ((w[IX(i,  j,k)]+w[IX(i  ,j, k-1)])*( x[IX(i+1,j,k)]-gx[IX(i,j,k)])
-          +(w[IX(i+1,j,k)]+w[IX(i+1,j, k-1)])*(gx[IX(i,  j,k)]- x[IX(i,j,k)]))
-        / (x[IX(i+1,j,k)]-x[IX(i,j,k)]); 
+        * ((w[IX(i,  j,k)]+w[IX(i  ,j, k-1)])*( x[i+1]-gx[i])
+          +(w[IX(i+1,j,k)]+w[IX(i+1,j, k-1)])*(gx[i]- x[i]))
+        * rdxc[i];
     // Find the location at previous time step
-    OL[X] =gx[IX(i,j,k)] - u0*dt;
-    OL[Y] = y[IX(i,j,k)] - v0*dt;
-    OL[Z] = z[IX(i,j,k)] - w0*dt;
+    OL[X] =gx[i] - u0*dt;
+    OL[Y] = y[j] - v0*dt;
+    OL[Z] = z[k] - w0*dt;
     // Initialize the coordinates of previous step 
     OC[X] = i; 
     OC[Y] = j; 
@@ -152,26 +348,37 @@ int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     //Initialize the number of iterations
     it=1;
 
+    // Skip the tracing if the path only crosses fluid cells
+    if(locate_departure(para, gx, y, z, i, j, k, OL, OC)) {
+      COOD[X] = 0;
+      COOD[Y] = 0;
+      COOD[Z] = 0;
+    }
+
     // Trace back more if the any of the trace is still in process 
     while(COOD[X]==1 || COOD[Y] ==1 || COOD[Z] ==1)
     {
       it++;
       // If trace in X is in process and donot hit the boundary
       if(COOD[X]==1 && LOC[X]==1) 
-        set_x_location(para, var, flagu, gx, u0, i, j, k, OL, OC, LOC, COOD); 
+        set_x_location(para, var, mask, MASK_U, gx, u0, i, j, k, OL, OC, LOC, COOD); 
       // If trace in Y is in process and donot hit the boundary
       if(COOD[Y]==1 && LOC[Y]==1) 
-        set_y_location(para, var, flagu, y, v0, i, j, k, OL, OC, LOC, COOD); 
+        set_y_location(para, var, mask, MASK_U, y, v0, i, j, k, OL, OC, LOC, COOD); 
       // If trace in Z is in process and donot hit the boundary
       if(COOD[Z]==1 && LOC[Z]==1) 
-        set_z_location(para, var, flagu, z, w0, i, j, k, OL, OC, LOC, COOD); 
+        set_z_location(para, var, mask, MASK_U, z, w0, i, j, k, OL, OC, LOC, COOD); 
 
       if(it>itmax)
       {
-        printf("Error: advection.c, can not track the location for VX(%d, %d,%d)",
-                i, j, k);
-        printf("after %d iterations.\n", it);
-        return 1;
+#pragma omp critical
+        {
+          printf("Error: advection.c, can not track the location for VX(%d, %d,%d)",
+                  i, j, k);
+          printf("after %d iterations.\n", it);
+          fail = 1;
+        }
+        break;
       }
     } // End of while() for backward tracing
 
@@ -187,23 +394,28 @@ int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     if(w0<0 && LOC[Z]==1) OC[Z] -=1;
 
     /*-------------------------------------------------------------------------
-    | Interpolate
+    | Store the cell and the relative location for the interpolation
     -------------------------------------------------------------------------*/
-    x_1 = (OL[X]-gx[IX(OC[X],OC[Y],OC[Z])]) 
-        / (gx[IX(OC[X]+1,OC[Y],OC[Z])]-gx[IX(OC[X],OC[Y],OC[Z])]); 
-    y_1 = (OL[Y]-y[IX(OC[X],OC[Y],OC[Z])])
-        / (y[IX(OC[X],OC[Y]+1,OC[Z])]-y[IX(OC[X],OC[Y],OC[Z])]);
-    z_1 = (OL[Z]-z[IX(OC[X],OC[Y],OC[Z])]) 
-        / (z[IX(OC[X],OC[Y],OC[Z]+1)]-z[IX(OC[X],OC[Y],OC[Z])]);
+    dp = &t->point[t->start[r]+i-runs->run[r].i1];
+    dp->i = OC[X];
+    dp->j = OC[Y];
+    dp->k = OC[Z];
+    dp->x_1 = (OL[X]-gx[OC[X]]) * rdx[OC[X]+1];
+    dp->y_1 = (OL[Y]-y[OC[Y]]) * rdyc[OC[Y]];
+    dp->z_1 = (OL[Z]-z[OC[Z]]) * rdzc[OC[Z]];
+  END_FOR // End of loop for all cells
 
-    d[IX(i,j,k)] = interpolation(para, d0, x_1, y_1, z_1, OC[X], OC[Y], OC[Z]);
+  if(fail) return 1;
 
-  END_FOR // End of loop for all cells
+  /*---------------------------------------------------------------------------
+  | Interpolate
+  ---------------------------------------------------------------------------*/
+  if(interpolate_runs(para, runs, t, d0, d)!=0) return 1;
 
   /*---------------------------------------------------------------------------
   | define the b.c.
   ---------------------------------------------------------------------------*/
-  set_bnd(para, var, var_type, 0, d, BINDEX);
+  set_bnd(para, var, var_type, 0, d);
 
   return 0;
 } // End of trace_vx()
@@ -216,50 +428,55 @@ int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 ///\param var_type The type of variable for advection solver
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
-             int **BINDEX) {
-  int i, j, k;
-  int it;
+int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0) {
+  int i, j, k, r;
+  int it, fail = 0;
   int itmax = 20000; // Max number of iterations for backward tracing 
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL x_1, y_1, z_1;
   REAL dt = para->mytime->dt; 
   REAL u0, v0, w0;
-  REAL *x = var[X], *y = var[Y],  *z = var[Z]; 
-  REAL *gy = var[GY]; 
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
+  REAL *z = para->geom->mesh->z, *gy = para->geom->mesh->gy;
+  REAL *rdy = para->geom->mesh->rdy, *rdxc = para->geom->mesh->rdxc;
+  REAL *rdyc = para->geom->mesh->rdyc, *rdzc = para->geom->mesh->rdzc;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
-  REAL *flagv = var[FLAGV];
+  RUN_LIST *runs = cell_run(para, MASK_V);
+  CELL_MASK *mask = cell_mask(para);
   int  COOD[3], LOC[3];
   REAL OL[3];
   int  OC[3];
+  DEPARTURE_TABLE *t = &velocity_departure;
+  DEPARTURE_POINT *dp;
+
+  if(runs==NULL || mask==NULL) return 1;
+  if(set_departure_table(t, runs)!=0 || set_nonfluid(para, runs)!=0)
+    return 1;
 
-  FOR_V_CELL
-    // Do not trace for boundary cells
-    if(flagv[IX(i,j,k)]>=0) continue;
+  // Only the fluid cells are traced
+#pragma omp parallel for private(i, j, k, it, u0, v0, w0, COOD, LOC, OL, OC, dp) schedule(dynamic, ADVECT_CHUNK)
+  FOR_EACH_RUN(runs)
 
     /*-------------------------------------------------------------------------
     | Step 1: Tracing Back
     -------------------------------------------------------------------------*/
     // Get velocities at the location of VY
     u0 = (REAL) 0.5
-       * ((u[IX(i,j,k)]+u[IX(i-1,j,  k)])*(y [IX(i,j+1,k)]-gy[IX(i,j,k)])
-         +(u[IX(i,j+1,k)]+u[IX(i-1,j+1,k)])*(gy[IX(i,j,  k)]-y[IX(i,j,k)]))
-       / (y[IX(i,j+1,k)]-y[IX(i,j,k)]);
+       * ((u[IX(i,j,k)]+u[IX(i-1,j,  k)])*(y[j+1]-gy[j])
+         +(u[IX(i,j+1,k)]+u[IX(i-1,j+1,k)])*(gy[j]-y[j]))
+       * rdyc[j];
     v0 = v[IX(i,j,k)]; 
     w0 = (REAL) 0.5
-       * ((w[IX(i,j,k)]+w[IX(i,j,k-1)])*(y[IX(i,j+1,k)]-gy[IX(i,j,k)])
-         +(w[IX(i,j+1,k)]+w[IX(i,j+1,k-1)])*(gy[IX(i,j,k)]-y[IX(i,j,k)]))
-       / (y[IX(i,j+1,k)]-y[IX(i,j,k)]); 
+       * ((w[IX(i,j,k)]+w[IX(i,j,k-1)])*(y[j+1]-gy[j])
+         +(w[IX(i,j+1,k)]+w[IX(i,j+1,k-1)])*(gy[j]-y[j]))
+       * rdyc[j]; 
     // Find the location at previous time step
-    OL[X] = x[IX(i,j,k)] - u0*dt; 
-    OL[Y] = gy[IX(i,j,k)] - v0*dt;
-    OL[Z] = z[IX(i,j,k)] - w0*dt;
+    OL[X] = x[i] - u0*dt; 
+    OL[Y] = gy[j] - v0*dt;
+    OL[Z] = z[k] - w0*dt;
     // Initialize the coordinates of previous step
     OC[X] = i;
     OC[Y] = j;
@@ -277,22 +494,33 @@ int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     //Initialize the number of iterations
     it=1;
 
+    // Skip the tracing if the path only crosses fluid cells
+    if(locate_departure(para, x, gy, z, i, j, k, OL, OC)) {
+      COOD[X] = 0;
+      COOD[Y] = 0;
+      COOD[Z] = 0;
+    }
+
     // Trace back more if the any of the trace is still in process 
     while(COOD[X]==1 || COOD[Y] ==1 || COOD[Z] == 1)
     {
       it++;
       if(COOD[X]==1 && LOC[X]==1)
-        set_x_location(para, var, flagv, x, u0, i, j, k, OL, OC, LOC, COOD); 
+        set_x_location(para, var, mask, MASK_V, x, u0, i, j, k, OL, OC, LOC, COOD); 
       if(COOD[Y]==1 && LOC[Y]==1)
-        set_y_location(para, var, flagv, gy, v0, i, j, k, OL, OC, LOC, COOD); 
+        set_y_location(para, var, mask, MASK_V, gy, v0, i, j, k, OL, OC, LOC, COOD); 
       if(COOD[Z]==1 && LOC[Z]==1)
-          set_z_location(para, var, flagv, z, w0, i, j, k, OL, OC, LOC, COOD); 
+          set_z_location(para, var, mask, MASK_V, z, w0, i, j, k, OL, OC, LOC, COOD); 
 
       if(it>itmax) {
-        printf("Error: advection.c can not track the location for VY(%d, %d,%d)",
-                i, j, k);
-        printf("after %d iterations.\n", it);
-        return 1;
+#pragma omp critical
+        {
+          printf("Error: advection.c can not track the location for VY(%d, %d,%d)",
+                  i, j, k);
+          printf("after %d iterations.\n", it);
+          fail = 1;
+        }
+        break;
       }
     } // End of while() loop
 
@@ -306,23 +534,30 @@ int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     if(u0<0 && LOC[X]==1) OC[X] -=1;
     if(v0<0 && LOC[Y]==1) OC[Y] -=1;
     if(w0<0 && LOC[Z]==1) OC[Z] -=1;
-            
+
     /*-------------------------------------------------------------------------
-    | Interpolating for all variables
+    | Store the cell and the relative location for the interpolation
     -------------------------------------------------------------------------*/
-    x_1 = (OL[X]-x[IX(OC[X],OC[Y],OC[Z])])
-        / (x[IX(OC[X]+1,OC[Y],OC[Z])]-x[IX(OC[X],OC[Y],OC[Z])]); 
-    y_1 = (OL[Y]-gy[IX(OC[X],OC[Y],OC[Z])])
-        / (gy[IX(OC[X],OC[Y]+1,OC[Z])]-gy[IX(OC[X],OC[Y],OC[Z])]);
-    z_1 = (OL[Z]-z[IX(OC[X],OC[Y],OC[Z])])
-        / (z[IX(OC[X],OC[Y],OC[Z]+1)]-z[IX(OC[X],OC[Y],OC[Z])]);
-    d[IX(i,j,k)] = interpolation(para, d0, x_1, y_1, z_1, OC[X],OC[Y],OC[Z]);
+    dp = &t->point[t->start[r]+i-runs->run[r].i1];
+    dp->i = OC[X];
+    dp->j = OC[Y];
+    dp->k = OC[Z];
+    dp->x_1 = (OL[X]-x[OC[X]]) * rdxc[OC[X]];
+    dp->y_1 = (OL[Y]-gy[OC[Y]]) * rdy[OC[Y]+1];
+    dp->z_1 = (OL[Z]-z[OC[Z]]) * rdzc[OC[Z]];
   END_FOR // End of For() loop for each cell
 
+  if(fail) return 1;
+
+  /*---------------------------------------------------------------------------
+  | Interpolate
+  ---------------------------------------------------------------------------*/
+  if(interpolate_runs(para, runs, t, d0, d)!=0) return 1;
+
   /*---------------------------------------------------------------------------
   | define the b.c.
   ---------------------------------------------------------------------------*/
-  set_bnd(para, var, var_type, 0, d, BINDEX);
+  set_bnd(para, var, var_type, 0, d);
   return 0;
 } // End of trace_vy()
 
@@ -334,50 +569,55 @@ int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 ///\param var_type The type of variable for advection solver
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
-             int **BINDEX) {
-  int i, j, k;
-  int it;
+int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0) {
+  int i, j, k, r;
+  int it, fail = 0;
   int itmax = 20000; // Max number of iterations for backward tracing 
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL x_1, y_1, z_1;
   REAL dt = para->mytime->dt; 
   REAL u0, v0, w0;
-  REAL *x = var[X], *y = var[Y],  *z = var[Z]; 
-  REAL *gz = var[GZ]; 
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
+  REAL *z = para->geom->mesh->z, *gz = para->geom->mesh->gz;
+  REAL *rdz = para->geom->mesh->rdz, *rdxc = para->geom->mesh->rdxc;
+  REAL *rdyc = para->geom->mesh->rdyc, *rdzc = para->geom->mesh->rdzc;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
-  REAL *flagw = var[FLAGW];
+  RUN_LIST *runs = cell_run(para, MASK_W);
+  CELL_MASK *mask = cell_mask(para);
   int  COOD[3], LOC[3];
   REAL OL[3];
   int  OC[3];
+  DEPARTURE_TABLE *t = &velocity_departure;
+  DEPARTURE_POINT *dp;
+
+  if(runs==NULL || mask==NULL) return 1;
+  if(set_departure_table(t, runs)!=0 || set_nonfluid(para, runs)!=0)
+    return 1;
 
-  FOR_W_CELL
-    // Do not trace for boundary cells
-    if(flagw[IX(i,j,k)]>=0) continue;
+  // Only the fluid cells are traced
+#pragma omp parallel for private(i, j, k, it, u0, v0, w0, COOD, LOC, OL, OC, dp) schedule(dynamic, ADVECT_CHUNK)
+  FOR_EACH_RUN(runs)
 
     /*-------------------------------------------------------------------------
     | Step 1: Tracing Back
     -------------------------------------------------------------------------*/
     // Get velocities at the location of VZ
     u0 = (REAL) 0.5 
-       * ((u[IX(i,j,k  )]+u[IX(i-1,j,k  )])*(z [IX(i,j,k+1)]-gz[IX(i,j,k)])
-         +(u[IX(i,j,k+1)]+u[IX(i-1,j,k+1)])*(gz[IX(i,j,k  )]- z[IX(i,j,k)]))
-       /  (z[IX(i,j,k+1)]-z[IX(i,j,k)]);
+       * ((u[IX(i,j,k  )]+u[IX(i-1,j,k  )])*(z[k+1]-gz[k])
+         +(u[IX(i,j,k+1)]+u[IX(i-1,j,k+1)])*(gz[k]- z[k]))
+       * rdzc[k];
     v0 = (REAL) 0.5
-       * ((v[IX(i,j,k  )]+v[IX(i,j-1,k  )])*(z [IX(i,j,k+1)]-gz[IX(i,j,k)])
-       +(v[IX(i,j,k+1)]+v[IX(i,j-1,k+1)])*(gz[IX(i,j,k  )]-z [IX(i,j,k)]))
-       /  (z[IX(i,j,k+1)]-z[IX(i,j,k)]); 
+       * ((v[IX(i,j,k  )]+v[IX(i,j-1,k  )])*(z[k+1]-gz[k])
+       +(v[IX(i,j,k+1)]+v[IX(i,j-1,k+1)])*(gz[k]-z[k]))
+       * rdzc[k];
     w0 = w[IX(i,j,k)]; 
     // Find the location at previous time step
-    OL[X] = x[IX(i,j,k)] - u0*dt; 
-    OL[Y] = y[IX(i,j,k)] - v0*dt;
-    OL[Z] = gz[IX(i,j,k)] - w0*dt;
+    OL[X] = x[i] - u0*dt; 
+    OL[Y] = y[j] - v0*dt;
+    OL[Z] = gz[k] - w0*dt;
     // Initialize the coordinates of previous step
     OC[X] = i;
     OC[Y] = j;
@@ -395,21 +635,32 @@ int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     //Initialize the number of iterations
     it=1;
 
+    // Skip the tracing if the path only crosses fluid cells
+    if(locate_departure(para, x, y, gz, i, j, k, OL, OC)) {
+      COOD[X] = 0;
+      COOD[Y] = 0;
+      COOD[Z] = 0;
+    }
+
     // Trace back more if the any of the trace is still in process 
     while(COOD[X]==1 || COOD[Y] ==1 || COOD[Z] == 1) {
       it++;
       if(COOD[X]==1 && LOC[X]==1)
-        set_x_location(para, var, flagw, x, u0, i, j, k, OL, OC, LOC, COOD); 
+        set_x_location(para, var, mask, MASK_W, x, u0, i, j, k, OL, OC, LOC, COOD); 
       if(COOD[Y]==1 && LOC[Y]==1)
-        set_y_location(para, var, flagw, y, v0, i, j, k, OL, OC, LOC, COOD); 
+        set_y_location(para, var, mask, MASK_W, y, v0, i, j, k, OL, OC, LOC, COOD); 
       if(COOD[Z]==1 && LOC[Z]==1)
-        set_z_location(para, var, flagw, gz, w0, i, j, k, OL, OC, LOC, COOD); 
+        set_z_location(para, var, mask, MASK_W, gz, w0, i, j, k, OL, OC, LOC, COOD); 
 
       if(it>itmax) {
-        printf("Error: advection.c can not track the location for VY(%d, %d,%d)",
-                i, j, k);
-        printf("after %d iterations.\n", it);
-        return 1;
+#pragma omp critical
+        {
+          printf("Error: advection.c can not track the location for VZ(%d, %d,%d)",
+                  i, j, k);
+          printf("after %d iterations.\n", it);
+          fail = 1;
+        }
+        break;
       }
     } // End of while() loop
 
@@ -424,58 +675,74 @@ int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     if(w0<0 && LOC[Z]==1) OC[Z] -=1;
 
     /*-------------------------------------------------------------------------
-    | Interpolating for all variables
+    | Store the cell and the relative location for the interpolation
     -------------------------------------------------------------------------*/
-    x_1 = (OL[X]- x[IX(OC[X],OC[Y],OC[Z])])
-        / ( x[IX(OC[X]+1,OC[Y],   OC[Z]  )]- x[IX(OC[X],OC[Y],OC[Z])]); 
-    y_1 = (OL[Y]- y[IX(OC[X],OC[Y],OC[Z])])
-        / ( y[IX(OC[X],  OC[Y]+1, OC[Z]  )]- y[IX(OC[X],OC[Y],OC[Z])]);
-    z_1 = (OL[Z]-gz[IX(OC[X],OC[Y],OC[Z])])
-        / (gz[IX(OC[X],  OC[Y],   OC[Z]+1)]-gz[IX(OC[X],OC[Y],OC[Z])]);
-     d[IX(i,j,k)] = interpolation(para, d0, x_1, y_1, z_1, OC[X], OC[Y], OC[Z]);
+    dp = &t->point[t->start[r]+i-runs->run[r].i1];
+    dp->i = OC[X];
+    dp->j = OC[Y];
+    dp->k = OC[Z];
+    dp->x_1 = (OL[X]-x[OC[X]]) * rdxc[OC[X]];
+    dp->y_1 = (OL[Y]-y[OC[Y]]) * rdyc[OC[Y]];
+    dp->z_1 = (OL[Z]-gz[OC[Z]]) * rdz[OC[Z]+1];
   END_FOR
 
+  if(fail) return 1;
+
+  /*---------------------------------------------------------------------------
+  | Interpolate
+  ---------------------------------------------------------------------------*/
+  if(interpolate_runs(para, runs, t, d0, d)!=0) return 1;
+
   /*---------------------------------------------------------------------------
   | define the b.c.
   ---------------------------------------------------------------------------*/
-  set_bnd(para, var, var_type, 0, d, BINDEX);
+  set_bnd(para, var, var_type, 0, d);
   return 0;
 } // End of trace_vz()
 
 ///////////////////////////////////////////////////////////////////////////////
-/// Advection for scalar variables located in the center of control volume
+/// Find the departure points of the scalar cells
+///
+/// The backward tracing only depends on the velocity, so that the departure
+/// cells and the relative locations in them are stored once after the
+/// velocity was advected and are used for the temperature and all the trace
+/// substances. They are stored for the fluid cells in the order of the runs.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param var_type The type of variable for advection solver
-///\param index Index of trace substances or species
-///\param d Pointer to the computed variables at previous time step
-///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
+///\param var_type The type of variable for the error message
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
-                 REAL *d, REAL *d0, int **BINDEX) {
-  int i, j, k;
-  int it;
+static int set_departure_points(PARA_DATA *para, REAL **var, int var_type) {
+  int i, j, k, r;
+  int it, fail = 0;
   int itmax = 20000; // Max number of iterations for backward tracing 
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL x_1, y_1, z_1;
   REAL dt = para->mytime->dt;
   REAL u0, v0, w0;
-  REAL *x = var[X], *y = var[Y], *z = var[Z]; 
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
+  REAL *z = para->geom->mesh->z;
+  REAL *rdxc = para->geom->mesh->rdxc, *rdyc = para->geom->mesh->rdyc;
+  REAL *rdzc = para->geom->mesh->rdzc;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
-  REAL *flagp = var[FLAGP];
+  RUN_LIST *runs = cell_run(para, MASK_P);
+  CELL_MASK *mask = cell_mask(para);
   int  COOD[3], LOC[3];
   REAL OL[3];
   int  OC[3];
+  DEPARTURE_TABLE *t = &scalar_departure;
+  DEPARTURE_POINT *dp;
+
+  if(runs==NULL || mask==NULL) return 1;
 
-  FOR_EACH_CELL
-    // Do not trace for boundary cells
-    if(flagp[IX(i,j,k)]>=0) continue;
+  if(set_departure_table(t, runs)!=0 || set_nonfluid(para, runs)!=0)
+    return 1;
+
+  // Only the fluid cells are traced
+#pragma omp parallel for private(i, j, k, it, u0, v0, w0, COOD, LOC, OL, OC, dp) schedule(dynamic, ADVECT_CHUNK)
+  FOR_EACH_RUN(runs)
 
     /*-------------------------------------------------------------------------
     | Step 1: Tracing Back
@@ -485,9 +752,9 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
     v0 = (REAL) 0.5 * (v[IX(i,j,k)]+v[IX(i,j-1,k  )]);
     w0 = (REAL) 0.5 * (w[IX(i,j,k)]+w[IX(i,j  ,k-1)]);
     // Find the location at previous time step
-    OL[X] = x[IX(i,j,k)] - u0*dt; 
-    OL[Y] = y[IX(i,j,k)] - v0*dt;
-    OL[Z] = z[IX(i,j,k)] - w0*dt;
+    OL[X] = x[i] - u0*dt; 
+    OL[Y] = y[j] - v0*dt;
+    OL[Z] = z[k] - w0*dt;
     // Initialize the coordinates of previous step
     OC[X] = i; 
     OC[Y] = j; 
@@ -505,24 +772,35 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
     //Initialize the number of iterations
     it=1;
 
+    // Skip the tracing if the path only crosses fluid cells
+    if(locate_departure(para, x, y, z, i, j, k, OL, OC)) {
+      COOD[X] = 0;
+      COOD[Y] = 0;
+      COOD[Z] = 0;
+    }
+
     // Trace back more if the any of the trace is still in process 
     while(COOD[X]==1 || COOD[Y] ==1 || COOD[Z] == 1) {
       it++;
       // If trace in X is in process and donot hit the boundary
       if(COOD[X]==1 && LOC[X]==1)
-        set_x_location(para, var, flagp, x, u0, i, j, k, OL, OC, LOC, COOD);
+        set_x_location(para, var, mask, MASK_P, x, u0, i, j, k, OL, OC, LOC, COOD);
       // If trace in Y is in process and donot hit the boundary
       if(COOD[Y]==1 && LOC[Y]==1)
-        set_y_location(para, var, flagp, y, v0, i, j, k, OL, OC, LOC, COOD);
+        set_y_location(para, var, mask, MASK_P, y, v0, i, j, k, OL, OC, LOC, COOD);
       // If trace in Z is in process and donot hit the boundary
       if(COOD[Z]==1 && LOC[Z]==1)
-        set_z_location(para, var, flagp, z, w0, i, j, k, OL, OC, LOC, COOD); 
+        set_z_location(para, var, mask, MASK_P, z, w0, i, j, k, OL, OC, LOC, COOD); 
       if(it>itmax) {
-        sprintf(msg, "trace_scalar(): Could not track the location for scalar "
-          "variable %d at cell(%d, %d,%d) after %d interations", 
-          var_type, i, j, k, it);
-        ffd_log(msg, FFD_ERROR);
-        return 1;
+#pragma omp critical
+        {
+          sprintf(msg, "set_departure_points(): Could not track the location "
+            "for scalar variable %d at cell(%d, %d,%d) after %d interations",
+            var_type, i, j, k, it);
+          ffd_log(msg, FFD_ERROR);
+          fail = 1;
+        }
+        break;
       }
     } // End of while() for backward tracing
 
@@ -536,26 +814,74 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
     if(v0<0 && LOC[Y]==1) OC[Y] -=1;
     if(w0<0 && LOC[Z]==1) OC[Z] -=1;
 
-    //Store the local minium and maximum values
-    var[LOCMIN][IX(i,j,k)]=check_min(para, d0, OC[X], OC[Y], OC[Z]); 
-    var[LOCMAX][IX(i,j,k)]=check_max(para, d0, OC[X], OC[Y], OC[Z]); 
-
     /*-------------------------------------------------------------------------
-    | Interpolate
+    | Store the cell and the relative location for the interpolation
     -------------------------------------------------------------------------*/
-    x_1 = (OL[X]- x[IX(OC[X],OC[Y],OC[Z])])
-        / ( x[IX(OC[X]+1,OC[Y],   OC[Z]  )] - x[IX(OC[X],OC[Y],OC[Z])]); 
-    y_1 = (OL[Y]- y[IX(OC[X],OC[Y],OC[Z])])
-        / ( y[IX(OC[X],  OC[Y]+1, OC[Z]  )] - y[IX(OC[X],OC[Y],OC[Z])]);
-    z_1 = (OL[Z]- z[IX(OC[X],OC[Y],OC[Z])])
-        / ( z[IX(OC[X],  OC[Y],   OC[Z]+1)] - z[IX(OC[X],OC[Y],OC[Z])]);
-    d[IX(i,j,k)] = interpolation(para, d0, x_1, y_1, z_1, OC[X], OC[Y], OC[Z]);
+    dp = &t->point[t->start[r]+i-runs->run[r].i1];
+    dp->i = OC[X];
+    dp->j = OC[Y];
+    dp->k = OC[Z];
+    dp->x_1 = (OL[X]-x[OC[X]]) * rdxc[OC[X]];
+    dp->y_1 = (OL[Y]-y[OC[Y]]) * rdyc[OC[Y]];
+    dp->z_1 = (OL[Z]-z[OC[Z]]) * rdzc[OC[Z]];
   END_FOR // End of loop for all cells
 
+  if(fail) return 1;
+
+  departure_valid = 1;
+  return 0;
+} // End of set_departure_points()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for scalar variables located in the center of control volume
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param var_type The type of variable for advection solver
+///\param index Index of trace substances or species
+///\param d Pointer to the computed variables at previous time step
+///\param d0 Pointer to the computed variables for current time step
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
+                 REAL *d, REAL *d0) {
+  int i, j, k, r;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  RUN_LIST *runs = cell_run(para, MASK_P);
+  DEPARTURE_TABLE *t = &scalar_departure;
+  DEPARTURE_POINT *dp;
+
+  if(runs==NULL) return 1;
+
+  /*---------------------------------------------------------------------------
+  | Step 1: Tracing back, only once for all the scalars of a time step
+  ---------------------------------------------------------------------------*/
+  if(!departure_valid && set_departure_points(para, var, var_type)!=0)
+    return 1;
+
+  //Store the local minium and maximum values if they are requested
+  if(var[LOCMIN]!=NULL || var[LOCMAX]!=NULL) {
+#pragma omp parallel for private(i, j, k, dp) schedule(static)
+    FOR_EACH_RUN(runs)
+      dp = &t->point[t->start[r]+i-runs->run[r].i1];
+      if(var[LOCMIN]!=NULL)
+        var[LOCMIN][IX(i,j,k)]=check_min(para, d0, dp->i, dp->j, dp->k);
+      if(var[LOCMAX]!=NULL)
+        var[LOCMAX][IX(i,j,k)]=check_max(para, d0, dp->i, dp->j, dp->k);
+    END_FOR
+  }
+
+  /*---------------------------------------------------------------------------
+  | Step 2: Interpolate at the departure points
+  ---------------------------------------------------------------------------*/
+  if(interpolate_runs(para, runs, t, d0, d)!=0) return 1;
+
   /*---------------------------------------------------------------------------
   | Define the b.c.
   ---------------------------------------------------------------------------*/
-  set_bnd(para, var, var_type, index, d, BINDEX);
+  set_bnd(para, var, var_type, index, d);
   return 0;
 } // End of trace_scalar()
 
@@ -568,8 +894,10 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param flag Pointer to the property of the cell
-///\param x Pointer to the current position x(t) of particle
+///\param mask Pointer to the packed cell types
+///\param s Shift of the location in the cell types: MASK_P, MASK_U, MASK_V or
+///         MASK_W
+///\param x Pointer to the 1D coordinates of the cells in X-direction
 ///\param u0 X-velocity at time (t-1) in location x(t) 
 ///\param i I-index for cell at time t at x(t) 
 ///\param j J-index for cell at time t at x(t)
@@ -581,7 +909,8 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
 ///
 ///\return void No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0, 
+void set_x_location(PARA_DATA *para, REAL **var, CELL_MASK *mask, int s,
+                    REAL *x, REAL u0, 
                     int i, int j, int k, 
                     REAL *OL, int *OC, int *LOC, int *COOD) {
   int imax = para->geom->imax, jmax = para->geom->jmax;
@@ -592,25 +921,25 @@ void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0,
   | If the previous location is equal to current position
   | stop the process (COOD[X] = 0) 
   ****************************************************************************/
-  if(OL[X]==x[IX(OC[X],OC[Y],OC[Z])]) 
+  if(OL[X]==x[OC[X]]) 
     COOD[X]=0;
   /****************************************************************************
   | Otherwise, if previous location is on the west of the current position
   ****************************************************************************/
-  else if(OL[X]<x[IX(OC[X],OC[Y],OC[Z])]) {
+  else if(OL[X]<x[OC[X]]) {
     // If donot reach the boundary yet, move to west 
     if(OC[X]>0) 
       OC[X] -=1;
 
     // If the previous position is on the east of new location, stop the process
-    if(OL[X]>=x[IX(OC[X],OC[Y],OC[Z])]) 
+    if(OL[X]>=x[OC[X]]) 
 
       COOD[X]=0; 
 
     // If the new position is solid 
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==1) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==SOLID) {
       // Use the east cell for new location
-      OL[X] = x[IX(OC[X]+1,OC[Y],OC[Z])]; 
+      OL[X] = x[OC[X]+1]; 
       OC[X] +=1;
       // Hit the boundary
       LOC[X] = 0; 
@@ -619,9 +948,10 @@ void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0,
     } // End of if() for solid
 
     // If the new position is inlet or outlet
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==0||flag[IX(OC[X],OC[Y],OC[Z])]==2) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==INLET
+       || CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==OUTLET) {
       // Use new position
-      OL[X] = x[IX(OC[X],OC[Y],OC[Z])];
+      OL[X] = x[OC[X]];
       // use east cell for coordinate
       OC[X] += 1;
       // Hit the boundary
@@ -640,14 +970,14 @@ void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0,
       OC[X] +=1;
 
     // If the previous position is  on the west of new position
-    if(OL[X]<=x[IX(OC[X],OC[Y],OC[Z])]) 
+    if(OL[X]<=x[OC[X]]) 
       // Stop the trace process
       COOD[X]=0;
 
     // If the cell is solid
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==1) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==SOLID) {
       // Use west cell
-      OL[X] = x[IX(OC[X]-1,OC[Y],OC[Z])]; 
+      OL[X] = x[OC[X]-1]; 
       OC[X] -= 1;
       // Hit the boundary
       LOC[X] = 0;
@@ -656,9 +986,10 @@ void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0,
     } // End of if() for solid
 
     // If the new position is inlet or outlet 
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==0||flag[IX(OC[X],OC[Y],OC[Z])]==2) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==INLET
+       || CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==OUTLET) {
       // Use the current cell for previous location
-      OL[X] = x[IX(OC[X],OC[Y],OC[Z])];
+      OL[X] = x[OC[X]];
       // Use the west cell for coordinate
       OC[X] -=1; 
       // Hit the boundary
@@ -678,8 +1009,10 @@ void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0,
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param flag Pointer to the property of the cell
-///\param y Pointer to the current position y(t) of particle
+///\param mask Pointer to the packed cell types
+///\param s Shift of the location in the cell types: MASK_P, MASK_U, MASK_V or
+///         MASK_W
+///\param y Pointer to the 1D coordinates of the cells in Y-direction
 ///\param v0 Y-velocity at time (t-1) in location y(t) 
 ///\param i I-index for cell at time t at y(t) 
 ///\param j J-index for cell at time t at y(t)
@@ -691,7 +1024,8 @@ void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0,
 ///
 ///\return void No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0, 
+void set_y_location(PARA_DATA *para, REAL **var, CELL_MASK *mask, int s,
+                    REAL *y, REAL v0, 
                     int i, int j, int k, 
                     REAL *OL, int *OC, int *LOC, int *COOD) {
   int imax = para->geom->imax, jmax = para->geom->jmax;
@@ -701,25 +1035,25 @@ void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0,
   | If the previous location is equal to current position,
   | stop the process (COOD[X] = 0) 
   ****************************************************************************/
-  if(OL[Y]==y[IX(OC[X],OC[Y],OC[Z])]) 
+  if(OL[Y]==y[OC[Y]]) 
     COOD[Y] = 0;
   /****************************************************************************
   | Otherwise, if previous location is on the south of the current positon
   ****************************************************************************/
-  else if(OL[Y]<y[IX(OC[X],OC[Y],OC[Z])]) {
+  else if(OL[Y]<y[OC[Y]]) {
     // If donot reach the boundary yet
     if(OC[Y]>0) 
       OC[Y] -= 1;
 
     // If the previous position is on the north of new location 
-    if(OL[Y]>=y[IX(OC[X],OC[Y],OC[Z])]) 
+    if(OL[Y]>=y[OC[Y]]) 
       // Stop the process 
       COOD[Y] = 0;
 
     // If the new position is solid 
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==1) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==SOLID) {
       // Use the north cell for new location
-      OL[Y] = y[IX(OC[X],OC[Y]+1,OC[Z])]; 
+      OL[Y] = y[OC[Y]+1]; 
       OC[Y] += 1; 
       // Hit the boundary
       LOC[Y] = 0;
@@ -728,9 +1062,10 @@ void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0,
     } // End of if() for solid
 
     // If the new position is inlet or outlet
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==0||flag[IX(OC[X],OC[Y],OC[Z])]==2) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==INLET
+       || CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==OUTLET) {
       // Use new position
-      OL[Y] = y[IX(OC[X],OC[Y],OC[Z])];
+      OL[Y] = y[OC[Y]];
       // Use north cell for coordinate
       OC[Y] += 1; 
       // Hit the boundary
@@ -749,14 +1084,14 @@ void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0,
       OC[Y] +=1;
 
     // If the previous position is on the south of new position
-    if(OL[Y]<=y[IX(OC[X],OC[Y],OC[Z])]) 
+    if(OL[Y]<=y[OC[Y]]) 
       // Stop the trace process
       COOD[Y] = 0;
 
     // If the cell is solid
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==1) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==SOLID) {
       // Use south cell
-      OL[Y] = y[IX(OC[X],OC[Y]-1,OC[Z])]; 
+      OL[Y] = y[OC[Y]-1]; 
       OC[Y] -= 1;
       // Hit the boundary
       LOC[Y] = 0;
@@ -765,9 +1100,10 @@ void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0,
     } // End of if() for solid
 
     // If the new position is inlet or outlet 
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==0||flag[IX(OC[X],OC[Y],OC[Z])]==2) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==INLET
+       || CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==OUTLET) {
       // Use the current cell for previous location
-      OL[Y] = y[IX(OC[X],OC[Y],OC[Z])];
+      OL[Y] = y[OC[Y]];
       // Use the south cell for coordinate
       OC[Y] -= 1;
       // Hit the boundary
@@ -786,8 +1122,10 @@ void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0,
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param flag Pointer to the property of the cell
-///\param Z Pointer to the current position y(t) of particle
+///\param mask Pointer to the packed cell types
+///\param s Shift of the location in the cell types: MASK_P, MASK_U, MASK_V or
+///         MASK_W
+///\param z Pointer to the 1D coordinates of the cells in Z-direction
 ///\param w0 Z-velocity at time (t-1) in location z(t) 
 ///\param i I-index for cell at time t at z(t) 
 ///\param j J-index for cell at time t at z(t)
@@ -799,7 +1137,8 @@ void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0,
 ///
 ///\return void No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void set_z_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *z, REAL w0,
+void set_z_location(PARA_DATA *para, REAL **var, CELL_MASK *mask, int s,
+                    REAL *z, REAL w0,
                     int i, int j, int k, 
                     REAL *OL, int *OC, int *LOC, int *COOD) {
   int imax = para->geom->imax, jmax = para->geom->jmax;
@@ -810,25 +1149,25 @@ void set_z_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *z, REAL w0,
   | If the previous location is equal to current position,
   | stop the process (COOD[Z] = 0) 
   ****************************************************************************/
-  if(OL[Z]==z[IX(OC[X],OC[Y],OC[Z])]) 
+  if(OL[Z]==z[OC[Z]]) 
     COOD[Z] = 0;
   /****************************************************************************
   | Otherwise, if previous location is on the floor of the current positon
   ****************************************************************************/
-  else if(OL[Z]<z[IX(OC[X],OC[Y],OC[Z])]) {
+  else if(OL[Z]<z[OC[Z]]) {
     // If donot reach the boundary yet
     if(OC[Z]>0) 
       OC[Z] -= 1;
   
     // If the previous position is on the ceiling of new location 
-    if(OL[Z]>=z[IX(OC[X],OC[Y],OC[Z])]) 
+    if(OL[Z]>=z[OC[Z]]) 
       // Stop the process 
       COOD[Z] = 0;
     
     // If the new position is solid 
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==1) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==SOLID) {
       // Use the ceiling cell for new location
-      OL[Z] = z[IX(OC[X],OC[Y],OC[Z]+1)];
+      OL[Z] = z[OC[Z]+1];
       OC[Z] += 1;
       // Hit the boundary
       LOC[Z] = 0;
@@ -837,9 +1176,10 @@ void set_z_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *z, REAL w0,
     } // End of if() for solid
 
     // If the new position is inlet or outlet
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==0||flag[IX(OC[X],OC[Y],OC[Z])]==2) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==INLET
+       || CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==OUTLET) {
       // Use new position
-      OL[Z] = z[IX(OC[X],OC[Y],OC[Z])];
+      OL[Z] = z[OC[Z]];
       // Use ceiling cell for coordinate
       OC[Z] += 1;
       // Hit the boundary
@@ -858,14 +1198,14 @@ void set_z_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *z, REAL w0,
       OC[Z] += 1;
 
     // If the previous position is on the floor of new position
-    if(OL[Z] <=z[IX(OC[X],OC[Y],OC[Z])]) 
+    if(OL[Z] <=z[OC[Z]]) 
       // Stop the trace process
       COOD[Z] = 0;
 
     // If the cell is solid
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==1) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==SOLID) {
       // Use floor cell
-      OL[Z] = z[IX(OC[X],OC[Y],OC[Z]-1)]; 
+      OL[Z] = z[OC[Z]-1]; 
       OC[Z] -= 1;
       // Hit the boundary
       LOC[Z] = 0;
@@ -874,9 +1214,10 @@ void set_z_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *z, REAL w0,
     } // End of if() for solid
 
     // If the new position is inlet or outlet 
-    if(flag[IX(OC[X],OC[Y],OC[Z])]==0||flag[IX(OC[X],OC[Y],OC[Z])]==2) {
+    if(CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==INLET
+       || CELL_TYPE(mask[IX(OC[X],OC[Y],OC[Z])], s)==OUTLET) {
       // Use the current cell for previous location
-      OL[Z]=z[IX(OC[X],OC[Y],OC[Z])];
+      OL[Z]=z[OC[Z]];
       // Use the floor cell for coordinate
       OC[Z] -= 1;
       // Hit the boundary
@@ -885,4 +1226,15 @@ void set_z_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *z, REAL w0,
       COOD[Z]=0;
     } // End of if() for inlet or outlet
   } // End of if() for previous position is on the east of new position
-} // End of set_z_location()
\ No newline at end of file
+} // End of set_z_location()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the departure points
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_advection_data() {
+  free_departure_table(&scalar_departure);
+  free_departure_table(&velocity_departure);
+  departure_valid = 0;
+} // End of free_advection_data()
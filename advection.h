@@ -54,6 +54,20 @@
 #include "solver.h"
 #endif
 
+// Runs of cells in one chunk of the dynamic schedule of the advection loops.
+// The length of the backward tracing varies between the cells, so that the
+// runs are handed out to the threads in small chunks.
+#define ADVECT_CHUNK 8
+
+// Departure points of the fluid cells of one location in the order of the
+// runs, see cell_run()
+typedef struct {
+  DEPARTURE_POINT *point; // Departure points
+  int *start; // Index of the first point of each run
+  int nb_point; // Number of allocated points
+  int nb_start; // Number of allocated run indexes
+}DEPARTURE_TABLE;
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Entrance of advection step
 ///
@@ -66,12 +80,11 @@
 ///\param index Index of trace substances or species
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int advect(PARA_DATA *para, REAL **var, int var_type, int index, 
-           REAL *d, REAL *d0, int **BINDEX);
+           REAL *d, REAL *d0);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Advection for velocity at X-direction
@@ -81,12 +94,10 @@ int advect(PARA_DATA *para, REAL **var, int var_type, int index,
 ///\param var_type The type of variable for advection solver
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
-             int **BINDEX);
+int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Advection for velocity at Y-direction
@@ -96,12 +107,10 @@ int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 ///\param var_type The type of variable for advection solver
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
-             int **BINDEX);
+int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Advection for velocity at Z-direction
@@ -111,12 +120,10 @@ int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 ///\param var_type The type of variable for advection solver
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
-             int **BINDEX);
+int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0);
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -128,12 +135,11 @@ int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 ///\param index Index of trace substances or species
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
-                 REAL *d, REAL *d0, int **BINDEX);
+                 REAL *d, REAL *d0);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Find the X-location and coordinates at previous time step
@@ -143,8 +149,10 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param flag Pointer to the property of the cell
-///\param x Pointer to the current position x(t) of particle
+///\param mask Pointer to the packed cell types
+///\param s Shift of the location in the cell types: MASK_P, MASK_U, MASK_V or
+///         MASK_W
+///\param x Pointer to the 1D coordinates of the cells in X-direction
 ///\param u0 X-velocity at time (t-1) in location x(t) 
 ///\param i I-index for cell at time t at x(t) 
 ///\param j J-index for cell at time t at x(t)
@@ -156,7 +164,8 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
 ///
 ///\return void No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0, 
+void set_x_location(PARA_DATA *para, REAL **var, CELL_MASK *mask, int s,
+                    REAL *x, REAL u0, 
                     int i, int j, int k,  
                     REAL *OL, int *OC, int *LOC , int *COOD);
 
@@ -168,8 +177,10 @@ void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0,
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param flag Pointer to the property of the cell
-///\param y Pointer to the current position y(t) of particle
+///\param mask Pointer to the packed cell types
+///\param s Shift of the location in the cell types: MASK_P, MASK_U, MASK_V or
+///         MASK_W
+///\param y Pointer to the 1D coordinates of the cells in Y-direction
 ///\param v0 Y-velocity at time (t-1) in location y(t) 
 ///\param i I-index for cell at time t at y(t) 
 ///\param j J-index for cell at time t at y(t)
@@ -181,7 +192,8 @@ void set_x_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *x, REAL u0,
 ///
 ///\return void No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0, 
+void set_y_location(PARA_DATA *para, REAL **var, CELL_MASK *mask, int s,
+                    REAL *y, REAL v0, 
                     int i, int j, int k,  
                     REAL *OL, int *OC, int *LOC , int *COOD);
 
@@ -193,8 +205,10 @@ void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0,
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param flag Pointer to the property of the cell
-///\param Z Pointer to the current position y(t) of particle
+///\param mask Pointer to the packed cell types
+///\param s Shift of the location in the cell types: MASK_P, MASK_U, MASK_V or
+///         MASK_W
+///\param z Pointer to the 1D coordinates of the cells in Z-direction
 ///\param w0 Z-velocity at time (t-1) in location z(t) 
 ///\param i I-index for cell at time t at z(t) 
 ///\param j J-index for cell at time t at z(t)
@@ -206,6 +220,14 @@ void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0,
 ///
 ///\return void No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void set_z_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *z, REAL w0, 
+void set_z_location(PARA_DATA *para, REAL **var, CELL_MASK *mask, int s,
+                    REAL *z, REAL w0, 
                     int i, int j, int k, 
-                    REAL *OL, int *OC, int *LOC , int *COOD);
\ No newline at end of file
+                    REAL *OL, int *OC, int *LOC , int *COOD);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the departure points
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_advection_data();
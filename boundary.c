@@ -22,6 +22,20 @@
 
 #include "boundary.h" 
 
+// Offsets from a boundary cell to the cell across each of its faces
+static const int face_di[6] = {1, -1, 0, 0, 0, 0};
+static const int face_dj[6] = {0, 0, 1, -1, 0, 0};
+static const int face_dk[6] = {0, 0, 0, 0, 1, -1};
+
+// Order of the faces in which a cell with several fluid neighbors keeps the
+// value of the last one. The neighbors are visited in the order i+1, i-1,
+// j+1, j-1, k+1, k-1 for temperature and trace and i-1, i+1, j-1, j+1, k-1,
+// k+1 for pressure, as the loops over BINDEX did.
+static const int face_order_up[6] = {FACE_W, FACE_E, FACE_S, FACE_N, FACE_B,
+                                     FACE_F};
+static const int face_order_down[6] = {FACE_E, FACE_W, FACE_N, FACE_S, FACE_F,
+                                       FACE_B};
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Entrance of setting boundary conditions
 ///
@@ -33,40 +47,38 @@
 ///\param var_type The type of variable
 ///\param index Index of trace substances or species
 ///\param psi Pointer to the variable needing the boundary conditions
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd(PARA_DATA *para, REAL **var, int var_type, int index, REAL *psi, 
-            int **BINDEX) {
+int set_bnd(PARA_DATA *para, REAL **var, int var_type, int index, REAL *psi) {
   int flag;
   switch(var_type) {
     case VX:
-      flag = set_bnd_vel(para, var, VX, psi, BINDEX); 
+      flag = set_bnd_vel(para, var, VX, psi); 
       if(flag!=0)
         ffd_log("set_bnd(): Could not set boundary condition for X-velocity.",
                 FFD_ERROR);
       break;
     case VY:
-      flag = set_bnd_vel(para, var, VY, psi, BINDEX); 
+      flag = set_bnd_vel(para, var, VY, psi); 
       if(flag!=0)
         ffd_log("set_bnd(): Could not set boundary condition for Y-velocity.",
                 FFD_ERROR);
       break;
     case VZ:
-      flag = set_bnd_vel(para, var, VZ, psi, BINDEX); 
+      flag = set_bnd_vel(para, var, VZ, psi); 
       if(flag!=0)
         ffd_log("set_bnd(): Could not set boundary condition for Z-velocity.",
                 FFD_ERROR);
       break;
     case TEMP:
-      flag = set_bnd_temp(para, var, TEMP, psi, BINDEX); 
+      flag = set_bnd_temp(para, var, TEMP, psi); 
       if(flag!=0)
         ffd_log("set_bnd(): Could not set boundary condition for temperature.",
                 FFD_ERROR);
       break;
     case TRACE:
-      flag = set_bnd_trace(para, var, index, psi, BINDEX); 
+      flag = set_bnd_trace(para, var, index, psi); 
       if(flag!=0)
         ffd_log("set_bnd(): Could not set boundary condition for trace.",
                 FFD_ERROR);
@@ -83,490 +95,264 @@ int set_bnd(PARA_DATA *para, REAL **var, int var_type, int index, REAL *psi,
 } // End of set_bnd() 
 
 
+///////////////////////////////////////////////////////////////////////////////
+/// Set a fixed velocity in the inlet or solid cells of one group
+///
+/// The velocity of cell c is on its upper face in the direction of the
+/// velocity, the one on its lower face is stored at c-off. Both are set
+/// except the lower one of the cells on the lower side lo of the domain.
+///
+///\param geom Pointer to the geometry data
+///\param g Group of the boundary faces
+///\param psi Pointer to the velocity
+///\param psibc Pointer to the velocity of the inlet, NULL for a solid
+///\param off Offset to the cell on the lower side
+///\param lo Lower face normal to the velocity
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void set_group_vel(GEOM_DATA *geom, int g, REAL *psi, REAL *psibc,
+                          int off, int lo) {
+  int c;
+  int face = g % (FACE_NONE+1);
+  BOUNDARY_CELL *bnd;
+
+  // The cell is on the lower side of the domain
+  if(face==lo) {
+    if(psibc==NULL)
+      FOR_EACH_BCELL(geom, g)
+        psi[bnd->id] = 0;
+      END_FOR
+    else
+      FOR_EACH_BCELL(geom, g)
+        psi[bnd->id] = psibc[bnd->id];
+      END_FOR
+  }
+  // The cell is on the upper side of the domain
+  else if(face==lo+1) {
+    if(psibc==NULL)
+      FOR_EACH_BCELL(geom, g)
+        c = bnd->id;
+        psi[c] = 0;
+        psi[c-off] = 0;
+      END_FOR
+    else
+      FOR_EACH_BCELL(geom, g)
+        c = bnd->id;
+        psi[c] = psibc[c];
+        psi[c-off] = psibc[c];
+      END_FOR
+  }
+  // Other faces, only the edges of the domain have no lower face
+  else {
+    if(psibc==NULL)
+      FOR_EACH_BCELL(geom, g)
+        c = bnd->id;
+        psi[c] = 0;
+        if(!(bnd->sides & 1<<lo)) psi[c-off] = 0;
+      END_FOR
+    else
+      FOR_EACH_BCELL(geom, g)
+        c = bnd->id;
+        psi[c] = psibc[c];
+        if(!(bnd->sides & 1<<lo)) psi[c-off] = psibc[c];
+      END_FOR
+  }
+} // End of set_group_vel()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set zero gradient for the velocity in the outlet cells of one group
+///
+///\param geom Pointer to the geometry data
+///\param g Group of the boundary faces
+///\param psi Pointer to the velocity
+///\param coef Coefficient of the fluid cell on the side of each face
+///\param off Offset to the cell on the lower side
+///\param lo Lower face normal to the velocity
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void set_group_vel_outlet(GEOM_DATA *geom, int g, REAL *psi,
+                                 REAL **coef, int off, int lo) {
+  int nb;
+  int face = g % (FACE_NONE+1);
+  REAL *a;
+  BOUNDARY_CELL *bnd;
+
+  if(face==FACE_NONE) return;
+  a = coef[face];
+
+  // Outflow normal to the face
+  if(face==lo)
+    FOR_EACH_BCELL(geom, g)
+      nb = bnd->nb;
+      psi[bnd->id] = psi[nb];
+      a[nb] = 0;
+    END_FOR
+  else if(face==lo+1)
+    FOR_EACH_BCELL(geom, g)
+      nb = bnd->nb;
+      psi[nb] = psi[nb-off];
+      a[nb-off] = 0;
+    END_FOR
+  // Face parallel to the velocity
+  else
+    FOR_EACH_BCELL(geom, g)
+      a[bnd->nb] = 0;
+    END_FOR
+} // End of set_group_vel_outlet()
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Set boundary conditions for velocity
 ///
+/// The boundary faces are processed by groups of the same type and face in
+/// the order of the table, see set_boundary_cells().
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param var_type The type of variable
 ///\param psi Pointer to the variable needing the boundary conditions
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd_vel(PARA_DATA *para, REAL **var, int var_type, REAL *psi, 
-                int **BINDEX) {
-  int i, j, k;
-  int it;
+int set_bnd_vel(PARA_DATA *para, REAL **var, int var_type, REAL *psi) {
+  int g, off, lo;
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int index= para->geom->index;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
-  REAL *af = var[AF], *ab = var[AB];
-  REAL *flagp = var[FLAGP];
+  REAL *coef[6];
+  REAL *psibc;
+
+  // Coefficient of the fluid cell on the side of each face
+  coef[FACE_W] = var[AW]; coef[FACE_E] = var[AE];
+  coef[FACE_S] = var[AS]; coef[FACE_N] = var[AN];
+  coef[FACE_B] = var[AB]; coef[FACE_F] = var[AF];
 
+  /****************************************************************************
+  | The velocity on the lower side of cell c in its direction is stored at
+  | c-off. The faces lo and lo+1 are normal to the velocity.
+  ****************************************************************************/
   switch(var_type) {
-    /* --------------------------------------------------------------------------
-    | VX
-    -------------------------------------------------------------------------- */
     case VX:
-      for(it=0; it<index; it++) {
-        i = BINDEX[0][it];
-        j = BINDEX[1][it];
-        k = BINDEX[2][it];
-        // Inlet
-        if(flagp[IX(i,j,k)]==0) {
-          psi[IX(i,j,k)] = var[VXBC][IX(i,j,k)];
-          if(i!=0) psi[IX(i-1,j,k)] = var[VXBC][IX(i,j,k)];
-        }
-        // Solid wall
-        if(flagp[IX(i,j,k)]==1) {
-          psi[IX(i,j,k)] = 0;
-          if(i!=0) psi[IX(i-1,j,k)] = 0;
-        }
-        // Outlet
-        if(flagp[IX(i,j,k)]==2) {
-          // West
-          if(i==0) {
-            psi[IX(i,j,k)] = psi[IX(i+1,j,k)]; 
-            aw[IX(i+1,j,k)] = 0;
-          }
-          // East
-          if(i==imax+1) {
-            psi[IX(i-1,j,k)] = psi[IX(i-2,j,k)]; 
-            ae[IX(i-2,j,k)] = 0;
-          }
-          // South
-          if(j==0) as[IX(i,j+1,k)] = 0;
-          // North
-          if(j==jmax+1) an[IX(i,j-1,k)] = 0;
-          // Floor
-          if(k==0) ab[IX(i,j,k+1)] = 0;
-          // Ceiling
-          if(k==kmax+1) af[IX(i,j,k-1)] = 0;
-        }
-      } // End of setting VX
+      psibc = var[VXBC]; off = 1; lo = FACE_W;
       break;
-    /* --------------------------------------------------------------------------
-    | VY
-    -------------------------------------------------------------------------- */
     case VY:
-      for(it=0;it<index;it++) {
-        i = BINDEX[0][it];
-        j = BINDEX[1][it];
-        k = BINDEX[2][it];
-        // Inlet
-        if(flagp[IX(i,j,k)]==0) {
-          psi[IX(i,j,k)] = var[VYBC][IX(i,j,k)];
-          if(j!=0) psi[IX(i,j-1,k)] = var[VYBC][IX(i,j,k)];
-        }
-        // Solid wall
-        if(flagp[IX(i,j,k)]==1) {
-          psi[IX(i,j,k)] = 0;
-          if(j!=0) psi[IX(i,j-1,k)] = 0;
-        }
-        // Outlet
-        if(flagp[IX(i,j,k)]==2) {
-          // West
-          if(i==0) aw[IX(i+1,j,k)]=0;
-          // East
-          if(i==imax+1) ae[IX(i-1,j,k)]=0;
-          // South
-          if(j==0) {
-            as[IX(i,j+1,k)] = 0; 
-            psi[IX(i,j,k)] = psi[IX(i,j+1,k)];
-          }
-          // North
-          if(j==jmax+1) {
-            an[IX(i,j-2,k)] = 0;
-            psi[IX(i,j-1,k)] = psi[IX(i,j-2,k)];
-          }
-          // Floor
-          if(k==0) ab[IX(i,j,k+1)] = 0;
-          if(k==kmax+1) af[IX(i,j,k-1)] = 0;
-        }
-      } // End of setting VY
+      psibc = var[VYBC]; off = IMAX; lo = FACE_S;
       break;
-    /* --------------------------------------------------------------------------
-    | VZ
-    -------------------------------------------------------------------------- */
     case VZ:
-      for(it=0;it<index;it++) {
-        i = BINDEX[0][it];
-        j = BINDEX[1][it];
-        k = BINDEX[2][it];
-        // Inlet
-        if(flagp[IX(i,j,k)]==INLET) {
-          psi[IX(i,j,k)] = var[VZBC][IX(i,j,k)];
-          if(k!=0) psi[IX(i,j,k-1)] = var[VZBC][IX(i,j,k)];
-        }
-        if(flagp[IX(i,j,k)]==SOLID) {
-          psi[IX(i,j,k)] = 0;
-          if(k!=0) psi[IX(i,j,k-1)] = 0;
-        }
-        if(flagp[IX(i,j,k)]==OUTLET) {
-          // West
-          if(i==0) aw[IX(i+1,j,k)] = 0;
-          // East
-          if(i==imax+1) ae[IX(i-1,j,k)] = 0;
-          //South
-          if(j==0) as[IX(i,j+1,k)] = 0;
-          // North
-          if(j==jmax+1) an[IX(i,j-1,k)] = 0;
-          // Floor
-          if(k==0) { 
-            ab[IX(i,j,k+1)] = 0;
-            psi[IX(i,j,k)] = psi[IX(i,j,k+1)];
-          }
-          // Ceiling
-          if(k==kmax+1) { 
-            af[IX(i,j,k-2)] = 0;
-            psi[IX(i,j,k-1)] = psi[IX(i,j,k-2)];
-          }
-        }
-      } // End of setting VZ
+      psibc = var[VZBC]; off = IJMAX; lo = FACE_B;
       break;
-   } // End of switch case
+    default:
+      sprintf(msg, "set_bnd_vel(): Variable type %d is not a velocity.",
+              var_type);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+  }
+
+  for(g=BCELL_GROUP(BND_INLET,0); g<BCELL_GROUP(BND_OUTLET,0); g++)
+    set_group_vel(para->geom, g, psi, psibc, off, lo);
+  for(g=BCELL_GROUP(BND_OUTLET,0); g<BCELL_GROUP(BND_SOLID_T,0); g++)
+    set_group_vel_outlet(para->geom, g, psi, coef, off, lo);
+  for(g=BCELL_GROUP(BND_SOLID_T,0); g<BCELL_NB_GROUP; g++)
+    set_group_vel(para->geom, g, psi, NULL, off, lo);
 
-   return 0;
+  return 0;
 }// End of set_bnd_vel( )
 
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Set the boundary condition for temperature
 ///
+/// An outlet or solid cell with several fluid neighbors keeps the value of
+/// the last of them in the order i+1, i-1, j+1, j-1, k+1, k-1.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param var_type The type of variable
 ///\param psi Pointer to the variable needing the boundary conditions
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
-                 int **BINDEX) {
-  int i, j, k;
-  int it;
-  int index=para->geom->index;
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
-  REAL *af = var[AF], *ab = var[AB], *b=var[B], 
-       *qflux = var[QFLUX], *qfluxbc = var[QFLUXBC];
-  REAL axy, ayz, azx; // Area of surfaces
+int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi) {
+  int g, n, face, c, nb, di, dj, dk;
+  REAL *b = var[B], *qflux = var[QFLUX], *qfluxbc = var[QFLUXBC];
+  REAL *tempbc = var[TEMPBC];
+  REAL *coef[6], *a;
   REAL h;
   REAL rhoCp_1 = 1/ (para->prob->rho * para->prob->Cp);
-  REAL D;
-  REAL *flagp = var[FLAGP];
+  CELL_MASK *mask = cell_mask(para);
+  GEOM_DATA *geom = para->geom;
+  BOUNDARY_CELL *bnd;
+
+  if(mask==NULL) return 1;
+
+  // Coefficient of the fluid cell on the side of each face
+  coef[FACE_W] = var[AW]; coef[FACE_E] = var[AE];
+  coef[FACE_S] = var[AS]; coef[FACE_N] = var[AN];
+  coef[FACE_B] = var[AB]; coef[FACE_F] = var[AF];
 
   /****************************************************************************
-  | Go through all the boundary cells
+  | Inlet boundary
   ****************************************************************************/
-  for(it=0; it<index; it++) {
-    i = BINDEX[0][it];
-    j = BINDEX[1][it];
-    k = BINDEX[2][it];
-    
-    axy = area_xy(para, var, i, j, k);
-    ayz = area_yz(para, var, i, j, k);
-    azx = area_zx(para, var, i, j, k);
+  for(g=BCELL_GROUP(BND_INLET,0); g<BCELL_GROUP(BND_OUTLET,0); g++)
+    FOR_EACH_BCELL(geom, g)
+      psi[bnd->id] = tempbc[bnd->id];
+    END_FOR
 
-    /*-------------------------------------------------------------------------
-    | Inlet boundary
-    | 0: Inlet, -1: Fluid,  1: Solid Wall or Block, 2: Outlet
-    -------------------------------------------------------------------------*/
-    if(flagp[IX(i,j,k)]==INLET) psi[IX(i,j,k)] = var[TEMPBC][IX(i,j,k)];
+  /****************************************************************************
+  | Outlet boundary
+  ****************************************************************************/
+  for(n=0; n<6; n++) {
+    face = face_order_up[n];
+    a = coef[face];
+    FOR_EACH_BCELL(geom, BCELL_GROUP(BND_OUTLET,face))
+      a[bnd->nb] = 0;
+      psi[bnd->id] = psi[bnd->nb];
+    END_FOR
+  }
 
-    /*-------------------------------------------------------------------------
-    | Solid wall or block
-    -------------------------------------------------------------------------*/
-    if(flagp[IX(i,j,k)]==SOLID) {
-      /*......................................................................
-      | Constant temperature
-      ......................................................................*/
-      if(BINDEX[3][it]==1) {
-        psi[IX(i,j,k)] = var[TEMPBC][IX(i,j,k)];
-
-        // West boundary wall and eastern neighbor cell is fluid
-        if(i==0) { 
-          if(flagp[IX(i+1,j,k)]==FLUID) {
-            D = 0.5 * length_x(para,var,i+1,j,k);
-            h = h_coef(para,var,i+1,j,k,D);
-            aw[IX(i+1,j,k)] = h * rhoCp_1 * ayz;
-            qflux[IX(i,j,k)] = h * (psi[IX(i+1,j,k)]-psi[IX(i,j,k)]);
-          }
-        } // End of if(i==0)
-        // East boundary wall and western neigbor cell is fluid
-        else if(i==imax+1) {
-          if(flagp[IX(i-1,j,k)]==FLUID) {
-            D = 0.5 * length_x(para,var,i-1,j,k);
-            h = h_coef(para,var,i-1,j,k,D);
-            ae[IX(i-1,j,k)] = h * rhoCp_1 * ayz;
-            qflux[IX(i,j,k)] = h * (psi[IX(i-1,j,k)]-psi[IX(i,j,k)]);
-          }
-        } // End of else if(i==imax+1)
-        // Between West and East
-        else {
-          // Eastern neighbor cell is fluid
-          if(flagp[IX(i+1,j,k)]==FLUID) {
-            D = 0.5 * length_x(para,var,i+1,j,k);
-            h = h_coef(para,var,i+1,j,k,D);
-            aw[IX(i+1,j,k)] = h * rhoCp_1 * ayz;
-            qflux[IX(i,j,k)] = h * (psi[IX(i+1,j,k)]-psi[IX(i,j,k)]);
-          }
-          // Western neigbor cell is fluid
-          if(flagp[IX(i-1,j,k)]==FLUID) {
-            D = 0.5 * length_x(para,var,i-1,j,k);
-            h = h_coef(para,var,i-1,j,k,D);
-            ae[IX(i-1,j,k)] = h * rhoCp_1 * ayz;
-            qflux[IX(i,j,k)] = h * (psi[IX(i-1,j,k)]-psi[IX(i,j,k)]);
-          }
-        } // End of 0<i<imax+1
-        // South wall boundary and northern neighbor is fluid
-        if(j==0) {
-          if(flagp[IX(i,j+1,k)]==FLUID) {
-            D = 0.5 * length_y(para,var,i,j+1,k);
-            h = h_coef(para,var,i,j+1,k,D);
-            as[IX(i,j+1,k)] = h * rhoCp_1 * azx;
-            qflux[IX(i,j,k)] = h * (psi[IX(i,j+1,k)]-psi[IX(i,j,k)]);
-          }
-        }
-        // North wall boundary and southern neighbor is fluid
-        else if(j==jmax+1) {
-          if(flagp[IX(i,j-1,k)]==FLUID) {
-            D = 0.5 * length_y(para,var,i,j-1,k);
-            h = h_coef(para,var,i,j-1,k,D);
-            an[IX(i,j-1,k)] = h * rhoCp_1 * azx;
-            qflux[IX(i,j,k)] = h * (psi[IX(i,j-1,k)]-psi[IX(i,j,k)]);
-          }
-        }
-        // Between South and North
-        else {
-          // Southern neighbor is fluid
-          if(flagp[IX(i,j-1,k)]==FLUID) {
-            D = 0.5 * length_y(para,var,i,j-1,k);
-            h = h_coef(para,var,i,j-1,k,D);
-            an[IX(i,j-1,k)] = h * rhoCp_1 * azx;
-            qflux[IX(i,j,k)] = h * (psi[IX(i,j-1,k)]-psi[IX(i,j,k)]);
-          }
-          // Northern neighbor is fluid
-          if(flagp[IX(i,j+1,k)]==FLUID) {
-            D = 0.5 * length_y(para,var,i,j+1,k);
-            h = h_coef(para,var,i,j+1,k,D);
-            as[IX(i,j+1,k)] = h * rhoCp_1 * azx;
-            qflux[IX(i,j,k)] = h * (psi[IX(i,j+1,k)]-psi[IX(i,j,k)]);
-          }
-        } 
-        // Floor and ceiling neighbor is fluid
-        if(k==0) {
-          if(flagp[IX(i,j,k+1)]==FLUID) {
-            D = 0.5 * length_z(para,var,i,j,k+1);
-            h = h_coef(para,var,i,j,k+1,D);
-            ab[IX(i,j,k+1)] = h * rhoCp_1 * axy;
-            qflux[IX(i,j,k)] = h * (psi[IX(i,j,k+1)]-psi[IX(i,j,k)]);
-          }
-        }
-        // Ceilling and floor neighbor is fluid
-        else if(k==kmax+1) {
-          if(flagp[IX(i,j,k-1)]==FLUID) {
-            D = 0.5 * length_z(para,var,i,j,k-1);
-            h = h_coef(para,var,i,j,k-1,D);
-            af[IX(i,j,k-1)] = h * rhoCp_1 * axy; 
-            qflux[IX(i,j,k)] = h * (psi[IX(i,j,k-1)]-psi[IX(i,j,k)]);
-          }
-        }
-        // Between Floor and Ceiling
-        else {
-          // Ceiling neighbor is fluid
-          if(flagp[IX(i,j,k+1)]==FLUID) {
-            D = 0.5 * length_z(para,var,i,j,k+1);
-            h = h_coef(para,var,i,j,k+1,D);
-            ab[IX(i,j,k+1)] = h * rhoCp_1 * axy;
-            qflux[IX(i,j,k)] = h * (psi[IX(i,j,k+1)]-psi[IX(i,j,k)]);
-          }
-          // Floor neighbor is fluid
-          if(flagp[IX(i,j,k-1)]==FLUID) {
-            D = 0.5 * length_z(para,var,i,j,k-1);
-            h = h_coef(para,var,i,j,k-1,D);
-            af[IX(i,j,k-1)] = h * rhoCp_1 * axy;
-            qflux[IX(i,j,k)] = h * (psi[IX(i,j,k-1)]-psi[IX(i,j,k)]);
-          }
-        } 
-      } // End of contant temperature wall
-      /*.......................................................................
-      | Constant heat flux
-      .......................................................................*/
-      if(BINDEX[3][it]==0) {
-        // West wall boundary and eastern neighbor is fluid
-        if(i==0) {
-          if(flagp[IX(i+1,j,k)]==FLUID) {
-            aw[IX(i+1,j,k)] = 0;
-            D = 0.5 * length_z(para,var,i+1,j,k);
-            h = h_coef(para,var,i+1,j,k,D);
-            b[IX(i+1,j,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * ayz;
-            // get the temperature of solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i+1,j,k)];
-          }
-        } // End of if(i==0)
-        // East wall bounary and western neighbor is fluid
-        else if(i==imax+1) {
-          if(flagp[IX(i-1,j,k)]==FLUID) { 
-            ae[IX(i-1,j,k)] = 0;
-            D = 0.5 * length_z(para,var,i-1,j,k);
-            h = h_coef(para,var,i-1,j,k,D);
-            b[IX(i-1,j,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * ayz;
-            // get the temperature of solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i-1,j,k)];
-          }
-        } // End of else if(i==imax+1)
-        // Between West and East
-        else {
-          // Eastern neighbor is fluid
-          if(flagp[IX(i+1,j,k)]==FLUID) {
-            aw[IX(i+1,j,k)] = 0; 
-            D = 0.5 * length_z(para,var,i+1,j,k);
-            h = h_coef(para,var,i+1,j,k,D);
-            b[IX(i+1,j,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * ayz;
-            // get the temperature of solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i+1,j,k)];
-          }
-          // Western neighbor is fluid
-          if(flagp[IX(i-1,j,k)]==FLUID) {
-            ae[IX(i-1,j,k)] = 0;
-            D = 0.5 * length_z(para,var,i-1,j,k);
-            h = h_coef(para,var,i-1,j,k,D);
-            b[IX(i-1,j,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * ayz;
-            // get the temperature of solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i-1,j,k)];
-          }
-        } // End of else
-        // South wall boundary and northern neighbor is fluid
-        if(j==0) {
-          if(flagp[IX(i,j+1,k)]==FLUID) {
-            as[IX(i,j+1,k)] = 0;
-            D = 0.5 * length_z(para,var,i,j+1,k);
-            h = h_coef(para,var,i,j+1,k,D);
-            b[IX(i,j+1,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * azx;
-            // get the temperature of solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i,j+1,k)];
-          }
-        } 
-        // North wall boundary and southern neighbor is fluid
-        else if(j==jmax+1) {
-          if(flagp[IX(i,j-1,k)]==FLUID) { 
-            an[IX(i,j-1,k)] = 0;
-            D = 0.5 * length_z(para,var,i,j-1,k);
-            h = h_coef(para,var,i,j-1,k,D);
-            b[IX(i,j-1,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * azx;
-            // get the temperature of solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i,j-1,k)];
-          }
-        }
-        // Between South and North
-        else {
-          // Southern neighbor is fluid
-          if(flagp[IX(i,j-1,k)]==FLUID) { 
-            an[IX(i,j-1,k)] = 0;
-            D = 0.5 * length_z(para,var,i,j-1,k);
-            h = h_coef(para,var,i,j-1,k,D);
-            b[IX(i,j-1,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * azx;
-            // get the temperature of solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i,j-1,k)];
-          }
-          // Northern neighbor is fluid
-          if(flagp[IX(i,j+1,k)]==FLUID) { 
-            as[IX(i,j+1,k)] = 0;
-            D = 0.5 * length_z(para,var,i,j+1,k);
-            h = h_coef(para,var,i,j+1,k,D);
-            b[IX(i,j+1,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * azx;
-            // get the temperature of solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i,j+1,k)];
-          }
-        } 
-        // Floor boundary and ceiling neighbor is fluid
-        if(k==0) {
-          if(flagp[IX(i,j,k+1)]==FLUID) { 
-            ab[IX(i,j,k+1)] = 0;
-            D = 0.5 * length_z(para,var,i,j,k+1);
-            h = h_coef(para,var,i,j,k+1,D);
-            b[IX(i,j,k+1)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * axy;
-            // Get the temperature on the solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i,j,k+1)];
-          }
-        }
-        // Ceiling boundary and floor neighbor is fluid
-        else if(k==kmax+1) {
-          if(flagp[IX(i,j,k-1)]==FLUID) { 
-            af[IX(i,j,k-1)] = 0;
-            D = 0.5 * length_z(para,var,i,j,k-1);
-            h = h_coef(para,var,i,j,k-1,D);
-            b[IX(i,j,k-1)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * axy;
-            // Get the temperature on the solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i,j,k-1)];
-          }
-        }
-        // Between Floor and Ceiling
-        else {
-          // Ceiling neighbor is fluid
-          if(flagp[IX(i,j,k+1)]==FLUID) { 
-            ab[IX(i,j,k+1)] = 0;
-            D = 0.5 * length_z(para,var,i,j,k+1);
-            h = h_coef(para,var,i,j,k+1,D);
-            b[IX(i,j,k+1)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * axy;
-            // Get the temperature on the solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i,j,k+1)];
-          } 
-          // Floor neighbor is fluid
-          if(flagp[IX(i,j,k-1)]==FLUID) { 
-            af[IX(i,j,k-1)] = 0;
-            D = 0.5 * length_z(para,var,i,j,k-1);
-            h = h_coef(para,var,i,j,k-1,D);
-            b[IX(i,j,k-1)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * axy;
-            // Get the temperature on the solid surface
-            psi[IX(i,j,k)] = qfluxbc[IX(i,j,k)]/h + psi[IX(i,j,k-1)];
-          } 
-        } 
-      } // End of constant heat flux
-    } // End of wall boundary
+  /****************************************************************************
+  | Solid wall or block with constant temperature
+  ****************************************************************************/
+  FOR_EACH_BCELL(geom, BCELL_GROUP(BND_SOLID_T,FACE_NONE))
+    psi[bnd->id] = tempbc[bnd->id];
+  END_FOR
+
+  for(n=0; n<6; n++) {
+    face = face_order_up[n];
+    g = BCELL_GROUP(BND_SOLID_T,face);
+    a = coef[face];
+    di = face_di[face]; dj = face_dj[face]; dk = face_dk[face];
+    FOR_EACH_BCELL(geom, g)
+      c = bnd->id;
+      nb = bnd->nb;
+      psi[c] = tempbc[c];
+      // No fluid cell next to the face
+      if(CELL_TYPE(mask[nb], MASK_P)!=FLUID) continue;
+      h = h_coef(para, var, bnd->i+di, bnd->j+dj, bnd->k+dk, bnd->dist);
+      a[nb] = h * rhoCp_1 * bnd->area;
+      qflux[c] = h * (psi[nb]-psi[c]);
+    END_FOR
+  }
 
-    /*-------------------------------------------------------------------------
-    | Outlet boundary
-    -------------------------------------------------------------------------*/
-    if(flagp[IX(i,j,k)]==OUTLET) {
-      // West
-      if(i==0) {
-        aw[IX(i+1,j,k)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i+1,j,k)];
-      }
-      // North
-      if(i==imax+1) {
-        ae[IX(i-1,j,k)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i-1,j,k)];
-      }
-      // South
-      if(j==0) {
-        as[IX(i,j+1,k)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i,j+1,k)];
-      }
-      // North
-      if(j==jmax+1) {
-        an[IX(i,j-1,k)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i,j-1,k)];
-      }
-      // Floor
-      if(k==0) {
-        ab[IX(i,j,k+1)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i,j,k+1)];
-      }
-      // Ceiling
-      if(k==kmax+1) {
-        af[IX(i,j,k-1)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i,j,k-1)];
-      }
-    } // End of boundary for outlet
-  } // End of for() loop for go through the index
+  /****************************************************************************
+  | Solid wall or block with constant heat flux
+  ****************************************************************************/
+  for(n=0; n<6; n++) {
+    face = face_order_up[n];
+    a = coef[face];
+    di = face_di[face]; dj = face_dj[face]; dk = face_dk[face];
+    FOR_EACH_BCELL(geom, BCELL_GROUP(BND_SOLID_Q,face))
+      c = bnd->id;
+      nb = bnd->nb;
+      // No fluid cell next to the face
+      if(CELL_TYPE(mask[nb], MASK_P)!=FLUID) continue;
+      a[nb] = 0;
+      h = h_coef(para, var, bnd->i+di, bnd->j+dj, bnd->k+dk, bnd->dist);
+      b[nb] += rhoCp_1 * qfluxbc[c] * bnd->area;
+      // Get the temperature on the solid surface
+      psi[c] = qfluxbc[c]/h + psi[nb];
+    END_FOR
+  }
 
   return 0;
 } // End of set_bnd_temp()
@@ -574,115 +360,66 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
 ///////////////////////////////////////////////////////////////////////////////
 /// Set the boundary condition for trace substance
 ///
+/// The inlets have the concentration of their port, the outlets and the
+/// solid surfaces next to a fluid cell have zero gradient. A cell with
+/// several fluid neighbors keeps the value of the last of them in the order
+/// i+1, i-1, j+1, j-1, k+1, k-1.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param trace_index Index of the trace substance
 ///\param psi Pointer to the variable needing the boundary conditions
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd_trace(PARA_DATA *para, REAL **var, int trace_index, REAL *psi,
-                 int **BINDEX) {
-  int i, j, k, it, id;
-  int index=para->geom->index;
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
-  REAL *af = var[AF], *ab = var[AB], *b=var[B];
-  REAL *flagp = var[FLAGP];
+int set_bnd_trace(PARA_DATA *para, REAL **var, int trace_index, REAL *psi) {
+  int g, t, n, face;
+  REAL *coef[6], *a;
+  REAL **XiPort = para->bc->XiPort;
+  CELL_MASK *mask = cell_mask(para);
+  GEOM_DATA *geom = para->geom;
+  BOUNDARY_CELL *bnd;
+
+  if(mask==NULL) return 1;
+
+  // Coefficient of the fluid cell on the side of each face
+  coef[FACE_W] = var[AW]; coef[FACE_E] = var[AE];
+  coef[FACE_S] = var[AS]; coef[FACE_N] = var[AN];
+  coef[FACE_B] = var[AB]; coef[FACE_F] = var[AF];
 
   /****************************************************************************
-  | Go through all the boundary cells
+  | Inlet boundary
   ****************************************************************************/
-  for(it=0; it<index; it++) {
-    i = BINDEX[0][it];
-    j = BINDEX[1][it];
-    k = BINDEX[2][it];
+  for(g=BCELL_GROUP(BND_INLET,0); g<BCELL_GROUP(BND_OUTLET,0); g++)
+    FOR_EACH_BCELL(geom, g)
+      psi[bnd->id] = XiPort[bnd->bcid][trace_index];
+    END_FOR
 
-    /*-------------------------------------------------------------------------
-    | Inlet boundary
-    -------------------------------------------------------------------------*/
-    if(flagp[IX(i,j,k)]==INLET) {
-      id = BINDEX[4][it]; 
-      psi[IX(i,j,k)] = para->bc->XiPort[id][trace_index];
-    }
-    /*-------------------------------------------------------------------------
-    | Solid wall or block
-    -------------------------------------------------------------------------*/
-    else if(flagp[IX(i,j,k)]==SOLID) {
-      /*.......................................................................
-      | Neumann B.C.
-      .......................................................................*/
-      // Eastern neighbor is fluid
-      if(i!=imax+1 && flagp[IX(i+1,j,k)]==FLUID) {
-          aw[IX(i+1,j,k)] = 0;
-          psi[IX(i,j,k)] = psi[IX(i+1,j,k)];
-      } 
-      // Western neighbor is fluid
-      if(i=!0 && flagp[IX(i-1,j,k)]==FLUID) { 
-          ae[IX(i-1,j,k)] = 0;
-          psi[IX(i,j,k)] = psi[IX(i-1,j,k)];
-      } 
-      // Northern neighbor is fluid
-      if(j!=jmax+1 && flagp[IX(i,j+1,k)]==FLUID) {
-          as[IX(i,j+1,k)] = 0;
-          psi[IX(i,j,k)] = psi[IX(i,j+1,k)];
-      } 
-      // Southern neighbor is fluid
-      if(j!=0 && flagp[IX(i,j-1,k)]==FLUID) { 
-          an[IX(i,j-1,k)] = 0;
-          psi[IX(i,j,k)] = psi[IX(i,j-1,k)];
-      }
-      // Ceiling neighbor is fluid
-      if(k!=kmax+1 && flagp[IX(i,j,k+1)]==FLUID) { 
-          ab[IX(i,j,k+1)] = 0;
-          psi[IX(i,j,k)] = psi[IX(i,j,k+1)];
-      }
-      // Floor neighbor is fluid
-      if(k==kmax+1 && flagp[IX(i,j,k-1)]==FLUID) { 
-          af[IX(i,j,k-1)] = 0;
-          psi[IX(i,j,k)] = psi[IX(i,j,k-1)];
-      } 
-    } // End of wall boundary
+  /****************************************************************************
+  | Outlet boundary
+  ****************************************************************************/
+  for(n=0; n<6; n++) {
+    face = face_order_up[n];
+    a = coef[face];
+    FOR_EACH_BCELL(geom, BCELL_GROUP(BND_OUTLET,face))
+      a[bnd->nb] = 0;
+      psi[bnd->id] = psi[bnd->nb];
+    END_FOR
+  }
 
-    /*-------------------------------------------------------------------------
-    | Outlet boundary
-    -------------------------------------------------------------------------*/
-    if(flagp[IX(i,j,k)]==OUTLET) {
-      // West
-      if(i==0) {
-        aw[IX(i+1,j,k)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i+1,j,k)];
-      }
-      // North
-      if(i==imax+1) {
-        ae[IX(i-1,j,k)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i-1,j,k)];
-      }
-      // South
-      if(j==0) {
-        as[IX(i,j+1,k)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i,j+1,k)];
-      }
-      // North
-      if(j==jmax+1) {
-        an[IX(i,j-1,k)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i,j-1,k)];
-      }
-      // Floor
-      if(k==0) {
-        ab[IX(i,j,k+1)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i,j,k+1)];
-      }
-      // Ceiling
-      if(k==kmax+1) {
-        af[IX(i,j,k-1)] = 0;
-        psi[IX(i,j,k)] = psi[IX(i,j,k-1)];
-      }
-    } // End of boundary for outlet
-  } // End of for() loop for go through the index
+  /****************************************************************************
+  | Solid wall or block: Neumann B.C. on the faces next to a fluid cell
+  ****************************************************************************/
+  for(t=BND_SOLID_T; t<=BND_SOLID_Q; t++)
+    for(n=0; n<6; n++) {
+      face = face_order_up[n];
+      a = coef[face];
+      FOR_EACH_BCELL(geom, BCELL_GROUP(t,face))
+        if(CELL_TYPE(mask[bnd->nb], MASK_P)!=FLUID) continue;
+        a[bnd->nb] = 0;
+        psi[bnd->id] = psi[bnd->nb];
+      END_FOR
+    }
 
   return 0;
 } // End of set_bnd_trace()
@@ -690,75 +427,40 @@ int set_bnd_trace(PARA_DATA *para, REAL **var, int trace_index, REAL *psi,
 ///////////////////////////////////////////////////////////////////////////////
 /// Set the boundary condition for pressure
 ///
+/// All the boundary cells have zero gradient on their faces next to a fluid
+/// cell. A solid cell with several fluid neighbors takes the pressure of the
+/// last of them in the order i-1, i+1, j-1, j+1, k-1, k+1.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param p Pointer to pressure variable
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd_pressure(PARA_DATA *para, REAL **var, REAL *p, int **BINDEX) {
-  int i, j, k, it;
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int index=para->geom->index;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
-  REAL *af = var[AF], *ab = var[AB];
-
-  REAL *flagp = var[FLAGP];
-
-  for(it=0;it<index;it++) {
-    i = BINDEX[0][it];
-    j = BINDEX[1][it];
-    k = BINDEX[2][it];
-
-    /*-------------------------------------------------------------------------
-    | For X direction
-    -------------------------------------------------------------------------*/
-    if(i>0) { 
-      if(flagp[IX(i-1,j,k)]<0) { 
-        p[IX(i,j,k)] = p[IX(i-1,j,k)];
-        ae[IX(i-1,j,k)] = 0;
-      } 
-    }
-    if(i<imax+1) { 
-      if(flagp[IX(i+1,j,k )]<0) { 
-        p[IX(i,j,k)] = p[IX(i+1,j,k)];
-        aw[IX(i+1,j,k)] = 0;
-      }
+int set_bnd_pressure(PARA_DATA *para, REAL **var, REAL *p) {
+  int t, n, face;
+  REAL *coef[6], *a;
+  CELL_MASK *mask = cell_mask(para);
+  GEOM_DATA *geom = para->geom;
+  BOUNDARY_CELL *bnd;
+
+  if(mask==NULL) return 1;
+
+  // Coefficient of the fluid cell on the side of each face
+  coef[FACE_W] = var[AW]; coef[FACE_E] = var[AE];
+  coef[FACE_S] = var[AS]; coef[FACE_N] = var[AN];
+  coef[FACE_B] = var[AB]; coef[FACE_F] = var[AF];
+
+  for(t=BND_INLET; t<=BND_SOLID_Q; t++)
+    for(n=0; n<6; n++) {
+      face = face_order_down[n];
+      a = coef[face];
+      FOR_EACH_BCELL(geom, BCELL_GROUP(t,face))
+        if(CELL_TYPE(mask[bnd->nb], MASK_P)!=FLUID) continue;
+        p[bnd->id] = p[bnd->nb];
+        a[bnd->nb] = 0;
+      END_FOR
     }
-    /*-------------------------------------------------------------------------
-    | For Y direction
-    -------------------------------------------------------------------------*/
-    if(j>0) { 
-      if(flagp[IX(i,j-1,k)]<0) { 
-        p[IX(i,j,k)] = p[IX(i,j-1,k )];  
-        an[IX(i,j-1,k)] = 0;
-      }
-    } 
-    if(j<jmax+1) { 
-      if(flagp[IX(i,j+1,k)]<0) { 
-        p[IX(i,j,k )] = p[IX(i,j+1,k )];
-        as[IX(i,j+1,k)] = 0;
-      }
-    } 
-    /*-------------------------------------------------------------------------
-    | For Z direction
-    -------------------------------------------------------------------------*/
-    if(k>0) {
-      if(flagp[IX(i,j,k-1)]<0) { 
-        p[IX(i,j,k)] = p[IX(i,j,k-1)];
-        af[IX(i,j,k-1)] = 0; 
-      }
-    }
-    if(k<kmax+1) { 
-      if(flagp[IX(i,j,k+1 )]<0) {
-        p[IX(i,j,k)] = p[IX(i,j,k+1)];   
-        ab[IX(i,j,k+1)] = 0; 
-      } 
-    }
-  }
 
   return 0;
 } // End of set_bnd_pressure()
@@ -773,39 +475,33 @@ int set_bnd_pressure(PARA_DATA *para, REAL **var, REAL *p, int **BINDEX) {
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int mass_conservation(PARA_DATA *para, REAL **var, int **BINDEX) {
-  int i, j, k;
-  int it;
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int index= para->geom->index;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+int mass_conservation(PARA_DATA *para, REAL **var) {
+  int g;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
   REAL dvel;
-  REAL *flagp = var[FLAGP]; 
-  
-  dvel = adjust_velocity(para, var, BINDEX); //(mass_in-mass_out)/area_out
+  GEOM_DATA *geom = para->geom;
+  BOUNDARY_CELL *bnd;
+
+  dvel = adjust_velocity(para, var); //(mass_in-mass_out)/area_out
 
   /*---------------------------------------------------------------------------
   | Adjust the outflow
   ---------------------------------------------------------------------------*/
-  for(it=0;it<index;it++) {
-    i = BINDEX[0][it];
-    j = BINDEX[1][it];
-    k = BINDEX[2][it];
+  for(g=BCELL_GROUP(BND_OUTLET,0); g<BCELL_GROUP(BND_SOLID_T,0); g++) {
     // Fixme: Adding or substracting velocity may cause change in flow direction
-    if(flagp[IX(i,j,k)]==2) {
-      if(i==0) u[IX(i,j,k)] -= dvel;
-      if(i==imax+1) u[IX(i-1,j,k)]+= dvel;
-      if(j==0) v[IX(i,j,k)] -= dvel;
-      if(j==jmax+1) v[IX(i,j-1,k)] += dvel;
-      if(k==0) w[IX(i,j,k)] -= dvel;
-      if(k==kmax+1) w[IX(i,j,k-1)] += dvel;
-    }
+    FOR_EACH_BCELL(geom, g)
+      switch(bnd->face) {
+        case FACE_W: u[bnd->id] -= dvel; break;
+        case FACE_E: u[bnd->nb] += dvel; break;
+        case FACE_S: v[bnd->id] -= dvel; break;
+        case FACE_N: v[bnd->nb] += dvel; break;
+        case FACE_B: w[bnd->id] -= dvel; break;
+        case FACE_F: w[bnd->nb] += dvel; break;
+      }
+    END_FOR
   }
 
   return 0;
@@ -821,90 +517,51 @@ int mass_conservation(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return Mass flow difference divided by the outflow area
 ///////////////////////////////////////////////////////////////////////////////
-REAL adjust_velocity(PARA_DATA *para, REAL **var, int **BINDEX) {
-  int i, j, k;
-  int it;
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int index= para->geom->index;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+REAL adjust_velocity(PARA_DATA *para, REAL **var) {
+  int it, end;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
-  REAL mass_in = (REAL) 0.0, mass_out = (REAL) 0.00000001;
-  REAL area_out=0;
-  REAL *flagp = var[FLAGP];
-  REAL axy, ayz, azx;
-
-  // Go through all the inelt and outlets
-  for(it=0; it<index; it++) {
-    i = BINDEX[0][it];
-    j = BINDEX[1][it];
-    k = BINDEX[2][it];
-
-    axy = area_xy(para, var, i, j, k);
-    ayz = area_yz(para, var, i, j, k);
-    azx = area_zx(para, var, i, j, k);
+  double mass_in = 0.0, mass_out = 0.00000001;
+  double area_out=0;
+  BOUNDARY_CELL *bnd = para->geom->bcell;
+
+  // Go through all the inelt and outlets, they are the first groups
+  end = para->geom->bgroup[BCELL_GROUP(BND_SOLID_T,0)];
+  for(it=0; it<end; it++, bnd++) {
     /*-------------------------------------------------------------------------
     | Compute the total inflow
     -------------------------------------------------------------------------*/
-    if(flagp[IX(i,j,k)]==0) {
-      // West
-      if(i==0) mass_in += u[IX(i,j,k)] * ayz;
-      // East
-      if(i==imax+1) mass_in += (-u[IX(i,j,k)]) * ayz;
-      // South
-      if(j==0) mass_in += v[IX(i,j,k)] * azx;
-      // North
-      if(j==jmax+1) mass_in += (-v[IX(i,j,k)]) * azx;
-      // Floor
-      if(k==0) mass_in += w[IX(i,j,k)] * axy;
-      // Ceiling
-      if(k==kmax+1) mass_in += (-w[IX(i,j,k)]) * axy;
-    }
+    if(bnd->type==INLET)
+      switch(bnd->face) {
+        case FACE_W: mass_in += u[bnd->id] * bnd->area; break;
+        case FACE_E: mass_in += (-u[bnd->id]) * bnd->area; break;
+        case FACE_S: mass_in += v[bnd->id] * bnd->area; break;
+        case FACE_N: mass_in += (-v[bnd->id]) * bnd->area; break;
+        case FACE_B: mass_in += w[bnd->id] * bnd->area; break;
+        case FACE_F: mass_in += (-w[bnd->id]) * bnd->area; break;
+      }
     /*-------------------------------------------------------------------------
     | Compute the total outflow
     -------------------------------------------------------------------------*/
-    if(flagp[IX(i,j,k)]==2) {
-      // West
-      if(i==0) {
-        mass_out += (-u[IX(i,j,k)]) * ayz; 
-        area_out +=  ayz;
-      }
-      // East
-      if(i==imax+1) {
-        mass_out += u[IX(i-1,j,k)] * ayz;
-        area_out += ayz;
-      }
-      // South
-      if(j==0) {
-        mass_out += (-v[IX(i,j,k)]) * azx;
-        area_out += azx;
-      }
-      // North
-      if(j==jmax+1) {
-        mass_out += v[IX(i,j-1,k)] * azx;
-        area_out += azx;
-      }
-      // Floor
-      if(k==0) {
-        mass_out += (-w[IX(i,j,k)]) * axy;
-        area_out += axy;
-      }
-      // Ceiling
-      if(k==kmax+1) {
-        mass_out += w[IX(i,j,k-1)] * axy;
-        area_out += axy;
+    else if(bnd->type==OUTLET) {
+      switch(bnd->face) {
+        case FACE_W: mass_out += (-u[bnd->id]) * bnd->area; break;
+        case FACE_E: mass_out += u[bnd->nb] * bnd->area; break;
+        case FACE_S: mass_out += (-v[bnd->id]) * bnd->area; break;
+        case FACE_N: mass_out += v[bnd->nb] * bnd->area; break;
+        case FACE_B: mass_out += (-w[bnd->id]) * bnd->area; break;
+        case FACE_F: mass_out += w[bnd->nb] * bnd->area; break;
       }
+      area_out += bnd->area;
     } // End of computing outflow
   } // End of for loop for going through all the inlets and outlets
   
   /*---------------------------------------------------------------------------
   | Return the adjusted velocuty for mass conservation
   ---------------------------------------------------------------------------*/
-  return (mass_in-mass_out)/area_out;
+  return (REAL) ((mass_in-mass_out)/area_out);
 } // End of adjust_velocity()
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -922,6 +579,8 @@ REAL adjust_velocity(PARA_DATA *para, REAL **var, int **BINDEX) {
 REAL h_coef(PARA_DATA *para, REAL **var, int i, int j, int k, REAL D) {
   REAL h, kapa; 
   REAL nu = para->prob->nu;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
 
   switch(para->prob->tur_model) {
     case LAM:
@@ -931,7 +590,7 @@ REAL h_coef(PARA_DATA *para, REAL **var, int i, int j, int k, REAL D) {
       kapa = (REAL)101.0 * nu;
       break;
     case CHEN:
-      kapa = nu + nu_t_chen_zero_equ(para, var, i, j, k);
+      kapa = nu + var[NUT][IX(i,j,k)];
       break;
     default:
       sprintf(msg, "h_coef(): Value (%d) for para->prob->tur_model"
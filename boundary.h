@@ -55,12 +55,10 @@
 ///\param var_type The type of variable
 ///\param index Index of trace substances or species
 ///\param psi Pointer to the variable needing the boundary conditions
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd(PARA_DATA *para, REAL **var, int var_type, int index, REAL *psi, 
-            int **BINDEX) ;
+int set_bnd(PARA_DATA *para, REAL **var, int var_type, int index, REAL *psi) ;
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Set boundary conditions for velocity
@@ -69,12 +67,10 @@ int set_bnd(PARA_DATA *para, REAL **var, int var_type, int index, REAL *psi,
 ///\param var Pointer to FFD simulation variables
 ///\param var_type The type of variable
 ///\param psi Pointer to the variable needing the boundary conditions
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd_vel(PARA_DATA *para, REAL **var, int var_type, REAL *vx, 
-                int **BINDEX);
+int set_bnd_vel(PARA_DATA *para, REAL **var, int var_type, REAL *vx);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Set the boundary condition for temperature
@@ -83,12 +79,10 @@ int set_bnd_vel(PARA_DATA *para, REAL **var, int var_type, REAL *vx,
 ///\param var Pointer to FFD simulation variables
 ///\param var_type The type of variable
 ///\param psi Pointer to the variable needing the boundary conditions
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
-                 int **BINDEX);
+int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Set the boundary condition for trace substance
@@ -97,12 +91,10 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
 ///\param var Pointer to FFD simulation variables
 ///\param trace_index Index of the trace substance
 ///\param psi Pointer to the variable needing the boundary conditions
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd_trace(PARA_DATA *para, REAL **var, int trace_index, REAL *psi,
-                 int **BINDEX);
+int set_bnd_trace(PARA_DATA *para, REAL **var, int trace_index, REAL *psi);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Set the boundary condition for pressure
@@ -110,11 +102,10 @@ int set_bnd_trace(PARA_DATA *para, REAL **var, int trace_index, REAL *psi,
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param p Pointer to pressure variable
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int set_bnd_pressure(PARA_DATA *para, REAL **var, REAL *p,int **BINDEX);
+int set_bnd_pressure(PARA_DATA *para, REAL **var, REAL *p);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Enforce the mass conservation by adjusting the outlet flow rate
@@ -126,11 +117,10 @@ int set_bnd_pressure(PARA_DATA *para, REAL **var, REAL *p,int **BINDEX);
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int mass_conservation(PARA_DATA *para, REAL **var, int **BINDEX);
+int mass_conservation(PARA_DATA *para, REAL **var);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Get the mass flow difference divided by outflow area 
@@ -142,11 +132,10 @@ int mass_conservation(PARA_DATA *para, REAL **var, int **BINDEX);
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return Mass flow difference divided by the outflow area
 ///////////////////////////////////////////////////////////////////////////////
-REAL adjust_velocity(PARA_DATA *para, REAL **var, int **BINDEX);
+REAL adjust_velocity(PARA_DATA *para, REAL **var);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate convective hrat transfer coefficient
@@ -22,6 +22,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 /// Computes turbulent viscosity using Chen's zero equation model
 ///
+/// The wall distance must have been set by set_wall_distance().
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
@@ -31,31 +33,152 @@
 ///\return Turbulent Kinematic viscosity
 ///////////////////////////////////////////////////////////////////////////////
 REAL nu_t_chen_zero_equ(PARA_DATA *para, REAL **var, int i, int j, int k) {
-  REAL nu_t, l, lx, lx1, lx2, ly, ly1, ly2, lz, lz1, lz2;
-  REAL *x = var[X], *y = var[Y], *z = var[Z];
-  REAL *u = var[VX], *v = var[VY], *w = var[Z];
-  int imax = para->geom->imax, jmax = para->geom->jmax,
-      kmax = para->geom->kmax;
+  REAL *u = var[VX], *v = var[VY], *w = var[VZ];
+  int imax = para->geom->imax, jmax = para->geom->jmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  
-  lx1 = x[IX(i,j,k)] - x[IX(0,j,k)];
-  lx2 = x[IX(imax+1,j,k)] - x[IX(i,j,k)];
-  lx = lx1 < lx2 ? lx1 : lx2;
-
-  ly1 = y[IX(i,j,k)] - y[IX(i,0,k)];
-  ly2 = y[IX(i,jmax,k)] - y[IX(i,j,k)];
-  ly = ly1 < ly2 ? ly1 : ly2;
-
-  lz1 = z[IX(i,j,k)] - z[IX(i,j,0)];
-  lz2 = z[IX(i,j,kmax+1)] - z[IX(i,j,k)];
-  lz = lz1 < lz2 ? lz1 : lz2;
-
-  l = lx < ly ? lx : ly;
-  l = lz < l ? lz : l;
-  nu_t = para->prob->chen_a * l
+
+  return para->prob->chen_a * var[WDIST][IX(i,j,k)]
        * (REAL)sqrt( u[IX(i,j,k)]*u[IX(i,j,k)]
                     +v[IX(i,j,k)]*v[IX(i,j,k)]
                     +w[IX(i,j,k)]*w[IX(i,j,k)] );
+} // End of nu_t_chen_zero_equ()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Reduce the wall distance of the cells on one grid line
+///
+/// The line has the cells 0 to n+1 at p0, p0+stride, ... of the variables.
+/// The cells 0 and n+1 are the boundaries of the domain. A cell that is not
+/// fluid is a wall whose faces are the cell surfaces g[] around it.
+///
+///\param mask Pointer to the packed cell types
+///\param dist Pointer to the wall distance
+///\param p0 Index of cell 0 of the line
+///\param stride Distance between the indices of two neighboring cells
+///\param n Number of interior cells of the line
+///\param c Pointer to the cell centers of the line
+///\param g Pointer to the cell surfaces of the line
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void set_line_distance(CELL_MASK *mask, REAL *dist, int p0,
+                              int stride, int n, REAL *c, REAL *g) {
+  int i, p;
+  REAL wall, l;
+
+  // Distance to the closest wall at the lower side
+  wall = g[0];
+  for(i=1; i<=n; i++) {
+    p = p0 + i*stride;
+    if(!IS_FLUID(mask[p], MASK_P))
+      wall = g[i];
+    else {
+      l = c[i] - wall;
+      if(l<dist[p]) dist[p] = l;
+    }
+  }
+
+  // Distance to the closest wall at the upper side
+  wall = g[n];
+  for(i=n; i>=1; i--) {
+    p = p0 + i*stride;
+    if(!IS_FLUID(mask[p], MASK_P))
+      wall = g[i-1];
+    else {
+      l = wall - c[i];
+      if(l<dist[p]) dist[p] = l;
+    }
+  }
+} // End of set_line_distance()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the distance of the cells to the nearest wall
+///
+/// The length scale of the model is the smallest distance to a wall in the
+/// X, Y and Z directions. The walls are the boundaries of the domain and
+/// the cells that are not fluid, so that internal blocks are taken into
+/// account. The distance is obtained by one sweep in each direction along
+/// every grid line. It only depends on the geometry and is calculated once
+/// before the simulation. The distance of the cells that are not fluid is 0.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_wall_distance(PARA_DATA *para, REAL **var) {
+  int i, j, k;
+  int imax = para->geom->imax, jmax = para->geom->jmax,
+      kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  MESH_DATA *mesh = para->geom->mesh;
+  CELL_MASK *mask = cell_mask(para);
+  REAL *dist, lmax;
+
+  if(mask==NULL) return 1;
+
+  dist = require_field(var, WDIST);
+  if(dist==NULL) {
+    ffd_log("set_wall_distance(): Could not allocate memory for the wall "
+            "distance.", FFD_ERROR);
+    return 1;
+  }
+
+  // Longer than any distance in the domain
+  lmax = mesh->x[imax+1] + mesh->y[jmax+1] + mesh->z[kmax+1];
+  FOR_ALL_CELL
+    if(i<1 || i>imax || j<1 || j>jmax || k<1 || k>kmax
+       || !IS_FLUID(mask[IX(i,j,k)], MASK_P))
+      dist[IX(i,j,k)] = 0;
+    else
+      dist[IX(i,j,k)] = lmax;
+  END_FOR
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      set_line_distance(mask, dist, IX(0,j,k), 1, imax, mesh->x, mesh->gx);
+
+  for(k=1; k<=kmax; k++)
+    for(i=1; i<=imax; i++)
+      set_line_distance(mask, dist, IX(i,0,k), IMAX, jmax, mesh->y,
+                        mesh->gy);
+
+  for(j=1; j<=jmax; j++)
+    for(i=1; i<=imax; i++)
+      set_line_distance(mask, dist, IX(i,j,0), IJMAX, kmax, mesh->z,
+                        mesh->gz);
+
+  return 0;
+} // End of set_wall_distance()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the turbulent viscosity of all the cells
+///
+/// The turbulent viscosity is calculated once per time step from the
+/// velocities at the beginning of the step and used by the diffusion of
+/// the velocities and by the convective heat transfer at the walls. The
+/// wall distance must have been set by set_wall_distance().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_nu_t_chen_zero_equ(PARA_DATA *para, REAL **var) {
+  int i, j, k;
+  int imax = para->geom->imax, jmax = para->geom->jmax,
+      kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  REAL *nut = require_field(var, NUT);
+
+  if(nut==NULL) {
+    ffd_log("set_nu_t_chen_zero_equ(): Could not allocate memory for the "
+            "turbulent viscosity.", FFD_ERROR);
+    return 1;
+  }
+
+  FOR_EACH_CELL
+    nut[IX(i,j,k)] = nu_t_chen_zero_equ(para, var, i, j, k);
+  END_FOR
 
-  return nu_t;
-} // End of nu_t_chen_zero_equ()
\ No newline at end of file
+  return 0;
+} // End of set_nu_t_chen_zero_equ()
@@ -26,9 +26,16 @@
 #include "data_structure.h"
 #endif
 
+#ifndef _UTILITY_H
+#define _UTILITY_H
+#include "utility.h"
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Computes turbulent viscosity using Chen's zero equation model
 ///
+/// The wall distance must have been set by set_wall_distance().
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
@@ -38,3 +45,25 @@
 ///\return Turbulent Kinematic viscosity
 ///////////////////////////////////////////////////////////////////////////////
 REAL nu_t_chen_zero_equ(PARA_DATA *para, REAL **var, int i, int j, int k);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the distance of the cells to the nearest wall
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_wall_distance(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the turbulent viscosity of all the cells
+///
+/// The wall distance must have been set by set_wall_distance().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_nu_t_chen_zero_equ(PARA_DATA *para, REAL **var);
@@ -256,6 +256,17 @@ int read_cosim_data(PARA_DATA *para, REAL **var, int **BINDEX) {
   else
     ffd_log("\tNo fluid ports.", FFD_NORMAL);
 
+  /****************************************************************************
+  | The types of the boundary cells may have changed, so that the boundary
+  | faces of the packed cell types and the table of boundary faces are built
+  | again
+  ****************************************************************************/
+  if(set_cell_mask(para)!=0 || set_boundary_cells(para, BINDEX)!=0) {
+    ffd_log("read_cosim_data(): Could not update the boundary cells.",
+            FFD_ERROR);
+    return 1;
+  }
+
   /****************************************************************************
   | Post-Process after reading the data
   ****************************************************************************/
@@ -307,7 +318,8 @@ int write_cosim_data(PARA_DATA *para, REAL **var) {
   | Set the time and space averaged temperature of space
   | Convert T from degC to K
   ****************************************************************************/
-  para->cosim->ffd->TRoo = average_volume(para, var, var[TEMPM]); 
+  if(require_field(var, TEMPM)==NULL) return 1;
+  para->cosim->ffd->TRoo = average_volume(para, var[TEMPM]); 
   sprintf(msg, "\tAveraged room temperature %f[degC]", para->cosim->ffd->TRoo);
   para->cosim->ffd->TRoo += 273.15;
   ffd_log(msg, FFD_NORMAL);
@@ -523,7 +535,8 @@ int compare_boundary_names(PARA_DATA *para) {
 ///////////////////////////////////////////////////////////////////////////////
 int compare_boundary_area(PARA_DATA *para, REAL **var, int **BINDEX) {
   int i, j;
-  REAL *A0 = para->bc->AWall, *A1 = para->cosim->para->are;
+  REAL *A0 = para->bc->AWall;
+  float *A1 = para->cosim->para->are;
 
   ffd_log("compare_boundary_area(): "
           "Start to compare the area of solid surfaces.",
@@ -562,6 +575,9 @@ int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL *temHea;
+  CELL_MASK *mask = cell_mask(para);
+
+  if(mask==NULL) return 1;
 
   /****************************************************************************
   | Assign the boundary conditon if there is a solid surface
@@ -612,7 +628,7 @@ int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
       id = BINDEX[4][it];
       modelicaId = para->bc->wallId[id];
 
-      if(var[FLAGP][IX(i,j,k)]==SOLID) 
+      if(CELL_TYPE(mask[IX(i,j,k)], MASK_P)==SOLID) 
         switch(para->cosim->para->bouCon[modelicaId]) {
           case 1: 
             // Need to convert the T from K to degC
@@ -620,6 +636,7 @@ int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
             BINDEX[3][it] = 1; // Specified temperature
             break;
           case 2:
+            if(require_field(var, QFLUXBC)==NULL) return 1;
             var[QFLUXBC][IX(i,j,k)] = temHea[id];
             BINDEX[3][it] = 0; // Specified heat flux 
             break;
@@ -654,7 +671,8 @@ int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
 /// boundry condition accordingly. The inlet or outlet boundary is decided 
 /// according to the flow rate para->cosim->modelica->mFloRarPor. The port is
 /// inlet if mFloRarPor>0 and outlet if mFloRarPor<0. We will need to reset the 
-/// var[FLAGP][IX(i,j,k)] to apply the change of boundary conditions.
+/// the type of the pressure cell in para->geom->mask to apply the change of
+/// boundary conditions.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to the FFD simulaiton variables
@@ -667,6 +685,9 @@ int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  CELL_MASK *mask = cell_mask(para);
+
+  if(mask==NULL) return 1;
 
   ffd_log("assign_port_bc():", FFD_NORMAL);
 
@@ -713,9 +734,10 @@ int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
     k = BINDEX[2][it];
     id = BINDEX[4][it];
 
-    if(var[FLAGP][IX(i,j,k)]==INLET || var[FLAGP][IX(i,j,k)]==OUTLET) {
+    if(CELL_TYPE(mask[IX(i,j,k)], MASK_P)==INLET
+       || CELL_TYPE(mask[IX(i,j,k)], MASK_P)==OUTLET) {
       if(para->bc->velPort[id]>=0) {
-        var[FLAGP][IX(i,j,k)] = INLET;
+        SET_CELL_TYPE(mask[IX(i,j,k)], INLET, MASK_P);
         var[TEMPBC][IX(i,j,k)] = para->bc->TPort[id];
         if(i==0)
           var[VXBC][IX(i,j,k)] = para->bc->velPort[id];
@@ -734,7 +756,7 @@ int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
       }
       // Set it to outlet if flow out of room
       else
-        var[FLAGP][IX(i,j,k)] = OUTLET;
+        SET_CELL_TYPE(mask[IX(i,j,k)], OUTLET, MASK_P);
     }
   }
    
@@ -755,16 +777,14 @@ int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to the boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int surface_integrate(PARA_DATA *para, REAL **var, int **BINDEX) {
-  int imax = para->geom->imax, jmax = para->geom->jmax; 
-  int kmax = para->geom->kmax;
-  int i, j, k, it, bcid;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+int surface_integrate(PARA_DATA *para, REAL **var) {
+  int i, j, it, c, bcid;
+  int nb_bcell = para->geom->nb_bcell;
   REAL vel_tmp, A_tmp; 
+  BOUNDARY_CELL *bnd = para->geom->bcell;
 
   /****************************************************************************
   | Set the variable to 0
@@ -776,76 +796,69 @@ int surface_integrate(PARA_DATA *para, REAL **var, int **BINDEX) {
     para->bc->TPortAve[i] = 0;
     para->bc->velPortAve[i] = 0;
     for(j=0; j<para->bc->nb_Xi; j++)
-      para->bc->XiPortAve[i] = 0;
+      para->bc->XiPortAve[i][j] = 0;
     for(j=0; j<para->bc->nb_C; j++)
-      para->bc->CPortAve[i] = 0;
+      para->bc->CPortAve[i][j] = 0;
   }
 
   /****************************************************************************
-  | Go through all the boundary cells
+  | Go through all the boundary faces
   ****************************************************************************/
-  for(it=0; it<para->geom->index; it++) {
-    i = BINDEX[0][it];
-    j = BINDEX[1][it];
-    k = BINDEX[2][it];
-    bcid = BINDEX[4][it];
-
-    if(i==0 || i==imax+1) {
-      vel_tmp = var[VX][IX(i,j,k)];
-      A_tmp = area_yz(para, var, i, j, k);
-    }
-    else if(j==0 || j==jmax+1) {
-      vel_tmp = var[VY][IX(i,j,k)];
-      A_tmp = area_zx(para, var, i, j, k);
-    }
-    else if(k==0 || k==kmax+1) {
-      vel_tmp = var[VZ][IX(i,j,k)];
-      A_tmp = area_xy(para, var, i, j, k);
-    }
+  for(it=0; it<nb_bcell; it++, bnd++) {
+    c = bnd->id;
+    bcid = bnd->bcid;
+    // Faces without area or cells not belonging to a boundary
+    if(bnd->face==FACE_NONE || bcid<0) continue;
+
+    if(bnd->face==FACE_W || bnd->face==FACE_E)
+      vel_tmp = var[VX][c];
+    else if(bnd->face==FACE_S || bnd->face==FACE_N)
+      vel_tmp = var[VY][c];
+    else
+      vel_tmp = var[VZ][c];
+    A_tmp = bnd->area;
 
     /*-------------------------------------------------------------------------
     | Set the thermal conditions data for Modelica.
-    | In FFD simulation, the BINDEX[3][it] indicates: 1->T, 0->Heat Flux.
-    | Those BINDEX[3][it] will be reset according to the Modelica data 
+    | In FFD simulation, the therm of a solid face indicates: 1->T, 0->Heat 
+    | Flux. It is reset according to the Modelica data 
     | para->comsim->para->bouCon (1->Heat Flux, 2->T). 
     | Here is to give the Modelica the missing data (For instance, if Modelica 
     | send FFD Temperature, FFD should then send Modelica Heat Flux).
     -------------------------------------------------------------------------*/
-    if(var[FLAGP][IX(i,j,k)]==SOLID) {
-      switch(BINDEX[3][it]) {
+    if(bnd->type==SOLID) {
+      switch(bnd->therm) {
         // FFD uses heat flux as BC to compute temperature
         // Then send Modelica the tempearture
         case 0: 
-          para->bc->temHeaAve[bcid] += var[TEMP][IX(i,j,k)] * A_tmp 
-                                     / para->bc->AWall[i];
+          para->bc->temHeaAve[bcid] += var[TEMP][c] * A_tmp 
+                                     / para->bc->AWall[bcid];
           break;
         // FFD uses temperature as BC to compute heat flux
         // Then send Modelica the heat flux
         case 1: 
-          para->bc->temHeaAve[bcid] += var[QFLUX][IX(i,j,k)]*A_tmp;
-          //sprintf(msg, "Cell(%d,%d,%d):\tQFLUX=%f,\tA=%f", i,j,k,var[QFLUX][IX(i,j,k)], A_tmp);
-          //ffd_log(msg, FFD_NORMAL);
+          para->bc->temHeaAve[bcid] += var[QFLUX][c]*A_tmp;
           break;
         default:
           sprintf(msg, "average_bc_area(): Thermal boundary (%d)"
                  "for cell (%d,%d,%d) was not defined",
-                 BINDEX[3][it], i, j, k);
+                 bnd->therm, bnd->i, bnd->j, bnd->k);
           ffd_log(msg, FFD_ERROR);
           return 1;
       }
     }
-    else if(var[FLAGP][IX(i,j,k)]==INLET||var[FLAGP][IX(i,j,k)]==OUTLET) {
-      para->bc->TPortAve[bcid] += var[TEMP][IX(i,j,k)] * A_tmp * vel_tmp;
+    else if(bnd->type==INLET||bnd->type==OUTLET) {
+      para->bc->TPortAve[bcid] += var[TEMP][c] * A_tmp * vel_tmp;
       para->bc->velPortAve[bcid] += vel_tmp * A_tmp;
       // To be implemented
       /*
       for(j=0; j<para->bc->nb_Xi; j++)
-        para->bc->XiPortAve[bcid][j] += xi[j][IX(i,j,k)] * A_tmp * vel_tmp;
+        para->bc->XiPortAve[bcid][j] += xi[j][c] * A_tmp * vel_tmp;
       for(j=0, j<para->bc->nb_C; j++)
-        para->bc->CPortAve[bcid][j] = c[j][IX(i,j,k)] * A_tmp * vel_tmp;
+        para->bc->CPortAve[bcid][j] = c[j][c] * A_tmp * vel_tmp;
         */
     }
-  } // End of for(it=0; it<para->geom->index; it++)
+  } // End of for(it=0; it<nb_bcell; it++)
 
 //  for(i=0; i<para->bc->nb_wall; i++) {
 //    sprintf(msg, "%s: para->bc->temHeaAve = %f", para->bc->wallName[i], para->bc->temHeaAve[i]);
@@ -109,7 +109,8 @@ int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX);
 /// boundry condition accordingly. The inlet or outlet boundary is decided 
 /// according to the flow rate para->cosim->modelica->mFloRarPor. The port is
 /// inlet if mFloRarPor>0 and outlet if mFloRarPor<0. We will need to reset the 
-/// var[FLAGP][IX(i,j,k)] to apply the change of boundary conditions.
+/// the type of the pressure cell in para->geom->mask to apply the change of
+/// boundary conditions.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to the FFD simulaiton variables
@@ -132,11 +133,10 @@ int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX);
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to the boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int surface_integrate(PARA_DATA *para, REAL **var, int **BINDEX);
+int surface_integrate(PARA_DATA *para, REAL **var);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Set sensor data
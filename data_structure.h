@@ -45,18 +45,64 @@ Place the stdlib.h line above the glut.h line in the code.
 #include "glut.h"
 
 #define IX(i,j,k) ((i)+(IMAX)*(j)+(IJMAX)*(k))
-#define FOR_EACH_CELL for(i=1; i<=imax; i++) { for(j=1; j<=jmax; j++) { for(k=1; k<=kmax; k++) {
+// Index of the summed volume table of a mesh with imax*jmax*kmax cells, one
+// more entry than IX() in each direction
+#define SVT(i,j,k,imax,jmax) ((i)+((imax)+3)*((j)+((jmax)+3)*(k)))
+// The loops run k-j-i so that the innermost index i has unit stride in IX()
+#define FOR_EACH_CELL for(k=1; k<=kmax; k++) { for(j=1; j<=jmax; j++) { for(i=1; i<=imax; i++) {
 #define FOR_ALL_CELL for(k=0; k<=kmax+1; k++) { for(j=0; j<=jmax+1; j++) { for(i=0; i<=imax+1; i++) {
 #define FOR_U_CELL for(k=1; k<=kmax; k++) { for(j=1; j<=jmax; j++) { for(i=1; i<=imax-1; i++) {
-#define FOR_V_CELL for(i=1; i<=imax; i++) { for(j=1; j<=jmax-1; j++) { for(k=1; k<=kmax; k++) {
-#define FOR_W_CELL for(i=1; i<=imax; i++) { for(j=1; j<=jmax; j++) { for(k=1; k<=kmax-1; k++) {
+#define FOR_V_CELL for(k=1; k<=kmax; k++) { for(j=1; j<=jmax-1; j++) { for(i=1; i<=imax; i++) {
+#define FOR_W_CELL for(k=1; k<=kmax-1; k++) { for(j=1; j<=jmax; j++) { for(i=1; i<=imax; i++) {
 
-#define FOR_KI for(i=1; i<=imax; i++) { for(k=1; k<=kmax; k++) {{
-#define FOR_IJ for(i=1; i<=imax; i++) { for(j=1; j<=jmax; j++) {{
-#define FOR_JK for(j=1; j<=jmax; j++) { for(k=1; k<=kmax; k++) {{
+#define FOR_KI for(k=1; k<=kmax; k++) { for(i=1; i<=imax; i++) {{
+#define FOR_IJ for(j=1; j<=jmax; j++) { for(i=1; i<=imax; i++) {{
+#define FOR_JK for(k=1; k<=kmax; k++) { for(j=1; j<=jmax; j++) {{
 #define END_FOR }}}
 
+// Cache blocking for the stencil kernels: the cells are visited in slabs of
+// FFD_TILE rows in j, each slab from k=1 to kmax, so that the planes k-1, k
+// and k+1 of the slab stay in the cache. The rows in i are not split.
+// Compile with -DFFD_TILE=n to enable it; needs an int jj for the slab.
+#ifndef FFD_TILE
+#define FFD_TILE 0
+#endif
+#define TILE_J (FFD_TILE>0 ? FFD_TILE : jmax)
+#define FOR_EACH_CELL_TILED for(jj=1; jj<=jmax; jj+=TILE_J) { for(k=1; k<=kmax; k++) { for(j=jj; j<jj+TILE_J && j<=jmax; j++) { for(i=1; i<=imax; i++) {{
+#define END_FOR_TILED }}}}}
+
+// Loop over the cells in a list of runs, needs an int r for the run index
+#define FOR_EACH_RUN(list) for(r=0; r<(list)->nb_run; r++) { j = (list)->run[r].j; k = (list)->run[r].k; for(i=(list)->run[r].i1; i<=(list)->run[r].i2; i++) {{
+
+// Loop over the faces of group g of the boundary table, needs a BOUNDARY_CELL
+// pointer bnd for the face
+#define FOR_EACH_BCELL(geom,g) for(bnd=(geom)->bcell+(geom)->bgroup[g]; bnd<(geom)->bcell+(geom)->bgroup[(g)+1]; bnd++) {{{
+
+// Precision of the variables: float by default, double if FFD_DOUBLE is
+// defined. Sums over cells or time steps are always accumulated in double.
+#ifdef FFD_DOUBLE
+#define REAL double
+#define REAL_FMT "%lf" // Format of scanf() for REAL
+#else
 #define REAL float
+#define REAL_FMT "%f" // Format of scanf() for REAL
+#endif
+
+// Packed cell types: the low byte of the mask of a cell holds two bits for
+// each location. The bits are CELLTYPE+1 of the pressure, U, V and W cells,
+// so that the bits of U, V and W are the types of the east, north and front
+// faces of the cell. The high byte holds one bit for each FACETYPE of a cell
+// that is not fluid, see set_cell_mask().
+#define MASK_P 0 // Shift of the bits of the pressure cell
+#define MASK_U 2 // Shift of the bits of the U-velocity cell
+#define MASK_V 4 // Shift of the bits of the V-velocity cell
+#define MASK_W 6 // Shift of the bits of the W-velocity cell
+#define MASK_FACE 8 // Shift of the bits of the boundary faces
+#define CELL_TYPE(m,s) ((int)(((m)>>(s))&3)-1) // CELLTYPE of a location
+#define IS_FLUID(m,s) (((m)&(3<<(s)))==0) // The location is solved
+#define CELL_CODE(t,s) ((CELL_MASK) (((t)+1)<<(s))) // Bits of a CELLTYPE
+#define SET_CELL_TYPE(m,t,s) ((m) = (CELL_MASK) (((m)&~(3<<(s)))|CELL_CODE(t,s)))
+#define FACE_BIT(f) ((CELL_MASK) (1<<(MASK_FACE+(f)))) // Bit of a FACETYPE
 
 #define SMALL 0.00001
 
@@ -64,8 +110,13 @@ Place the stdlib.h line above the glut.h line in the code.
 	#define max( a, b ) ( ((a) > (b)) ? (a) : (b) )
 #endif
 
+#ifndef min
+	#define min( a, b ) ( ((a) < (b)) ? (a) : (b) )
+#endif
+
 #define PI 3.1415926
 
+// X, Y, Z, GX, GY and GZ are not allocated, see MESH_DATA
 #define X     0
 #define Y     1
 #define Z     2
@@ -100,6 +151,8 @@ Place the stdlib.h line above the glut.h line in the code.
 #define GZ    31
 #define AP0   32
 #define PP    33
+// The cell types are not allocated but kept in para->geom->mask, see
+// CELL_TYPE(). The indices are only used for the names of the columns.
 #define FLAGP 34
 #define FLAGU 35
 #define FLAGV 36
@@ -110,8 +163,26 @@ Place the stdlib.h line above the glut.h line in the code.
 #define VYBC 41
 #define VZBC 42
 #define TEMPBC 43
-
-#define TRACE 44
+#define GPE   44 // Area/distance of east face of pressure cell
+#define GPN   45 // Area/distance of north face of pressure cell
+#define GPF   46 // Area/distance of front face of pressure cell
+#define VOLP  47 // Volume of pressure cell
+#define GUE   48 // Area/distance of east face of U-velocity cell
+#define GUN   49 // Area/distance of north face of U-velocity cell
+#define GUF   50 // Area/distance of front face of U-velocity cell
+#define VOLU  51 // Volume of U-velocity cell
+#define GVE   52 // Area/distance of east face of V-velocity cell
+#define GVN   53 // Area/distance of north face of V-velocity cell
+#define GVF   54 // Area/distance of front face of V-velocity cell
+#define VOLV  55 // Volume of V-velocity cell
+#define GWE   56 // Area/distance of east face of W-velocity cell
+#define GWN   57 // Area/distance of north face of W-velocity cell
+#define GWF   58 // Area/distance of front face of W-velocity cell
+#define VOLW  59 // Volume of W-velocity cell
+#define NUT   60 // Turbulent kinematic viscosity
+#define WDIST 61 // Distance to the nearest wall
+
+#define TRACE 62
 
 typedef enum{NOSLIP, SLIP, INFLOW, OUTFLOW, PERIODIC, SYMMETRY} BCTYPE;
 
@@ -119,7 +190,22 @@ typedef enum{SOLID=1, INLET=0, OUTLET=2, FLUID=-1} CELLTYPE;
 
 typedef enum{TCONST, QCONST, ADIBATIC} BCTTYPE;
 
-typedef enum{GS, TDMA} SOLVERTYPE;
+// Side of a boundary face seen from the cell across it, e.g. FACE_W if the
+// boundary cell (i,j,k) is west of the cell (i+1,j,k)
+typedef enum{FACE_W, FACE_E, FACE_S, FACE_N, FACE_B, FACE_F, FACE_NONE} FACETYPE;
+
+// Types of the groups of boundary faces: inlets, outlets, solids with fixed
+// temperature and solids with fixed heat flux
+typedef enum{BND_INLET, BND_OUTLET, BND_SOLID_T, BND_SOLID_Q} BNDTYPE;
+
+#define BCELL_GROUP(t,f) ((t)*(FACE_NONE+1)+(f)) // Group of a BNDTYPE and face
+#define BCELL_NB_GROUP BCELL_GROUP(BND_SOLID_Q+1,0) // Number of groups
+
+typedef enum{GS, TDMA, MG, GS_RB, PCG, CHOL} SOLVERTYPE;
+
+typedef enum{VCYCLE=1, WCYCLE=2} MGCYCLE;
+
+typedef enum{IC, SSOR} PRECONDITIONER;
 
 typedef enum{SEMI, LAX, UPWIND, UPWIND_NEW} ADVECTION;
 
@@ -133,6 +219,49 @@ typedef enum{FFD, SCI, TECPLOT} FILE_FORMAT;
 
 typedef enum{FFD_WARNING, FFD_ERROR, FFD_NORMAL, FFD_NEW} FFD_MSG_TYPE;
 
+// Packed cell types and boundary faces of one cell, see CELL_TYPE()
+typedef unsigned short CELL_MASK;
+
+// Consecutive cells (i1..i2,j,k) in X-direction
+typedef struct {
+  int i1; // First i of the run
+  int i2; // Last i of the run
+  int j;
+  int k;
+}CELL_RUN;
+
+// Runs of the cells that are solved at one location
+typedef struct {
+  int nb_run; // Number of runs
+  CELL_RUN *run; // Runs sorted by k, j and i
+  int *plane; // Runs plane[k] to plane[k+1]-1 are in the k-plane
+}RUN_LIST;
+
+// Face of a boundary cell. A cell on the domain boundary has one entry for
+// each of its sides on the boundary, an internal solid cell one entry for each
+// fluid neighbor or a single entry with FACE_NONE if it has none.
+typedef struct {
+  int id; // Index IX(i,j,k) of the boundary cell
+  int i, j, k;
+  int face; // FACETYPE of the face
+  int sides; // Bits 1<<FACETYPE of the sides of the cell on the domain boundary
+  int nb; // Index of the cell across the face, -1 for FACE_NONE
+  int type; // CELLTYPE of the boundary cell
+  int therm; // Solid: 1 fixed temperature, 0 fixed heat flux; otherwise -1
+  int bcid; // Boundary ID as in BINDEX[4]
+  REAL area; // Area of the face
+  REAL dist; // Distance from the face to the center of the cell nb
+}BOUNDARY_CELL;
+
+// Coordinates of a structured mesh as 1D arrays in each direction,
+// e.g. x[i] for cells (i,j,k) with 0<=i<=imax+1
+typedef struct {
+  REAL *x, *y, *z; // Cell centers, 0 at index 0 and L at index max+1
+  REAL *gx, *gy, *gz; // Cell surfaces, gx[i] is the east surface of cell i
+  REAL *dx, *dy, *dz; // Cell lengths, dx[i]=gx[i]-gx[i-1] and dx[0]=0
+  REAL *rdx, *rdy, *rdz; // 1/dx[i], 0 if dx[i]=0
+  REAL *rdxc, *rdyc, *rdzc; // 1/(x[i+1]-x[i]), 0 for the last cell
+}MESH_DATA;
 
 // Parameter for geometry and mesh
 typedef struct {
@@ -208,6 +337,15 @@ typedef struct {
   REAL  z2;
   REAL  z3;
   REAL  z4;
+
+  RUN_LIST *run; // Internal: runs of fluid cells of P, U, V, W, see cell_run()
+  int *nonfluid; // Internal: summed volume table of the cells that are not fluid
+  RUN_LIST *nonfluid_run; // Internal: runs whose location nonfluid belongs to
+  CELL_MASK *mask; // Internal: cell types and boundary faces of the cells
+  MESH_DATA *mesh; // Internal: 1D coordinates of cells and cell surfaces
+  BOUNDARY_CELL *bcell; // Internal: boundary faces sorted by type and face
+  int nb_bcell; // Internal: number of entries in bcell
+  int bgroup[BCELL_NB_GROUP+1]; // Internal: group g is bcell[bgroup[g]] to bcell[bgroup[g+1]-1]
 } GEOM_DATA;
 
 typedef struct{
@@ -284,20 +422,20 @@ typedef struct {
   REAL *APort; // APort[nb_port]: Area of the outlets
   REAL *temHea; // temHea[nb_wall]: Value of thermal conditions at solid surface
   REAL *temHeaAve; // temHeaAve[nb_wall]: Surface averaged value of temHea
-  REAL *temHeaMean; // temHeaMean[nb_wall]: Time averaged value of temHeaAve
+  double *temHeaMean; // temHeaMean[nb_wall]: Time averaged value of temHeaAve
   REAL *velPort; // velPort[nb_port]: Velocity of air into the room
                       // positive: into the room; neative out of the room
   REAL *velPortAve; // velPortAve[nb_port]: Surface averaged value of velPort
-  REAL *velPortMean; // velPortMean[nb_port]: Time averaged value of velPortAve
+  double *velPortMean; // velPortMean[nb_port]: Time averaged value of velPortAve
   REAL *TPort; // TPort[nb_port] Air temperatures that the medium has if it were flowing into the room
   REAL *TPortAve; // TPortAve[nb_port] Surface averaged value of TPort
-  REAL *TPortMean; // TPortMean[nb_port] Time averaged value of TPortAve
+  double *TPortMean; // TPortMean[nb_port] Time averaged value of TPortAve
   REAL **XiPort; // XiPor[nb_port][nb_Xi]: species concentration of inflowing medium
   REAL **XiPortAve; // XiPortAve[nb_port][nb_Xi]: Surface averaged value of XiPort
-  REAL **XiPortMean; // XiPortAve[nb_port][nb_Xi]: Time averaged value of XiPortAve
+  double **XiPortMean; // XiPortAve[nb_port][nb_Xi]: Time averaged value of XiPortAve
   REAL **CPort; // CPor[nb_port][nb_C]: the trace substances of the inflowing medium
   REAL **CPortAve; // CPortAve[nb_port][nb_C]: Surface averaged value of CPort
-  REAL **CPortMean; // CPortMean[nb_port][nb_C]: Time averaged value of CPort
+  double **CPortMean; // CPortMean[nb_port][nb_C]: Time averaged value of CPort
 }BC_DATA;
 
 typedef struct {
@@ -305,9 +443,9 @@ typedef struct {
   char **sensorName; // *sensorName[nb_sensor]: Name of sensor in FFD
   int **senIndex; // senIndex[nb_sensor][3]: i, j, k Index of sensors
   REAL *senVal; // senVal[nb_sensor]: Instanteniate valeu of sensor point
-  REAL *senValMean; // snValMean[nb_sensor]: Time averaged value of senVal;
+  double *senValMean; // snValMean[nb_sensor]: Time averaged value of senVal;
   REAL TRoo; // Volumed averaged value of temperature in the space
-  REAL TRooMean; // Time averaged value of TRoo;
+  double TRooMean; // Time averaged value of TRoo;
 } SENSOR_DATA;
 
 typedef struct {
@@ -317,17 +455,42 @@ typedef struct {
   int step_total; // The interval of iteration step to output data
   int step_current; // Internal: current iteration step
   int step_mean; // Internal: steps for time average
+  double t_mean; // Internal: time for time average
+  int dt_adapt; // 0: fixed dt; 1: dt adapted to cfl_max and dif_max
+  REAL cfl_max; // Maximum CFL number of the adaptive time step
+  REAL dif_max; // Maximum diffusion number of the adaptive time step
+  double dt_min; // Minimum adaptive time step size
+  double dt_max; // Maximum adaptive time step size, 0: no limit
   clock_t t_start; // Internal: clock time when simulation starts
   clock_t t_end; // Internal: clock time when simulaiton ends
 }TIME_DATA;
 
 typedef struct {
-  SOLVERTYPE solver;  // Solver type: GS, TDMA
+  SOLVERTYPE solver;  // Solver type: GS, TDMA, MG, GS_RB, PCG, CHOL
   int check_residual; // 1: check, 0: donot check
+  // The tolerances are the relative change of a sweep sum|ap*dx|/sum|ap*x|
+  // for GS, GS_RB and TDMA, and the relative L2 norm of the residual for MG
+  // and PCG. A tolerance of 0 gives the fixed number of sweeps of GS, GS_RB
+  // and TDMA and the default tolerance of MG and PCG.
+  REAL p_tol; // Tolerance of pressure solver, 0: default of solver
+  int p_max_iter; // Maximum iterations (cycles for MG) of pressure solver, 0: default of solver
+  REAL vel_tol; // Tolerance for velocity, 0: fixed sweeps
+  int vel_max_iter; // Maximum iterations for velocity, 0: default of solver
+  REAL temp_tol; // Tolerance for temperature, 0: fixed sweeps
+  int temp_max_iter; // Maximum iterations for temperature, 0: default of solver
+  REAL trace_tol; // Tolerance for trace substances, 0: fixed sweeps
+  int trace_max_iter; // Maximum iterations for trace substances, 0: default of solver
+  MGCYCLE mg_cycle; // Cycle of multigrid solver: VCYCLE, WCYCLE
+  PRECONDITIONER pcg_precond; // Preconditioner of PCG solver: IC, SSOR
+  int fft_p; // 1: solve pressure by FFT for empty box on uniform grid, 0: no
+  int p_extrap; // Initial pressure extrapolated from previous steps, 0: no, 1: linear, 2: quadratic
+  int stencil; // Coefficients of Gauss-Seidel solvers, 0: separate arrays, 1: interleaved
   ADVECTION advection_solver; // Tyep of advection solver: SEMI, LAX, UPWIND, UPWIND_NEW 
   INTERPOLATION interpolation; // Internploation in semi-Lagrangian method: BILINEAR, FSJ, HYBRID
   int cosimulation;  // 0: single; 1: cosimulation
   int nextstep; // Internal: 1: yes; 0: no, wait
+  REAL residual; // Internal: residual of the last solved equation
+  int iter; // Internal: iterations (sweeps for GS) of the last solved equation
 }SOLV_DATA;
 
 typedef struct {
@@ -33,11 +33,12 @@ int write_tecplot_data(PARA_DATA *para, REAL **var, char *name) {
   int imax=para->geom->imax, jmax=para->geom->jmax;
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *x = var[X], *y = var[Y], *z =var[Z];
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
+  REAL *z = para->geom->mesh->z;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ], *p = var[IP];
   REAL *d = var[TRACE];
   REAL *T = var[TEMP];
-  REAL *flagp = var[FLAGP];
+  CELL_MASK *mask = cell_mask(para);
   char *filename;
   FILE *datafile;
 
@@ -46,6 +47,8 @@ int write_tecplot_data(PARA_DATA *para, REAL **var, char *name) {
   | Length of filename should be sizeof(ActualName) + 1
   | Using sizeof(ActualName) will cause memory fault in free(filename)
   ****************************************************************************/
+  if(mask==NULL) return 1;
+
   filename = (char *) malloc((strlen(name)+5)*sizeof(char));
   if(filename==NULL) {
     ffd_log("write_tecplot_data(): Failed to allocate memory for file name", 
@@ -77,10 +80,10 @@ int write_tecplot_data(PARA_DATA *para, REAL **var, char *name) {
  
   FOR_ALL_CELL
     fprintf(datafile, "%f\t%f\t%f\t%d\t%d\t%d\t",
-       x[IX(i,j,k)], y[IX(i,j,k)], z[IX(i,j,k)], i, j, k);    
+       x[i], y[j], z[k], i, j, k);    
     fprintf(datafile, "%f\t%f\t%f\t%f\t%f\t%f\n",
             u[IX(i,j,k)], v[IX(i,j,k)], w[IX(i,j,k)], T[IX(i,j,k)],
-            flagp[IX(i,j,k)], p[IX(i,j,k)]);    
+            (REAL) CELL_TYPE(mask[IX(i,j,k)], MASK_P), p[IX(i,j,k)]);    
   END_FOR
 
   sprintf(msg, "write_tecplot_data(): Wrote file %s.", filename);
@@ -105,10 +108,14 @@ int write_tecplot_all_data(PARA_DATA *para, REAL **var, char *name) {
   int imax=para->geom->imax, jmax=para->geom->jmax;
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *x = var[X], *y = var[Y], *z =var[Z];
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
+  REAL *z = para->geom->mesh->z;
+  CELL_MASK *mask = cell_mask(para);
   char *filename;
   FILE *dataFile;
 
+  if(mask==NULL) return 1;
+
   /****************************************************************************
   | Allocate memory for filename
   | Length of filename should be sizeof(ActualName) + 1
@@ -124,6 +131,16 @@ int write_tecplot_all_data(PARA_DATA *para, REAL **var, char *name) {
   strcpy(filename, name);
   strcat(filename, ".plt");
 
+  // Write 0 for the optional variables that were not used
+  if(require_field(var, VXM)==NULL || require_field(var, VYM)==NULL
+     || require_field(var, VZM)==NULL || require_field(var, VXS)==NULL
+     || require_field(var, VYS)==NULL || require_field(var, VZS)==NULL
+     || require_field(var, TEMPM)==NULL || require_field(var, TEMPS)==NULL
+     || require_field(var, QFLUXBC)==NULL) {
+    free(filename);
+    return 1;
+  }
+
   // Open output file
   if((dataFile=fopen(filename,"w"))==NULL) {
     sprintf(msg, "write_tecplot_data(): Failed to open output file %s.", filename);
@@ -157,7 +174,7 @@ int write_tecplot_all_data(PARA_DATA *para, REAL **var, char *name) {
   FOR_ALL_CELL
     // Coordinates
     fprintf(dataFile, "%f\t%f\t%f\t%d\t%d\t%d\t",
-            x[IX(i,j,k)], y[IX(i,j,k)], z[IX(i,j,k)], i, j, k);
+            x[i], y[j], z[k], i, j, k);
     // Velocities
     fprintf(dataFile, "%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\t", 
             var[VX][IX(i,j,k)], var[VY][IX(i,j,k)], var[VZ][IX(i,j,k)], 
@@ -169,13 +186,15 @@ int write_tecplot_all_data(PARA_DATA *para, REAL **var, char *name) {
     fprintf(dataFile, "%f\t%f\t%f\t",
             var[TEMP][IX(i,j,k)], var[TEMPM][IX(i,j,k)], 
             var[TEMPS][IX(i,j,k)]);
-    // Gravity
-    fprintf(dataFile, "%f\t%f\t%f\t",
-            var[GX][IX(i,j,k)], var[GY][IX(i,j,k)], var[GZ][IX(i,j,k)]);
+    // Coordinates of cell surfaces
+    fprintf(dataFile, "%f\t%f\t%f\t", para->geom->mesh->gx[i],
+            para->geom->mesh->gy[j], para->geom->mesh->gz[k]);
     // Flags for simulaiton
     fprintf(dataFile, "%f\t%f\t%f\t%f\t",
-            var[FLAGU][IX(i,j,k)], var[FLAGV][IX(i,j,k)], 
-            var[FLAGW][IX(i,j,k)], var[FLAGP][IX(i,j,k)]);
+            (REAL) CELL_TYPE(mask[IX(i,j,k)], MASK_U),
+            (REAL) CELL_TYPE(mask[IX(i,j,k)], MASK_V),
+            (REAL) CELL_TYPE(mask[IX(i,j,k)], MASK_W),
+            (REAL) CELL_TYPE(mask[IX(i,j,k)], MASK_P));
     // Boundary conditions
     fprintf(dataFile, "%f\t%f\t%f\t%f\t",
             var[VXBC][IX(i,j,k)], var[VYBC][IX(i,j,k)], 
@@ -213,11 +232,6 @@ int write_tecplot_all_data(PARA_DATA *para, REAL **var, char *name) {
 ///\return no return
 ///////////////////////////////////////////////////////////////////////////////
 void convert_to_tecplot(PARA_DATA *para, REAL **var) {
-  int i, j, k;
-  int imax=para->geom->imax;
-  int jmax=para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
   REAL *um = var[VXM], *vm = var[VYM], *wm = var[VZM];
   REAL *p = var[IP], *d = var[TRACE];
@@ -226,35 +240,13 @@ void convert_to_tecplot(PARA_DATA *para, REAL **var) {
   /****************************************************************************
   | Convert velocities 
   ****************************************************************************/
-  for(j=0; j<=jmax+1; j++)
-    for(k=0; k<=kmax+1; k++) {
-      u[IX(imax+1,j,k)] = u[IX(imax,j,k)];
-      um[IX(imax+1,j,k)] = um[IX(imax,j,k)];
-      for(i=imax; i>=1; i--) {
-        u[IX(i,j,k)] = (REAL) (0.5 * (u[IX(i,j,k)]+u[IX(i-1,j,k)]));
-        um[IX(i,j,k)] = (REAL) (0.5 * (um[IX(i,j,k)]+um[IX(i-1,j,k)]));
-      }
-    }
-
-  for(i=0; i<=imax+1; i++)
-    for(k=0; k<=kmax+1; k++) {
-      v[IX(i,jmax+1,k)] = v[IX(i,jmax,k)];
-      vm[IX(i,jmax+1,k)] = vm[IX(i,jmax,k)];  
-      for(j=jmax; j>=1; j--) {
-        v[IX(i,j,k)] = (REAL) (0.5 * (v[IX(i,j,k)]+v[IX(i,j-1,k)]));
-        vm[IX(i,j,k)] = (REAL) (0.5 * (vm[IX(i,j,k)]+vm[IX(i,j-1,k)]));
-      }
-    }
-
-  for(i=0; i<=imax+1; i++)
-    for(j=0; j<=jmax+1; j++) {
-      w[IX(i,j,kmax+1)] = w[IX(i,j,kmax)];
-      wm[IX(i,j,kmax+1)] = wm[IX(i,j,kmax)];  
-      for(k=kmax; k>=1; k--) {
-        w[IX(i,j,k)] = (REAL) (0.5 * (w[IX(i,j,k)]+w[IX(i,j,k-1)]));
-        wm[IX(i,j,k)] = (REAL) (0.5 * (wm[IX(i,j,k)]+wm[IX(i,j,k-1)]));
-      }
-    }
+  convert_to_center(para, u, X);
+  convert_to_center(para, v, Y);
+  convert_to_center(para, w, Z);
+  // The means are only allocated if they were calculated
+  if(um!=NULL) convert_to_center(para, um, X);
+  if(vm!=NULL) convert_to_center(para, vm, Y);
+  if(wm!=NULL) convert_to_center(para, wm, Z);
 
   /****************************************************************************
   | Convert variables at corners
@@ -262,9 +254,58 @@ void convert_to_tecplot(PARA_DATA *para, REAL **var) {
   convert_to_tecplot_corners(para, var, p);
   convert_to_tecplot_corners(para, var, d);
   convert_to_tecplot_corners(para, var, T);
-  convert_to_tecplot_corners(para, var, Tm);
+  if(Tm!=NULL) convert_to_tecplot_corners(para, var, Tm);
 } // End of convert_to_tecplot()
 
+///////////////////////////////////////////////////////////////////////////////
+/// Convert a velocity from the cell surfaces to the cell centers
+///
+/// The value at the center is the mean of the values at the two surfaces of
+/// the cell in the direction of the velocity. The last cell keeps the value
+/// of the last surface.
+///
+///\param para Pointer to FFD parameters
+///\param psi Pointer to variable to be converted
+///\param dir Direction of the velocity: X, Y or Z
+///
+///\return no return
+///////////////////////////////////////////////////////////////////////////////
+void convert_to_center(PARA_DATA *para, REAL *psi, int dir) {
+  int i, j, k;
+  int imax=para->geom->imax, jmax=para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+
+  switch(dir) {
+    case X:
+      for(k=0; k<=kmax+1; k++)
+        for(j=0; j<=jmax+1; j++) {
+          psi[IX(imax+1,j,k)] = psi[IX(imax,j,k)];
+          for(i=imax; i>=1; i--)
+            psi[IX(i,j,k)] = (REAL) (0.5 * (psi[IX(i,j,k)]+psi[IX(i-1,j,k)]));
+        }
+      break;
+    case Y:
+      for(k=0; k<=kmax+1; k++) {
+        for(i=0; i<=imax+1; i++)
+          psi[IX(i,jmax+1,k)] = psi[IX(i,jmax,k)];
+        for(j=jmax; j>=1; j--)
+          for(i=0; i<=imax+1; i++)
+            psi[IX(i,j,k)] = (REAL) (0.5 * (psi[IX(i,j,k)]+psi[IX(i,j-1,k)]));
+      }
+      break;
+    case Z:
+      for(j=0; j<=jmax+1; j++)
+        for(i=0; i<=imax+1; i++)
+          psi[IX(i,j,kmax+1)] = psi[IX(i,j,kmax)];
+      for(k=kmax; k>=1; k--)
+        for(j=0; j<=jmax+1; j++)
+          for(i=0; i<=imax+1; i++)
+            psi[IX(i,j,k)] = (REAL) (0.5 * (psi[IX(i,j,k)]+psi[IX(i,j,k-1)]));
+      break;
+  }
+} // End of convert_to_center()
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Convert the data at 8 corners to the format for Tecplot 
 ///
@@ -378,7 +419,8 @@ int write_SCI(PARA_DATA *para, REAL **var, char *name) {
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   int n = para->mytime->step_current;
-  REAL *x = var[X], *y = var[Y], *z =var[Z];
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
+  REAL *z = para->geom->mesh->z;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ], *p = var[IP];
   REAL *um = var[VXM], *vm = var[VYM], *wm = var[VZM], *d = var[TRACE];
   REAL *T = var[TEMP], *Tm = var[TEMPM];
@@ -429,38 +471,12 @@ int write_SCI(PARA_DATA *para, REAL **var, char *name) {
   /****************************************************************************
   | Convert varaible value from cell surface to cell center
   ****************************************************************************/
-  for(j=0; j<=jmax+1; j++) {
-    for(k=0; k<=kmax+1; k++) {
-      u[IX(imax+1,j,k)] = u[IX(imax,j,k)];
-      um[IX(imax+1,j,k)] = um[IX(imax,j,k)];
-      for(i=imax; i>=1; i--) {
-        u[IX(i,j,k)] = (REAL) 0.5 * (u[IX(i,j,k)]+u[IX(i-1,j,k)]);
-        um[IX(i,j,k)] = (REAL) 0.5 * (um[IX(i,j,k)]+um[IX(i-1,j,k)]);
-      }
-    }
-  }
-
-  for(i=0; i<=imax+1; i++) {
-    for(k=0; k<=kmax+1; k++) {
-      v[IX(i,jmax+1,k)] = v[IX(i,jmax,k)];
-      vm[IX(i,jmax+1,k)] = vm[IX(i,jmax,k)];  
-      for(j=jmax; j>=1; j--) {
-          v[IX(i,j,k)] = (REAL) 0.5 * (v[IX(i,j,k)]+v[IX(i,j-1,k)]);
-          vm[IX(i,j,k)] = (REAL) 0.5 * (vm[IX(i,j,k)]+vm[IX(i,j-1,k)]);
-        }
-    }
-  }
-
-  for(i=0; i<=imax+1; i++) {
-    for(j=0; j<=jmax+1; j++) {
-      w[IX(i,j,kmax+1)] = w[IX(i,j,kmax)];
-      wm[IX(i,j,kmax+1)] = wm[IX(i,j,kmax)];  
-      for(k=kmax; k>=1; k--) {
-        w[IX(i,j,k)] = (REAL) 0.5 * (w[IX(i,j,k)]+w[IX(i,j,k-1)]);
-        wm[IX(i,j,k)] = (REAL) 0.5 * (wm[IX(i,j,k)]+wm[IX(i,j,k-1)]);
-      }
-    }
-  }
+  convert_to_center(para, u, X);
+  convert_to_center(para, v, Y);
+  convert_to_center(para, w, Z);
+  if(um!=NULL) convert_to_center(para, um, X);
+  if(vm!=NULL) convert_to_center(para, vm, Y);
+  if(wm!=NULL) convert_to_center(para, wm, Z);
 
   /****************************************************************************
   | Compute pressure value for the cornor of the domian
@@ -508,13 +524,13 @@ int write_SCI(PARA_DATA *para, REAL **var, char *name) {
   | Output the cooridates of cell center in x, y, z direction
   ****************************************************************************/ 
   for(i=1; i<=imax; i++)
-    fprintf(dataFile, "%e\t", x[IX(i,j,k)]);
+    fprintf(dataFile, "%e\t", x[i]);
   fprintf(dataFile, "\n");
   for(j=1; j<=jmax; j++)
-    fprintf(dataFile, "%e\t", y[IX(i,j,k)]);
+    fprintf(dataFile, "%e\t", y[j]);
   fprintf(dataFile, "\n");
   for(k=1; k<=kmax; k++)
-    fprintf(dataFile, "%e\t", z[IX(i,j,k)]);
+    fprintf(dataFile, "%e\t", z[k]);
   fprintf(dataFile, "\n");
 
    /****************************************************************************
@@ -67,6 +67,17 @@ int write_tecplot_all_data(PARA_DATA *para, REAL **var, char *name);
 ///////////////////////////////////////////////////////////////////////////////
 void convert_to_tecplot(PARA_DATA *para, REAL **var);
   
+///////////////////////////////////////////////////////////////////////////////
+/// Convert a velocity from the cell surfaces to the cell centers
+///
+///\param para Pointer to FFD parameters
+///\param psi Pointer to variable to be converted
+///\param dir Direction of the velocity: X, Y or Z
+///
+///\return no return
+///////////////////////////////////////////////////////////////////////////////
+void convert_to_center(PARA_DATA *para, REAL *psi, int dir);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Convert the data at 8 corners to the format for Tecplot 
 ///
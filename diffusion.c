@@ -29,18 +29,17 @@
 ///\param index Index of trace substance or species
 ///\param psi Pointer to the variable at current time step
 ///\param psi0 Pointer to the variable at previous time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
-               REAL *psi, REAL *psi0, int **BINDEX) {
+               REAL *psi, REAL *psi0) {
   int flag = 0;
 
   /****************************************************************************
   | Define the coeffcients for diffusion euqation
   ****************************************************************************/
-  flag = coef_diff(para, var, psi, psi0, var_type, index, BINDEX);
+  flag = coef_diff(para, var, psi, psi0, var_type, index);
   if(flag!=0) {
     ffd_log("diffsuion(): Could not calculate coefficents for "
             "diffusion equation.", FFD_ERROR);
@@ -51,34 +50,34 @@ int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
   equ_solver(para, var, var_type, psi);
 
   // Define B.C.
-  set_bnd(para, var, var_type, index, psi, BINDEX);
+  set_bnd(para, var, var_type, index, psi);
 
-  // Check residual
+  // Report the residual accumulated by the solver
   if(para->solv->check_residual==1) {
     switch(var_type) {
       case VX:
-        sprintf(msg, "diffusion(): Residual of VX is %f",
-                check_residual(para, var, psi));
+        sprintf(msg, "diffusion(): Residual of VX is %e after %d sweeps",
+                para->solv->residual, para->solv->iter);
         ffd_log(msg, FFD_NORMAL);
         break;
       case VY:
-        sprintf(msg, "diffusion(): Residual of VY is %f",
-                check_residual(para, var, psi));
+        sprintf(msg, "diffusion(): Residual of VY is %e after %d sweeps",
+                para->solv->residual, para->solv->iter);
         ffd_log(msg, FFD_NORMAL);
         break;
       case VZ:
-        sprintf(msg, "diffusion(): Residual of VZ is %f",
-                check_residual(para, var, psi));
+        sprintf(msg, "diffusion(): Residual of VZ is %e after %d sweeps",
+                para->solv->residual, para->solv->iter);
         ffd_log(msg, FFD_NORMAL);
         break;
       case TEMP:
-        sprintf(msg, "diffusion(): Residual of T is %f",
-                check_residual(para, var, psi));
+        sprintf(msg, "diffusion(): Residual of T is %e after %d sweeps",
+                para->solv->residual, para->solv->iter);
         ffd_log(msg, FFD_NORMAL);
         break;
       case TRACE:
-        sprintf(msg, "diffusion(): Residual of Trace %d is %f",
-                index, check_residual(para, var, psi));
+        sprintf(msg, "diffusion(): Residual of Trace %d is %e after %d sweeps",
+                index, para->solv->residual, para->solv->iter);
         ffd_log(msg, FFD_NORMAL);
         break;
       default:
@@ -101,23 +100,23 @@ int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
 ///\param psi0 Pointer to the variable at previous time step
 ///\param var_type Type of variable
 ///\param index Index of trace substance or species
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int coef_diff(PARA_DATA *para, REAL **var, REAL *psi, REAL *psi0, 
-               int var_type, int index, int **BINDEX) {
+               int var_type, int index) {
   int i, j, k;
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
   REAL *af = var[AF], *ab = var[AB], *ap = var[AP], *ap0 = var[AP0], *b = var[B];
-  REAL *x = var[X], *y = var[Y], *z = var[Z];
-  REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ];
+  REAL *dx = para->geom->mesh->dx, *dy = para->geom->mesh->dy;
+  REAL *dz = para->geom->mesh->dz;
+  REAL *ge, *gn, *gf, *vol; // Geometry of the stencils
   REAL *pp = var[PP];
   REAL *Temp = var[TEMP];
-  REAL dxe, dxw, dyn, dys, dzf, dzb, Dx, Dy, Dz;
+  REAL Dx, Dy, Dz;
   REAL dt = para->mytime->dt, beta = para->prob->beta;
   REAL Temp_Buoyancy = para->prob->Temp_Buoyancy;
   REAL gravx = para->prob->gravx, gravy = para->prob->gravy,
@@ -135,29 +134,23 @@ int coef_diff(PARA_DATA *para, REAL **var, REAL *psi, REAL *psi0,
       else if(para->prob->tur_model==CONSTANT) 
         kapa = 101.0f * para->prob->nu;
 
+      ge = var[GUE]; gn = var[GUN]; gf = var[GUF]; vol = var[VOLU];
       FOR_U_CELL
-        dxe = gx[IX(i+1,j  ,k)] - gx[IX(i  ,j,k)];
-        dxw = gx[IX(i  ,j  ,k)] - gx[IX(i-1,j,k)];
-        dyn =  y[IX(i  ,j+1,k)] -  y[IX(i  ,j,k)];
-        dys =  y[IX(i,j,k)] -      y[IX(i,j-1,k)];
-        dzf =  z[IX(i,j,k+1)] -    z[IX(i,j,k)];
-        dzb =  z[IX(i,j,k)] -      z[IX(i,j,k-1)];
-        Dx =   x[IX(i+1,j,k)] -    x[IX(i,j,k)];
-        Dy =  gy[IX(i,j,k)] -     gy[IX(i,j-1,k)];
-        Dz =  gz[IX(i,j,k)] -     gz[IX(i,j,k-1)];
+        Dy = dy[j];
+        Dz = dz[k];
 
         if(para->prob->tur_model==CHEN)
-          kapa = nu_t_chen_zero_equ(para, var, i, j, k);
+          kapa = var[NUT][IX(i,j,k)];
 
-        aw[IX(i,j,k)] = kapa*Dy*Dz/dxw;
-        ae[IX(i,j,k)] = kapa*Dy*Dz/dxe;
-        an[IX(i,j,k)] = kapa*Dx*Dz/dyn;
-        as[IX(i,j,k)] = kapa*Dx*Dz/dys;
-        af[IX(i,j,k)] = kapa*Dx*Dy/dzf;
-        ab[IX(i,j,k)] = kapa*Dx*Dy/dzb;
-        ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
+        aw[IX(i,j,k)] = kapa*ge[IX(i-1,j,k)];
+        ae[IX(i,j,k)] = kapa*ge[IX(i,j,k)];
+        an[IX(i,j,k)] = kapa*gn[IX(i,j,k)];
+        as[IX(i,j,k)] = kapa*gn[IX(i,j-1,k)];
+        af[IX(i,j,k)] = kapa*gf[IX(i,j,k)];
+        ab[IX(i,j,k)] = kapa*gf[IX(i,j,k-1)];
+        ap0[IX(i,j,k)] = vol[IX(i,j,k)]/dt;
         b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)]
-                     - beta*gravx*(Temp[IX(i,j,k)]-Temp_Buoyancy)*Dx*Dy*Dz
+                     - beta*gravx*(Temp[IX(i,j,k)]-Temp_Buoyancy)*vol[IX(i,j,k)]
                      + (pp[IX(i,j,k)]-pp[IX(i+1,j,k)])*Dy*Dz;
       END_FOR
 
@@ -177,29 +170,23 @@ int coef_diff(PARA_DATA *para, REAL **var, REAL *psi, REAL *psi0,
       else if(para->prob->tur_model==CONSTANT) 
         kapa = (REAL) 101.0 * para->prob->nu;
 
+      ge = var[GVE]; gn = var[GVN]; gf = var[GVF]; vol = var[VOLV];
       FOR_V_CELL
-        dxe = x[IX(i+1,j,k)] - x[IX(i,j,k)];
-        dxw = x[IX(i,j,k)] - x[IX(i-1,j,k)];
-        dyn = gy[IX(i,j+1,k)] - gy[IX(i,j,k)];
-        dys = gy[IX(i,j,k)] - gy[IX(i,j-1,k)];
-        dzf = z[IX(i,j,k+1)] - z[IX(i,j,k)];
-        dzb = z[IX(i,j,k)] - z[IX(i,j,k-1)];
-        Dx = gx[IX(i,j,k)] - gx[IX(i-1,j,k)];
-        Dy = y[IX(i,j+1,k)] - y[IX(i,j,k)];
-        Dz = gz[IX(i,j,k)] - gz[IX(i,j,k-1)];
+        Dx = dx[i];
+        Dz = dz[k];
 
         if(para->prob->tur_model==CHEN)
-          kapa = nu_t_chen_zero_equ(para, var, i, j, k);
+          kapa = var[NUT][IX(i,j,k)];
 
-        aw[IX(i,j,k)] = kapa*Dy*Dz/dxw;
-        ae[IX(i,j,k)] = kapa*Dy*Dz/dxe;
-        an[IX(i,j,k)] = kapa*Dx*Dz/dyn;
-        as[IX(i,j,k)] = kapa*Dx*Dz/dys;
-        af[IX(i,j,k)] = kapa*Dx*Dy/dzf;
-        ab[IX(i,j,k)] = kapa*Dx*Dy/dzb;
-        ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
+        aw[IX(i,j,k)] = kapa*ge[IX(i-1,j,k)];
+        ae[IX(i,j,k)] = kapa*ge[IX(i,j,k)];
+        an[IX(i,j,k)] = kapa*gn[IX(i,j,k)];
+        as[IX(i,j,k)] = kapa*gn[IX(i,j-1,k)];
+        af[IX(i,j,k)] = kapa*gf[IX(i,j,k)];
+        ab[IX(i,j,k)] = kapa*gf[IX(i,j,k-1)];
+        ap0[IX(i,j,k)] = vol[IX(i,j,k)]/dt;
         b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)]
-                     - beta*gravy*(Temp[IX(i,j,k)]-Temp_Buoyancy)*Dx*Dy*Dz
+                     - beta*gravy*(Temp[IX(i,j,k)]-Temp_Buoyancy)*vol[IX(i,j,k)]
                      + (pp[IX(i,j,k)]-pp[IX(i ,j+1,k)])*Dx*Dz;
       END_FOR
 
@@ -219,29 +206,23 @@ int coef_diff(PARA_DATA *para, REAL **var, REAL *psi, REAL *psi0,
       else if(para->prob->tur_model==CONSTANT) 
         kapa = (REAL) 101.0 * para->prob->nu;
         
+      ge = var[GWE]; gn = var[GWN]; gf = var[GWF]; vol = var[VOLW];
       FOR_W_CELL
-        dxe = x[IX(i+1,j,k)] - x[IX(i,j,k)];
-        dxw = x[IX(i,j,k)] - x[IX(i-1,j,k)];
-        dyn = y[IX(i,j+1,k)] - y[IX(i,j,k)];
-        dys = y[IX(i,j,k)] - y[IX(i,j-1,k)];
-        dzf = gz[IX(i,j,k+1)] - gz[IX(i,j,k)];
-        dzb = gz[IX(i,j,k)] - gz[IX(i,j,k-1)];
-        Dx = gx[IX(i,j,k)] - gx[IX(i-1,j,k)];
-        Dy = gy[IX(i,j,k)] - gy[IX(i,j-1,k)];
-        Dz = z[IX(i,j,k+1)] - z[IX(i,j,k)];
+        Dx = dx[i];
+        Dy = dy[j];
 
         if(para->prob->tur_model==CHEN)
-          kapa = nu_t_chen_zero_equ(para, var, i, j, k);
+          kapa = var[NUT][IX(i,j,k)];
 
-        aw[IX(i,j,k)] = kapa*Dy*Dz/dxw;
-        ae[IX(i,j,k)] = kapa*Dy*Dz/dxe;
-        an[IX(i,j,k)] = kapa*Dx*Dz/dyn;
-        as[IX(i,j,k)] = kapa*Dx*Dz/dys;
-        af[IX(i,j,k)] = kapa*Dx*Dy/dzf;
-        ab[IX(i,j,k)] = kapa*Dx*Dy/dzb;
-        ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
+        aw[IX(i,j,k)] = kapa*ge[IX(i-1,j,k)];
+        ae[IX(i,j,k)] = kapa*ge[IX(i,j,k)];
+        an[IX(i,j,k)] = kapa*gn[IX(i,j,k)];
+        as[IX(i,j,k)] = kapa*gn[IX(i,j-1,k)];
+        af[IX(i,j,k)] = kapa*gf[IX(i,j,k)];
+        ab[IX(i,j,k)] = kapa*gf[IX(i,j,k-1)];
+        ap0[IX(i,j,k)] = vol[IX(i,j,k)]/dt;
         b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)]
-                     - beta*gravz*(Temp[IX(i,j,k)]-Temp_Buoyancy)*Dx*Dy*Dz
+                     - beta*gravz*(Temp[IX(i,j,k)]-Temp_Buoyancy)*vol[IX(i,j,k)]
                      + (pp[IX(i,j,k)]-pp[IX(i ,j,k+1)])*Dy*Dx;
       END_FOR
 
@@ -263,28 +244,24 @@ int coef_diff(PARA_DATA *para, REAL **var, REAL *psi, REAL *psi0,
       else if(para->prob->tur_model == CONSTANT) 
         kapa = (REAL) 101.0 * para->prob->alpha;
 
+      ge = var[GPE]; gn = var[GPN]; gf = var[GPF]; vol = var[VOLP];
       FOR_EACH_CELL
-        dxe = x[IX(i+1,j,k)] - x[IX(i,j,k)];
-        dxw = x[IX(i,j,k)] - x[IX(i-1,j,k)];
-        dyn = y[IX(i,j+1,k)] - y[IX(i,j,k)];
-        dys = y[IX(i,j,k)] - y[IX(i,j-1,k)];
-        dzf = z[IX(i,j,k+1)] - z[IX(i,j,k)];
-        dzb = z[IX(i,j,k)] - z[IX(i,j,k-1)];
-        Dx = gx[IX(i,j,k)] - gx[IX(i-1,j,k)];
-        Dy = gy[IX(i,j,k)] - gy[IX(i,j-1,k)];
-        Dz = gz[IX(i,j,k)] - gz[IX(i,j,k-1)];
- 
-        aw[IX(i,j,k)] = kapa*Dy*Dz/dxw;
-        ae[IX(i,j,k)] = kapa*Dy*Dz/dxe;
-        an[IX(i,j,k)] = kapa*Dx*Dz/dyn;
-        as[IX(i,j,k)] = kapa*Dx*Dz/dys;
-        af[IX(i,j,k)] = kapa*Dx*Dy/dzf;
-        ab[IX(i,j,k)] = kapa*Dx*Dy/dzb;
-        ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
+        // Same turbulent Prandtl number as the wall heat transfer in h_coef()
+        if(para->prob->tur_model==CHEN)
+          kapa = para->prob->alpha
+               * (1 + var[NUT][IX(i,j,k)]/para->prob->nu);
+
+        aw[IX(i,j,k)] = kapa*ge[IX(i-1,j,k)];
+        ae[IX(i,j,k)] = kapa*ge[IX(i,j,k)];
+        an[IX(i,j,k)] = kapa*gn[IX(i,j,k)];
+        as[IX(i,j,k)] = kapa*gn[IX(i,j-1,k)];
+        af[IX(i,j,k)] = kapa*gf[IX(i,j,k)];
+        ab[IX(i,j,k)] = kapa*gf[IX(i,j,k-1)];
+        ap0[IX(i,j,k)] = vol[IX(i,j,k)]/dt;
         b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)];
       END_FOR
 
-      set_bnd(para, var, var_type, index, psi, BINDEX);
+      set_bnd(para, var, var_type, index, psi);
 
       FOR_EACH_CELL
         ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
@@ -316,26 +293,32 @@ int source_diff(PARA_DATA *para, REAL **var, int var_type, int index) {
   int imax = para->geom->imax, jmax = para->geom->jmax; 
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *b = var[B];
- 
+  REAL *b = var[B], *src;
+
+  // The optional source terms are not allocated if they were never set
+  switch(var_type) {
+    case VX:
+      src = var[VXS];
+      break;
+    case VY: 
+      src = var[VYS];
+      break;
+    case VZ: 
+      src = var[VZS];
+      break;
+    case TEMP: 
+      src = var[TEMPS];
+      break;
+    case TRACE:  
+      src = var[TRACE+para->bc->nb_Xi+index];
+      break;
+    default:
+      src = NULL;
+  }
+  if(src==NULL) return 0;
+
   FOR_EACH_CELL
-    switch(var_type) {
-      case VX:
-        b[IX(i,j,k)] += var[VXS][IX(i,j,k)];   
-        break;
-      case VY: 
-        b[IX(i,j,k)] += var[VYS][IX(i,j,k)];  
-        break;
-      case VZ: 
-        b[IX(i,j,k)] += var[VZS][IX(i,j,k)]; 
-        break;
-      case TEMP: 
-        b[IX(i,j,k)] += var[TEMPS][IX(i,j,k)];
-        break;
-      case TRACE:  
-        b[IX(i,j,k)] += var[TRACE+para->bc->nb_Xi+index][IX(i,j,k)];
-        break;
-    }
+    b[IX(i,j,k)] += src[IX(i,j,k)];
   END_FOR
 
   return 0;
@@ -55,12 +55,11 @@
 ///\param index Index of trace substance or species
 ///\param psi Pointer to the variable at current time step
 ///\param psi0 Pointer to the variable at previous time step
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
-               REAL *psi, REAL *psi0, int **BINDEX);
+               REAL *psi, REAL *psi0);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calcuate coefficients for difussion equation solver
@@ -71,12 +70,11 @@ int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
 ///\param psi0 Pointer to the variable at previous time step
 ///\param var_type Type of variable
 ///\param index Index of trace substance or species
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int coef_diff(PARA_DATA *para, REAL **var, REAL *psi, REAL *psi0, 
-               int var_type, int index, int **BINDEX);
+               int var_type, int index);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calcuate source term in the difussion equation
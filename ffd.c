@@ -49,7 +49,7 @@ int allocate_memory (PARA_DATA *para) {
   /****************************************************************************
   | Allocate memory for variables
   ****************************************************************************/
-  nb_var = 46 + para->bc->nb_Xi + para->bc->nb_C;
+  nb_var = TRACE + 2 + para->bc->nb_Xi + para->bc->nb_C;
   var       = (REAL **) malloc ( nb_var*sizeof(REAL*) );
   if(var==NULL) {
     ffd_log("allocate_memory(): Could not allocate memory for var.",
@@ -57,14 +57,16 @@ int allocate_memory (PARA_DATA *para) {
     return 1;
   }
 
-  for(i=0; i<nb_var; i++) {
-    var[i] = (REAL *) calloc(size, sizeof(REAL));
-    if(var[i]==NULL) {
-      sprintf(msg, 
-              "allocate_memory(): Could not allocate memory for var[%d]", i);
-      ffd_log(msg, FFD_ERROR);
-      return 1;
-    }
+  if(allocate_fields(para, var, nb_var)!=0) {
+    ffd_log("allocate_memory(): Could not allocate memory for the variables.",
+            FFD_ERROR);
+    return 1;
+  }
+
+  if(allocate_cell_mask(para)!=0) {
+    ffd_log("allocate_memory(): Could not allocate memory for the cell types.",
+            FFD_ERROR);
+    return 1;
   }
 
   /****************************************************************************
@@ -82,14 +84,13 @@ int allocate_memory (PARA_DATA *para) {
     return 1;
   }
 
-  for(i=0; i<5; i++)
-    BINDEX[i] = (int *) malloc(size*sizeof(int));
-    if(BINDEX[i]==NULL) {
-      sprintf(msg, 
-              "allocate_memory(): Could not allocate memory for BINDEX[%d]", i);
-      ffd_log(msg, FFD_ERROR);
-      return 1;
-    }
+  // The rows are shrunk to the number of boundary cells after reading
+  for(i=0; i<5; i++) BINDEX[i] = NULL;
+  if(resize_index(BINDEX, size)!=0) {
+    ffd_log("allocate_memory(): Could not allocate memory for BINDEX.",
+            FFD_ERROR);
+    return 1;
+  }
 
   return 0;
 } // End of allocate_memory()
@@ -123,7 +124,7 @@ static void key_func(unsigned char key, int x, int y) {
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
 static void idle_func(void) {
-  ffd_idle_func(&para, var, BINDEX);
+  ffd_idle_func(&para, var);
 } // End of idle_func()
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -391,8 +392,20 @@ int ffd(int cosimulation) {
   write_SCI(&para, var, "output");
 
   // Free the memory
+  free_cell_run(&para);
+  free_cell_mask(&para);
+  free_mesh(&para);
+  free_boundary_cells(&para);
   free_data(var);
   free_index(BINDEX);
+  free_mg_data();
+  free_pcg_data();
+  free_tdma_data();
+  free_gs_data();
+  free_fft_data();
+  free_chol_data();
+  free_advection_data();
+  free_projection_data();
 
   // End the simulation
   if(para.outp->version==DEBUG || para.outp->version==DEMO) {}//getchar();
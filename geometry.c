@@ -18,17 +18,16 @@
 /// Calculate the volume of of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
 ///\param j J-index of the control volume
-///\param K K-index of the control volume
+///\param k K-index of the control volume
 ///
 ///\return Volume
 ///////////////////////////////////////////////////////////////////////////////
-REAL vol(PARA_DATA *para, REAL **var, int i, int j, int k) {
+REAL vol(PARA_DATA *para, int i, int j, int k) {
 
-  return area_xy(para, var, i, j, k) 
-       * length_z(para, var, i, j, k);
+  return area_xy(para, i, j) 
+       * length_z(para, k);
 } // End of vol()
 
 
@@ -36,124 +35,162 @@ REAL vol(PARA_DATA *para, REAL **var, int i, int j, int k) {
 /// Calculate the XY area of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
 ///\param j J-index of the control volume
-///\param K K-index of the control volume
 ///
 ///\return Area of XY surface
 ///////////////////////////////////////////////////////////////////////////////
-REAL area_xy(PARA_DATA *para, REAL **var, int i, int j, int k) {
-  return length_x(para, var, i, j, k) 
-       * length_y(para, var, i, j, k);
+REAL area_xy(PARA_DATA *para, int i, int j) {
+  return length_x(para, i) 
+       * length_y(para, j);
 } // End of area_xy()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the YZ area of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param i I-index of the control volume
 ///\param j J-index of the control volume
-///\param K K-index of the control volume
+///\param k K-index of the control volume
 ///
 ///\return Area of YZ surface
 ///////////////////////////////////////////////////////////////////////////////
-REAL area_yz(PARA_DATA *para, REAL **var, int i, int j, int k) {
-  return length_y(para, var, i, j, k) 
-       * length_z(para, var, i, j, k);
+REAL area_yz(PARA_DATA *para, int j, int k) {
+  return length_y(para, j) 
+       * length_z(para, k);
 } // End of area_yz();
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the ZX area of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
-///\param j J-index of the control volume
-///\param K K-index of the control volume
+///\param k K-index of the control volume
 ///
 ///\return Area of ZX surface
 ///////////////////////////////////////////////////////////////////////////////
-REAL area_zx(PARA_DATA *para, REAL **var, int i, int j, int k) {
-  return length_z(para, var, i, j, k) 
-       * length_x(para, var, i, j, k);
+REAL area_zx(PARA_DATA *para, int i, int k) {
+  return length_z(para, k) 
+       * length_x(para, i);
 } // End of area_zx()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the X-length of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
-///\param j J-index of the control volume
-///\param K K-index of the control volume
 ///
 ///\return Length in X-direction
 ///////////////////////////////////////////////////////////////////////////////
-REAL length_x(PARA_DATA *para, REAL **var, int i, int j, int k) {
-  int imax = para->geom->imax, jmax = para->geom->jmax; 
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-
-  if(i==0)
-    return 0;
-  else
-    return (REAL) fabs(var[GX][IX(i,j,k)]-var[GX][IX(i-1,j,k)]); 
+REAL length_x(PARA_DATA *para, int i) {
+  return (REAL) fabs(para->geom->mesh->dx[i]);
 } // End of length_x()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the Y-length of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param i I-index of the control volume
 ///\param j J-index of the control volume
-///\param K K-index of the control volume
 ///
 ///\return Length in Y-direction
 ///////////////////////////////////////////////////////////////////////////////
-REAL length_y(PARA_DATA *para, REAL **var, int i, int j, int k) {
-  int imax = para->geom->imax, jmax = para->geom->jmax; 
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-
-  if(j==0)
-    return 0;
-  else 
-    return (REAL) fabs(var[GY][IX(i,j,k)]-var[GY][IX(i,j-1,k)]); 
+REAL length_y(PARA_DATA *para, int j) {
+  return (REAL) fabs(para->geom->mesh->dy[j]);
 } // End of length_y()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the Z-length of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param i I-index of the control volume
-///\param j J-index of the control volume
-///\param K K-index of the control volume
+///\param k K-index of the control volume
 ///
 ///\return Length in Z-direction
 ///////////////////////////////////////////////////////////////////////////////
-REAL length_z(PARA_DATA *para, REAL **var, int i, int j, int k) {
-  int imax = para->geom->imax, jmax = para->geom->jmax; 
+REAL length_z(PARA_DATA *para, int k) {
+  return (REAL) fabs(para->geom->mesh->dz[k]);
+} // End of length_z()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the time invariant geometry of the stencils
+///
+/// For the pressure cells and the cells of the three velocity components,
+/// the ratio of face area to the distance between the neighboring nodes is
+/// stored for the east, north and front face as well as the volume of the
+/// cell. The west, south and back ratios of cell (i,j,k) are the east,
+/// north and front ratios of cell (i-1,j,k), (i,j-1,k) and (i,j,k-1). The
+/// coefficients of the diffusion and pressure equations are then obtained
+/// by multiplying the ratios with the diffusivity.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_geometry_coef(PARA_DATA *para, REAL **var) {
+  int i, j, k;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  MESH_DATA *mesh = para->geom->mesh;
+  REAL *x, *y, *z, *dx, *dy, *dz;
+  REAL Dx, Dy, Dz, Dxu, Dyv, Dzw, dxe, dyn, dzf, gxe, gyn, gzf;
 
-  if(k==0)
-    return 0;
-  else 
-    return (REAL) fabs(var[GZ][IX(i,j,k)]-var[GZ][IX(i,j,k-1)]); 
-} // End of length_z()
+  if(mesh==NULL) {
+    ffd_log("set_geometry_coef(): The mesh has not been defined.", FFD_ERROR);
+    return 1;
+  }
+  x = mesh->x; y = mesh->y; z = mesh->z;
+  dx = mesh->dx; dy = mesh->dy; dz = mesh->dz;
+
+  FOR_ALL_CELL
+    // Length of pressure cell and of velocity cells in their direction
+    Dx = dx[i];
+    Dy = dy[j];
+    Dz = dz[k];
+    Dxu = i<=imax ? x[i+1] - x[i] : 0;
+    Dyv = j<=jmax ? y[j+1] - y[j] : 0;
+    Dzw = k<=kmax ? z[k+1] - z[k] : 0;
+    // Distance to the east, north and front neighbors
+    dxe = Dxu;
+    dyn = Dyv;
+    dzf = Dzw;
+    gxe = i<=imax ? dx[i+1] : 0;
+    gyn = j<=jmax ? dy[j+1] : 0;
+    gzf = k<=kmax ? dz[k+1] : 0;
+
+    var[GPE][IX(i,j,k)] = dxe>0 ? Dy*Dz/dxe : 0;
+    var[GPN][IX(i,j,k)] = dyn>0 ? Dx*Dz/dyn : 0;
+    var[GPF][IX(i,j,k)] = dzf>0 ? Dx*Dy/dzf : 0;
+    var[VOLP][IX(i,j,k)] = Dx*Dy*Dz;
+
+    var[GUE][IX(i,j,k)] = gxe>0 ? Dy*Dz/gxe : 0;
+    var[GUN][IX(i,j,k)] = dyn>0 ? Dxu*Dz/dyn : 0;
+    var[GUF][IX(i,j,k)] = dzf>0 ? Dxu*Dy/dzf : 0;
+    var[VOLU][IX(i,j,k)] = Dxu*Dy*Dz;
+
+    var[GVE][IX(i,j,k)] = dxe>0 ? Dyv*Dz/dxe : 0;
+    var[GVN][IX(i,j,k)] = gyn>0 ? Dx*Dz/gyn : 0;
+    var[GVF][IX(i,j,k)] = dzf>0 ? Dx*Dyv/dzf : 0;
+    var[VOLV][IX(i,j,k)] = Dx*Dyv*Dz;
+
+    var[GWE][IX(i,j,k)] = dxe>0 ? Dy*Dzw/dxe : 0;
+    var[GWN][IX(i,j,k)] = dyn>0 ? Dx*Dzw/dyn : 0;
+    var[GWF][IX(i,j,k)] = gzf>0 ? Dx*Dy/gzf : 0;
+    var[VOLW][IX(i,j,k)] = Dx*Dy*Dzw;
+  END_FOR
+
+  return 0;
+} // End of set_geometry_coef()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the area of boundary surface
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param BINDEX Pointer to boundary index
 ///\param A Pointer to the array of area
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int bounary_area(PARA_DATA *para, REAL **var, int **BINDEX) {
+int bounary_area(PARA_DATA *para, int **BINDEX) {
    
   int i, j, k, it, id;
   //int id0;
@@ -161,11 +198,13 @@ int bounary_area(PARA_DATA *para, REAL **var, int **BINDEX) {
       jmax = para->geom->jmax, kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
 
-  REAL *flagp = var[FLAGP];
+  CELL_MASK *mask = cell_mask(para);
   REAL tmp;
   REAL *AWall = para->bc->AWall;
   REAL *APort = para->bc->APort;
 
+  if(mask==NULL) return 1;
+
   if(para->bc->nb_wall>0)
     for(id=0; id<para->bc->nb_wall; id++) AWall[id] = 0;
   if(para->bc->nb_port>0)
@@ -189,24 +228,24 @@ int bounary_area(PARA_DATA *para, REAL **var, int **BINDEX) {
     //-------------------------------------------------------------------------
     // Calcuate wall or windows
     //-------------------------------------------------------------------------
-    if(flagp[IX(i,j,k)]==SOLID) {
+    if(CELL_TYPE(mask[IX(i,j,k)], MASK_P)==SOLID) {
       // West or East Boundary
       if(i==0 || i==imax+1) {
-        tmp = area_yz(para, var, i, j, k);
+        tmp = area_yz(para, j, k);
         //sprintf(msg, "Cell(%d,%d,%d):\t %f", i, j, k, tmp);
         //ffd_log(msg, FFD_NORMAL);
         AWall[id] += tmp;
       }
       // South and Norht Boundary
       if(j==0 || j==jmax+1) {
-        tmp = area_zx(para, var, i, j, k);
+        tmp = area_zx(para, i, k);
         //sprintf(msg, "Cell(%d,%d,%d):\t %f", i, j, k, tmp);
         //ffd_log(msg, FFD_NORMAL);
         AWall[id] += tmp;
       }
       // Ceiling and Floor Boundary
       if(k==0 || k==kmax+1) {
-        tmp = area_xy(para, var, i, j, k);
+        tmp = area_xy(para, i, j);
         //sprintf(msg, "Cell(%d,%d,%d):\t %f", i, j, k, tmp);
         //ffd_log(msg, FFD_NORMAL);
         AWall[id] += tmp;
@@ -216,24 +255,25 @@ int bounary_area(PARA_DATA *para, REAL **var, int **BINDEX) {
     //-------------------------------------------------------------------------
     // Calcuate inlets
     //-------------------------------------------------------------------------
-    if(flagp[IX(i,j,k)]==INLET||flagp[IX(i,j,k)]==OUTLET) {
+    if(CELL_TYPE(mask[IX(i,j,k)], MASK_P)==INLET
+       ||CELL_TYPE(mask[IX(i,j,k)], MASK_P)==OUTLET) {
       // West or East Boundary
       if(i==0 || i==imax+1) {
-        tmp = area_yz(para, var, i, j, k);
+        tmp = area_yz(para, j, k);
         //sprintf(msg, "Cell(%d,%d,%d):\t %f", i, j, k, tmp);
         //ffd_log(msg, FFD_NORMAL);
         APort[id] += tmp;
       }
       // South and Norht Boundary
       if(j==0 || j==jmax+1) {
-        tmp = area_zx(para, var, i, j, k);
+        tmp = area_zx(para, i, k);
         //sprintf(msg, "Cell(%d,%d,%d):\t %f", i, j, k, tmp);
         //ffd_log(msg, FFD_NORMAL);
         APort[id] += tmp;
       }
       // Ceiling and Floor Boundary
       if(k==0 || k==kmax+1) {
-        tmp = area_xy(para, var, i, j, k);
+        tmp = area_xy(para, i, j);
         //sprintf(msg, "Cell(%d,%d,%d):\t %f", i, j, k, tmp);
         //ffd_log(msg, FFD_NORMAL);
         APort[id] += tmp;
@@ -268,4 +308,198 @@ int bounary_area(PARA_DATA *para, REAL **var, int **BINDEX) {
     }
   }
   return 0;
-} // End of bounary_area()
\ No newline at end of file
+} // End of bounary_area()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the faces of a boundary cell
+///
+/// A cell on the domain boundary has a face for each of its sides on the
+/// boundary. An internal cell has a face for each fluid neighbor or the single
+/// face FACE_NONE if it has none. The faces are the bits FACE_BIT() of the
+/// mask, see set_cell_mask().
+///
+///\param m Packed cell types of the cell
+///\param face Pointer to the array of at least 6 faces
+///
+///\return Number of faces
+///////////////////////////////////////////////////////////////////////////////
+static int boundary_faces(CELL_MASK m, int *face) {
+  int f, n = 0;
+
+  for(f=FACE_W; f<FACE_NONE; f++)
+    if(m & FACE_BIT(f)) face[n++] = f;
+  if(n==0) face[n++] = FACE_NONE;
+
+  return n;
+} // End of boundary_faces()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the group of a boundary face in the sorted table
+///
+///\param b Pointer to the boundary face
+///
+///\return Group between 0 and BCELL_NB_GROUP-1
+///////////////////////////////////////////////////////////////////////////////
+int boundary_group(BOUNDARY_CELL *b) {
+  int type;
+
+  switch(b->type) {
+    case INLET: type = BND_INLET; break;
+    case OUTLET: type = BND_OUTLET; break;
+    default: type = b->therm==1 ? BND_SOLID_T : BND_SOLID_Q;
+  }
+
+  return BCELL_GROUP(type, b->face);
+} // End of boundary_group()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Build the table of boundary faces
+///
+/// The cells listed in BINDEX are expanded into their faces as described for
+/// BOUNDARY_CELL in data_structure.h. The index of the cell across the face,
+/// the face area and the distance to the center of that cell are computed
+/// once, so that the boundary conditions do not need to find the face of a
+/// cell in every time step. The faces are sorted by their group with a
+/// stable counting sort, the order of BINDEX is kept within a group. The
+/// start of each group is stored in para->geom->bgroup.
+///
+///\param para Pointer to FFD parameters
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_boundary_cells(PARA_DATA *para, int **BINDEX) {
+  int i, j, k, it, n, m, nb_face, group;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int index = para->geom->index;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int face[6], count[BCELL_NB_GROUP+1], sides;
+  BOUNDARY_CELL *tmp, *b;
+  CELL_MASK *mask = cell_mask(para);
+
+  if(mask==NULL) return 1;
+  if(para->geom->mesh==NULL) {
+    ffd_log("set_boundary_cells(): The mesh has not been defined.",
+            FFD_ERROR);
+    return 1;
+  }
+
+  free_boundary_cells(para);
+
+  // Count the faces
+  nb_face = 0;
+  for(it=0; it<index; it++)
+    nb_face += boundary_faces(mask[IX(BINDEX[0][it],BINDEX[1][it],
+                                      BINDEX[2][it])], face);
+
+  tmp = (BOUNDARY_CELL *) malloc((nb_face+1)*sizeof(BOUNDARY_CELL));
+  para->geom->bcell = (BOUNDARY_CELL *) malloc((nb_face+1)
+                                               *sizeof(BOUNDARY_CELL));
+  if(tmp==NULL || para->geom->bcell==NULL) {
+    ffd_log("set_boundary_cells(): Could not allocate memory for the "
+            "boundary faces.", FFD_ERROR);
+    if(tmp!=NULL) free(tmp);
+    free_boundary_cells(para);
+    return 1;
+  }
+  para->geom->nb_bcell = nb_face;
+
+  /****************************************************************************
+  | Expand the cells into faces
+  ****************************************************************************/
+  b = tmp;
+  for(it=0; it<index; it++) {
+    i = BINDEX[0][it];
+    j = BINDEX[1][it];
+    k = BINDEX[2][it];
+
+    m = boundary_faces(mask[IX(i,j,k)], face);
+    sides = (i==0)<<FACE_W | (i==imax+1)<<FACE_E | (j==0)<<FACE_S
+          | (j==jmax+1)<<FACE_N | (k==0)<<FACE_B | (k==kmax+1)<<FACE_F;
+    for(n=0; n<m; n++, b++) {
+      b->id = IX(i,j,k);
+      b->i = i;
+      b->j = j;
+      b->k = k;
+      b->face = face[n];
+      b->sides = sides;
+      b->type = CELL_TYPE(mask[IX(i,j,k)], MASK_P);
+      b->therm = b->type==SOLID ? BINDEX[3][it] : -1;
+      b->bcid = BINDEX[4][it];
+
+      switch(face[n]) {
+        case FACE_W:
+          b->nb = IX(i+1,j,k);
+          b->area = area_yz(para, j, k);
+          b->dist = (REAL) 0.5 * length_x(para, i+1);
+          break;
+        case FACE_E:
+          b->nb = IX(i-1,j,k);
+          b->area = area_yz(para, j, k);
+          b->dist = (REAL) 0.5 * length_x(para, i-1);
+          break;
+        case FACE_S:
+          b->nb = IX(i,j+1,k);
+          b->area = area_zx(para, i, k);
+          b->dist = (REAL) 0.5 * length_y(para, j+1);
+          break;
+        case FACE_N:
+          b->nb = IX(i,j-1,k);
+          b->area = area_zx(para, i, k);
+          b->dist = (REAL) 0.5 * length_y(para, j-1);
+          break;
+        case FACE_B:
+          b->nb = IX(i,j,k+1);
+          b->area = area_xy(para, i, j);
+          b->dist = (REAL) 0.5 * length_z(para, k+1);
+          break;
+        case FACE_F:
+          b->nb = IX(i,j,k-1);
+          b->area = area_xy(para, i, j);
+          b->dist = (REAL) 0.5 * length_z(para, k-1);
+          break;
+        default:
+          b->nb = -1;
+          b->area = 0;
+          b->dist = 0;
+      }
+    }
+  }
+
+  /****************************************************************************
+  | Sort the faces by their group
+  ****************************************************************************/
+  for(n=0; n<=BCELL_NB_GROUP; n++) count[n] = 0;
+  for(n=0; n<nb_face; n++) count[boundary_group(&tmp[n])+1]++;
+  for(n=1; n<=BCELL_NB_GROUP; n++) count[n] += count[n-1];
+  for(n=0; n<=BCELL_NB_GROUP; n++) para->geom->bgroup[n] = count[n];
+  for(n=0; n<nb_face; n++) {
+    group = boundary_group(&tmp[n]);
+    para->geom->bcell[count[group]++] = tmp[n];
+  }
+
+  free(tmp);
+
+  sprintf(msg, "set_boundary_cells(): %d faces of %d boundary cells.",
+          nb_face, index);
+  ffd_log(msg, FFD_NORMAL);
+
+  return 0;
+} // End of set_boundary_cells()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the table of boundary faces
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_boundary_cells(PARA_DATA *para) {
+  int n;
+
+  if(para->geom->bcell!=NULL) free(para->geom->bcell);
+  para->geom->bcell = NULL;
+  para->geom->nb_bcell = 0;
+  for(n=0; n<=BCELL_NB_GROUP; n++) para->geom->bgroup[n] = 0;
+} // End of free_boundary_cells()
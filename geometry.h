@@ -29,102 +29,123 @@
 /// Calculate the volume of of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
 ///\param j J-index of the control volume
-///\param K K-index of the control volume
+///\param k K-index of the control volume
 ///
 ///\return Volume
 ///////////////////////////////////////////////////////////////////////////////
-REAL vol(PARA_DATA *para, REAL **var, int i, int j, int k);
+REAL vol(PARA_DATA *para, int i, int j, int k);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the XY area of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
 ///\param j J-index of the control volume
-///\param K K-index of the control volume
 ///
 ///\return Area of XY surface
 ///////////////////////////////////////////////////////////////////////////////
-REAL area_xy(PARA_DATA *para, REAL **var, int i, int j, int k);
+REAL area_xy(PARA_DATA *para, int i, int j);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the YZ area of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param i I-index of the control volume
 ///\param j J-index of the control volume
-///\param K K-index of the control volume
+///\param k K-index of the control volume
 ///
 ///\return Area of YZ surface
 ///////////////////////////////////////////////////////////////////////////////
-REAL area_yz(PARA_DATA *para, REAL **var, int i, int j, int k);
+REAL area_yz(PARA_DATA *para, int j, int k);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the ZX area of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
-///\param j J-index of the control volume
-///\param K K-index of the control volume
+///\param k K-index of the control volume
 ///
 ///\return Area of ZX surface
 ///////////////////////////////////////////////////////////////////////////////
-REAL area_zx(PARA_DATA *para, REAL **var, int i, int j, int k);
+REAL area_zx(PARA_DATA *para, int i, int k);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the X-length of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param i I-index of the control volume
-///\param j J-index of the control volume
-///\param K K-index of the control volume
-///\param IMAX Value of imax+2
-///\param IMAX Value of (imax+2)*(jmax+2)
 ///
 ///\return Length in X-direction
 ///////////////////////////////////////////////////////////////////////////////
-REAL length_x(PARA_DATA *para, REAL **var, int i, int j, int k);
+REAL length_x(PARA_DATA *para, int i);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the Y-length of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param i I-index of the control volume
 ///\param j J-index of the control volume
-///\param K K-index of the control volume
 ///
 ///\return Length in Y-direction
 ///////////////////////////////////////////////////////////////////////////////
-REAL length_y(PARA_DATA *para, REAL **var, int i, int j, int k);
+REAL length_y(PARA_DATA *para, int j);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the Z-length of control volume (i,j,k)
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param i I-index of the control volume
-///\param j J-index of the control volume
-///\param K K-index of the control volume
+///\param k K-index of the control volume
 ///
 ///\return Length in Z-direction
 ///////////////////////////////////////////////////////////////////////////////
-REAL length_z(PARA_DATA *para, REAL **var, int i, int j, int k);
+REAL length_z(PARA_DATA *para, int k);
 
 ///////////////////////////////////////////////////////////////////////////////
-/// Calculate the area of boundary surface
+/// Calculate the time invariant geometry of the stencils
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_geometry_coef(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the area of boundary surface
+///
+///\param para Pointer to FFD parameters
 ///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int bounary_area(PARA_DATA *para, REAL **var, int **BINDEX);
\ No newline at end of file
+int bounary_area(PARA_DATA *para, int **BINDEX);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the group of a boundary face in the sorted table
+///
+/// The groups are the BNDTYPE of the cell, each of them split by the face.
+///
+///\param b Pointer to the boundary face
+///
+///\return Group between 0 and BCELL_NB_GROUP-1
+///////////////////////////////////////////////////////////////////////////////
+int boundary_group(BOUNDARY_CELL *b);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Build the table of boundary faces
+///
+///\param para Pointer to FFD parameters
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_boundary_cells(PARA_DATA *para, int **BINDEX);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the table of boundary faces
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_boundary_cells(PARA_DATA *para);
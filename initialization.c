@@ -73,6 +73,13 @@ void set_default_parameter(PARA_DATA *para) {
   para->mytime->t  = 0.0;
   para->mytime->step_current = 0;
   para->mytime->t_start = clock();
+  para->mytime->step_mean = 0;
+  para->mytime->t_mean = 0.0;
+  para->mytime->dt_adapt = 0; // Fixed time step size
+  para->mytime->cfl_max = (REAL) 1.0; // Maximum CFL number if dt is adapted
+  para->mytime->dif_max = (REAL) 1.0; // Maximum diffusion number if dt is adapted
+  para->mytime->dt_min = 0; // No limits of the adaptive time step size
+  para->mytime->dt_max = 0;
 
   para->prob->alpha = (REAL) 2.376e-5; // Thermal diffusity
   para->prob->diff = (REAL) 0.00001;
@@ -86,6 +93,19 @@ void set_default_parameter(PARA_DATA *para) {
 
   para->solv->check_residual = 0; // Donot check residual */
   para->solv->solver = GS; // Gauss-Seidel Solver
+  para->solv->p_tol = 0; // Default tolerance of each pressure solver
+  para->solv->p_max_iter = 0; // Default iterations of each pressure solver
+  para->solv->vel_tol = 0; // Fixed sweeps for velocity
+  para->solv->vel_max_iter = 0; // One forward and backward sweep for velocity
+  para->solv->temp_tol = 0; // Fixed sweeps for temperature
+  para->solv->temp_max_iter = 0; // One forward and backward sweep for temperature
+  para->solv->trace_tol = 0; // Fixed sweeps for trace substances
+  para->solv->trace_max_iter = 0; // One forward and backward sweep for trace
+  para->solv->mg_cycle = VCYCLE; // V-cycle for multigrid solver
+  para->solv->pcg_precond = IC; // Incomplete Cholesky for PCG solver
+  para->solv->fft_p = 1; // FFT pressure solver if the case allows
+  para->solv->p_extrap = 0; // Start pressure solver from last pressure
+  para->solv->stencil = 0; // Separate arrays of coefficients
   para->solv->interpolation = BILINEAR; // Bilinear interpolation
 
   // Default values for Input
@@ -122,60 +142,35 @@ int set_initial_data(PARA_DATA *para, REAL **var, int **BINDEX) {
   int i; 
   int size = (para->geom->imax+2)*(para->geom->jmax+2)*(para->geom->kmax+2);
   int flag = 0;
-  
+  CELL_MASK *mask = cell_mask(para);
+
+  if(mask==NULL) return 1;
+
   para->mytime->t = 0.0;
   para->mytime->step_current = 0;
   para->outp->cal_mean = 0;
 
   /****************************************************************************
   | Set inital value for FFD variables
+  | All the variables are 0 except for the ones set below. The optional
+  | variables are allocated with 0 when they are used.
   ****************************************************************************/
+  reset_fields(var);
+
   for(i=0; i<size; i++) {
-    var[GX][i]     = 0.0;
-    var[GY][i]     = 0.0;
-    var[GZ][i]     = 0.0;
     var[VX][i]     = para->init->u;
     var[VY][i]     = para->init->v;
     var[VZ][i]     = para->init->w;
-    var[VXM][i]    = 0.0;
-    var[VYM][i]    = 0.0;
-    var[VZM][i]    = 0.0;
-    var[VXS][i]    = 0.0;
-    var[VYS][i]    = 0.0;
-    var[VZS][i]    = 0.0;
     var[TEMP][i]   = para->init->T;
-    var[TEMPM][i]  = 0.0;
-    var[TEMPS][i]  = 0.0;
-    var[IP][i]     = 0.0;
-    var[AP][i]     = 0.0;
-    var[AW][i]     = 0.0;
-    var[AE][i]     = 0.0;
-    var[AS][i]     = 0.0;
-    var[AN][i]     = 0.0;
-    var[AB][i]     = 0.0;
-    var[AF][i]     = 0.0;
-    var[B][i]      = 0.0;
-    var[AP0][i]    = 0.0;
-    var[TMP1][i]   = 0.0;
-    var[TMP2][i]   = 0.0;
-    var[TMP3][i]   = 0.0;
-    var[PP][i]     = 0.0;
-    var[FLAGP][i]  = -1.0;
-    var[FLAGU][i]  = -1.0;
-    var[FLAGV][i]  = -1.0;
-    var[FLAGW][i]  = -1.0;
-    var[VXBC][i]   = 0.0;
-    var[VYBC][i]   = 0.0;
-    var[VZBC][i]   = 0.0;
-    var[TEMPBC][i] = 0.0;
-    var[QFLUXBC][i]= 0.0;
-    var[QFLUX][i]  = 0.0;
+    mask[i]        = 0; // FLUID at all locations
   }
 
   /****************************************************************************
   | Read the configurations defined by SCI 
   ****************************************************************************/
   if(para->inpu->parameter_file_format == SCI) {
+    // The boundary cells of the files are collected in BINDEX
+    if(resize_index(BINDEX, size)!=0) return 1;
     flag = read_sci_input(para, var, BINDEX);
     if(flag != 0) {
       sprintf(msg, "set_inital_data(): Could not read file %s", 
@@ -188,7 +183,48 @@ int set_initial_data(PARA_DATA *para, REAL **var, int **BINDEX) {
       ffd_log("set_inital_data(): Could not read zeroone file", FFD_ERROR);
       return flag; 
     }
-    mark_cell(para, var);
+    mark_cell(para);
+  }
+
+  /****************************************************************************
+  | Calculate the geometry of the stencils used in every time step
+  ****************************************************************************/
+  flag = set_geometry_coef(para, var);
+  if(flag != 0) {
+    ffd_log("set_initial_data(): Could not calculate the geometry of the "
+            "stencils", FFD_ERROR);
+    return flag;
+  }
+
+  /****************************************************************************
+  | Build the table of boundary faces used by the boundary conditions
+  ****************************************************************************/
+  flag = set_boundary_cells(para, BINDEX);
+  if(flag != 0) {
+    ffd_log("set_initial_data(): Could not build the table of boundary "
+            "faces", FFD_ERROR);
+    return flag;
+  }
+  // BINDEX only needs to keep the boundary cells from now on
+  if(resize_index(BINDEX, para->geom->index)!=0) return 1;
+
+  /****************************************************************************
+  | Calculate the wall distance and turbulent viscosity of the zero equation
+  | model
+  ****************************************************************************/
+  if(para->prob->tur_model==CHEN) {
+    flag = set_wall_distance(para, var);
+    if(flag != 0) {
+      ffd_log("set_initial_data(): Could not calculate the wall distance",
+              FFD_ERROR);
+      return flag;
+    }
+    flag = set_nu_t_chen_zero_equ(para, var);
+    if(flag != 0) {
+      ffd_log("set_initial_data(): Could not calculate the turbulent "
+              "viscosity", FFD_ERROR);
+      return flag;
+    }
   }
 
   /****************************************************************************
@@ -201,7 +237,8 @@ int set_initial_data(PARA_DATA *para, REAL **var, int **BINDEX) {
         "para->sens->senVal", FFD_ERROR);
       return -1;
     }
-    para->sens->senValMean = (REAL *) malloc(para->sens->nb_sensor*sizeof(REAL));
+    para->sens->senValMean = (double *) malloc(para->sens->nb_sensor
+                                               * sizeof(double));
     if(para->sens->senValMean==NULL) {
       ffd_log("set_initial_data(): Could not allocate memory for "
         "para->sens->senValMean", FFD_ERROR);
@@ -215,7 +252,7 @@ int set_initial_data(PARA_DATA *para, REAL **var, int **BINDEX) {
   if(para->bc->nb_port>0&&para->bc->nb_Xi>0) {
     para->bc->XiPort = (REAL **) malloc(sizeof(REAL *)*para->bc->nb_port);
     para->bc->XiPortAve = (REAL **) malloc(sizeof(REAL *)*para->bc->nb_port);
-    para->bc->XiPortMean = (REAL **) malloc(sizeof(REAL *)*para->bc->nb_port);
+    para->bc->XiPortMean = (double **) malloc(sizeof(double *)*para->bc->nb_port);
     if(para->bc->XiPort==NULL || para->bc->XiPortAve==NULL 
        || para->bc->XiPortMean) {
       ffd_log("set_initial_data(): Could not allocate memory for XiPort.",
@@ -226,7 +263,7 @@ int set_initial_data(PARA_DATA *para, REAL **var, int **BINDEX) {
     for(i=0; i<para->bc->nb_port; i++) {
       para->bc->XiPort[i] = (REAL *) malloc(sizeof(REAL)*para->bc->nb_Xi);
       para->bc->XiPortAve[i] = (REAL *) malloc(sizeof(REAL)*para->bc->nb_Xi);
-      para->bc->XiPortMean[i] = (REAL *) malloc(sizeof(REAL)*para->bc->nb_Xi);
+      para->bc->XiPortMean[i] = (double *) malloc(sizeof(double)*para->bc->nb_Xi);
       if(para->bc->XiPort[i]==NULL || para->bc->XiPortAve[i]==NULL 
          || para->bc->XiPortMean[i]) {
         ffd_log("set_initial_data(): Could not allocate memory for XiPort[i].",
@@ -242,7 +279,7 @@ int set_initial_data(PARA_DATA *para, REAL **var, int **BINDEX) {
   if(para->bc->nb_port>0&&para->bc->nb_C>0) {
     para->bc->CPort = (REAL **) malloc(sizeof(REAL *)*para->bc->nb_port);
     para->bc->CPortAve = (REAL **) malloc(sizeof(REAL *)*para->bc->nb_port);
-    para->bc->CPortMean = (REAL **) malloc(sizeof(REAL *)*para->bc->nb_port);
+    para->bc->CPortMean = (double **) malloc(sizeof(double *)*para->bc->nb_port);
     if(para->bc->CPort==NULL || para->bc->CPortAve==NULL 
        || para->bc->CPortMean) {
       ffd_log("set_initial_data(): Could not allocate memory for CPort.",
@@ -253,7 +290,7 @@ int set_initial_data(PARA_DATA *para, REAL **var, int **BINDEX) {
     for(i=0; i<para->bc->nb_port; i++) {
       para->bc->CPort[i] = (REAL *) malloc(sizeof(REAL)*para->bc->nb_C);
       para->bc->CPortAve[i] = (REAL *) malloc(sizeof(REAL)*para->bc->nb_C);
-      para->bc->CPortMean[i] = (REAL *) malloc(sizeof(REAL)*para->bc->nb_C);
+      para->bc->CPortMean[i] = (double *) malloc(sizeof(double)*para->bc->nb_C);
       if(para->bc->CPort[i]==NULL || para->bc->CPortAve[i]==NULL 
          || para->bc->CPortMean[i]) {
         ffd_log("set_initial_data(): Could not allocate memory for CPort[i].",
@@ -280,7 +317,7 @@ int set_initial_data(PARA_DATA *para, REAL **var, int **BINDEX) {
     /*------------------------------------------------------------------------
     | Calculate the area of boundary
     ------------------------------------------------------------------------*/
-    flag = bounary_area(para, var, BINDEX);
+    flag = bounary_area(para, BINDEX);
     if(flag != 0) {
       ffd_log("set_initial_data(): Could not get the boundary area.",
               FFD_ERROR);
@@ -38,6 +38,11 @@
 #include "sci_reader.h"
 #endif
 
+#ifndef _CHEN_ZERO_EQU_MODEL_H
+#define _CHEN_ZERO_EQU_MODEL_H
+#include "chen_zero_equ_model.h"
+#endif
+
 #ifndef _UTILITY_H
 #define _UTILITY_H
 #include "utility.h"
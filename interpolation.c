@@ -87,3 +87,65 @@ REAL interpolation_bilinear(REAL x_1, REAL y_1, REAL z_1,
 
 } // End of interpolation_bilinear()
 
+///////////////////////////////////////////////////////////////////////////////
+/// Select the interpolation of a run of departure points
+///
+/// The method is selected once for a sweep over the cells instead of once for
+/// every cell as in interpolation().
+///
+///\param para Pointer to FFD parameters
+///
+///\return Pointer to the interpolation, NULL if the method is not available
+///////////////////////////////////////////////////////////////////////////////
+INTERPOLATION_KERNEL interpolation_kernel(PARA_DATA *para) {
+  switch(para->solv->interpolation) {
+    case BILINEAR:
+      return interpolation_bilinear_run;
+    default:
+      sprintf(msg,
+        "interpolation_kernel(): the requried interpolation method %d is not "
+        "available.", para->solv->interpolation);
+      ffd_log(msg, FFD_ERROR);
+      return NULL;
+  }
+} // End of interpolation_kernel()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Bilinear interpolation at the departure points of a run of cells
+///
+/// Same as interpolation_bilinear() for each point. The loop has no calls
+/// and no branches, so that the compiler can vectorize it.
+///
+///\param para Pointer to FFD parameters
+///\param d0 Pointer to the variable for interpolation
+///\param dp Pointer to the departure points
+///\param n Number of departure points
+///\param d Pointer to the interpolated values d[0] to d[n-1]
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void interpolation_bilinear_run(PARA_DATA *para, REAL *d0,
+                                DEPARTURE_POINT *dp, int n, REAL *d) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int m, c;
+  REAL x_0, y_0, z_0, x_1, y_1, z_1;
+  REAL tmp0, tmp1;
+
+  for(m=0; m<n; m++) {
+    c = IX(dp[m].i, dp[m].j, dp[m].k);
+    x_1 = dp[m].x_1;
+    y_1 = dp[m].y_1;
+    z_1 = dp[m].z_1;
+    x_0 = (REAL) 1.0 - x_1;
+    y_0 = (REAL) 1.0 - y_1;
+    z_0 = (REAL) 1.0 - z_1;
+
+    tmp0 = x_0*(y_0*d0[c]+y_1*d0[c+IMAX])
+         + x_1*(y_0*d0[c+1]+y_1*d0[c+1+IMAX]);
+    tmp1 = x_0*(y_0*d0[c+IJMAX]+y_1*d0[c+IMAX+IJMAX])
+         + x_1*(y_0*d0[c+1+IJMAX]+y_1*d0[c+1+IMAX+IJMAX]);
+
+    d[m] = z_0*tmp0+z_1*tmp1;
+  }
+} // End of interpolation_bilinear_run()
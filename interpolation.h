@@ -26,6 +26,17 @@
 
 #include "utility.h"
 
+// Departure point of a cell in the semi-Lagrangian advection
+typedef struct {
+  int i, j, k; // Cell of the departure point, see interpolation()
+  REAL x_1, y_1, z_1; // Relative location in the cell
+}DEPARTURE_POINT;
+
+// Interpolation at the departure points of a run of cells, see
+// interpolation_kernel()
+typedef void (*INTERPOLATION_KERNEL)(PARA_DATA *para, REAL *d0,
+                                     DEPARTURE_POINT *dp, int n, REAL *d);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Entrance of interpolation
 ///
@@ -63,3 +74,26 @@ REAL interpolation(PARA_DATA *para, REAL *d0, REAL x_1, REAL y_1, REAL z_1,
 REAL interpolation_bilinear(REAL x_1, REAL y_1, REAL z_1,
                             REAL d000, REAL d010, REAL d100, REAL d110,
                             REAL d001, REAL d011, REAL d101, REAL d111);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Select the interpolation of a run of departure points
+///
+///\param para Pointer to FFD parameters
+///
+///\return Pointer to the interpolation, NULL if the method is not available
+///////////////////////////////////////////////////////////////////////////////
+INTERPOLATION_KERNEL interpolation_kernel(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Bilinear interpolation at the departure points of a run of cells
+///
+///\param para Pointer to FFD parameters
+///\param d0 Pointer to the variable for interpolation
+///\param dp Pointer to the departure points
+///\param n Number of departure points
+///\param d Pointer to the interpolated values d[0] to d[n-1]
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void interpolation_bilinear_run(PARA_DATA *para, REAL *d0,
+                                DEPARTURE_POINT *dp, int n, REAL *d);
@@ -40,17 +40,17 @@ int assign_parameter(PARA_DATA *para, char *string) {
   }
 
   if(!strcmp(tmp, "geom.Lx")) {
-    sscanf(string, "%s%f", tmp, &para->geom->Lx);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->geom->Lx);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->geom->Lx);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "geom.Ly")) {
-    sscanf(string, "%s%f", tmp, &para->geom->Ly);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->geom->Ly);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->geom->Ly);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "geom.Lz")) {
-    sscanf(string, "%s%f", tmp, &para->geom->Lz);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->geom->Lz);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->geom->Lz);
     ffd_log(msg, FFD_NORMAL);
   }
@@ -75,17 +75,17 @@ int assign_parameter(PARA_DATA *para, char *string) {
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "geom.dx")) {
-    sscanf(string, "%s%f", tmp, &para->geom->dx);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->geom->dx);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->geom->dx);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "geom.dy")) {
-    sscanf(string, "%s%f", tmp, &para->geom->dy);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->geom->dy);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->geom->dy);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "geom.dz")) {
-    sscanf(string, "%s%f", tmp, &para->geom->dz);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->geom->dz);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->geom->dz);
     ffd_log(msg, FFD_NORMAL);
   }
@@ -100,17 +100,17 @@ int assign_parameter(PARA_DATA *para, char *string) {
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "outp.v_ref")) {
-    sscanf(string, "%s%f", tmp, &para->outp->v_ref);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->outp->v_ref);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->outp->v_ref);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "outp.Temp_ref")) {
-    sscanf(string, "%s%f", tmp, &para->outp->Temp_ref);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->outp->Temp_ref);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->outp->Temp_ref);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "outp.v_length")) {
-    sscanf(string, "%s%f", tmp, &para->outp->v_length);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->outp->v_length);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->outp->v_length);
     ffd_log(msg, FFD_NORMAL);
   }
@@ -178,67 +178,67 @@ int assign_parameter(PARA_DATA *para, char *string) {
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.nu")) {
-    sscanf(string, "%s%f", tmp, &para->prob->nu);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->nu);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->nu);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.rho")) {
-    sscanf(string, "%s%f", tmp, &para->prob->rho);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->rho);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->rho);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.beta")) {
-    sscanf(string, "%s%f", tmp, &para->prob->beta);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->beta);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->beta);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.diff")) {
-    sscanf(string, "%s%f", tmp, &para->prob->diff);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->diff);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->diff);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.alpha")) {
-    sscanf(string, "%s%f", tmp, &para->prob->alpha);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->alpha);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->alpha);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.coeff_h")) {
-    sscanf(string, "%s%f", tmp, &para->prob->coeff_h);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->coeff_h);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->coeff_h);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.gravx")) {
-    sscanf(string, "%s%f", tmp, &para->prob->gravx);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->gravx);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->gravx);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.gravy")) {
-    sscanf(string, "%s%f", tmp, &para->prob->gravy);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->gravy);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->gravy);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.gravz")) {
-    sscanf(string, "%s%f", tmp, &para->prob->gravz);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->gravz);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->gravz);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.cond")) {
-    sscanf(string, "%s%f", tmp, &para->prob->cond);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->cond);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->cond);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.force")) {
-    sscanf(string, "%s%f", tmp, &para->prob->force);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->force);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->force);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.source")) {
-    sscanf(string, "%s%f", tmp, &para->prob->source);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->source);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->source);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.Cp")) {
-    sscanf(string, "%s%f", tmp, &para->prob->Cp);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->Cp);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->Cp);
     ffd_log(msg, FFD_NORMAL);
   }
@@ -264,25 +264,50 @@ int assign_parameter(PARA_DATA *para, char *string) {
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.chen_a")) {
-    sscanf(string, "%s%f", tmp, &para->prob->chen_a);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->chen_a);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->chen_a);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.Prt")) {
-    sscanf(string, "%s%f", tmp, &para->prob->Prt);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->Prt);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->Prt);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "prob.Temp_Buoyancy")) {
-    sscanf(string, "%s%f", tmp, &para->prob->Temp_Buoyancy);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->prob->Temp_Buoyancy);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->prob->Temp_Buoyancy);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "mytime.t_steady")) {
-    sscanf(string, "%s%f", tmp, &para->mytime->t_steady);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->mytime->t_steady);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->t_steady);
     ffd_log(msg, FFD_NORMAL);
   }
+  else if(!strcmp(tmp, "mytime.dt_adapt")) {
+    sscanf(string, "%s%d", tmp, &para->mytime->dt_adapt);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->mytime->dt_adapt);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "mytime.cfl_max")) {
+    sscanf(string, "%s" REAL_FMT, tmp, &para->mytime->cfl_max);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->cfl_max);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "mytime.dif_max")) {
+    sscanf(string, "%s" REAL_FMT, tmp, &para->mytime->dif_max);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->dif_max);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "mytime.dt_min")) {
+    sscanf(string, "%s%lf", tmp, &para->mytime->dt_min);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->dt_min);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "mytime.dt_max")) {
+    sscanf(string, "%s%lf", tmp, &para->mytime->dt_max);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->dt_max);
+    ffd_log(msg, FFD_NORMAL);
+  }
   else if(!strcmp(tmp, "solv.solver")) {
     sscanf(string, "%s%s", tmp, tmp2);
     sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
@@ -290,6 +315,14 @@ int assign_parameter(PARA_DATA *para, char *string) {
       para->solv->solver = GS;
     else if(!strcmp(tmp2, "TDMA")) 
       para->solv->solver = TDMA;
+    else if(!strcmp(tmp2, "MG")) 
+      para->solv->solver = MG;
+    else if(!strcmp(tmp2, "GS_RB")) 
+      para->solv->solver = GS_RB;
+    else if(!strcmp(tmp2, "PCG")) 
+      para->solv->solver = PCG;
+    else if(!strcmp(tmp2, "CHOL")) 
+      para->solv->solver = CHOL;
     else {
       sprintf(msg, "assign_parameter(): %s is not valid input for %s", tmp2, tmp);
       ffd_log(msg, FFD_ERROR);
@@ -302,6 +335,105 @@ int assign_parameter(PARA_DATA *para, char *string) {
     sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->check_residual);
     ffd_log(msg, FFD_NORMAL);
   }
+  else if(!strcmp(tmp, "solv.p_tol")) {
+    sscanf(string, "%s" REAL_FMT, tmp, &para->solv->p_tol);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->solv->p_tol);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.p_max_iter")) {
+    sscanf(string, "%s%d", tmp, &para->solv->p_max_iter);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->p_max_iter);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.vel_tol")) {
+    sscanf(string, "%s" REAL_FMT, tmp, &para->solv->vel_tol);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->solv->vel_tol);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.vel_max_iter")) {
+    sscanf(string, "%s%d", tmp, &para->solv->vel_max_iter);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->vel_max_iter);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.temp_tol")) {
+    sscanf(string, "%s" REAL_FMT, tmp, &para->solv->temp_tol);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->solv->temp_tol);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.temp_max_iter")) {
+    sscanf(string, "%s%d", tmp, &para->solv->temp_max_iter);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->temp_max_iter);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.trace_tol")) {
+    sscanf(string, "%s" REAL_FMT, tmp, &para->solv->trace_tol);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->solv->trace_tol);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.trace_max_iter")) {
+    sscanf(string, "%s%d", tmp, &para->solv->trace_max_iter);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->trace_max_iter);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.tol")) {
+    sscanf(string, "%s" REAL_FMT, tmp, &para->solv->p_tol);
+    para->solv->vel_tol = para->solv->p_tol;
+    para->solv->temp_tol = para->solv->p_tol;
+    para->solv->trace_tol = para->solv->p_tol;
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->solv->p_tol);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.max_iter")) {
+    sscanf(string, "%s%d", tmp, &para->solv->p_max_iter);
+    para->solv->vel_max_iter = para->solv->p_max_iter;
+    para->solv->temp_max_iter = para->solv->p_max_iter;
+    para->solv->trace_max_iter = para->solv->p_max_iter;
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->p_max_iter);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.mg_cycle")) {
+    sscanf(string, "%s%s", tmp, tmp2);
+    sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
+    if(!strcmp(tmp2, "V")) 
+      para->solv->mg_cycle = VCYCLE;
+    else if(!strcmp(tmp2, "W")) 
+      para->solv->mg_cycle = WCYCLE;
+    else {
+      sprintf(msg, "assign_parameter(): %s is not valid input for %s", tmp2, tmp);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+    }
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.pcg_precond")) {
+    sscanf(string, "%s%s", tmp, tmp2);
+    sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
+    if(!strcmp(tmp2, "IC")) 
+      para->solv->pcg_precond = IC;
+    else if(!strcmp(tmp2, "SSOR")) 
+      para->solv->pcg_precond = SSOR;
+    else {
+      sprintf(msg, "assign_parameter(): %s is not valid input for %s", tmp2, tmp);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+    }
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.p_extrap")) {
+    sscanf(string, "%s%d", tmp, &para->solv->p_extrap);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->p_extrap);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.stencil")) {
+    sscanf(string, "%s%d", tmp, &para->solv->stencil);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->stencil);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.fft_p")) {
+    sscanf(string, "%s%d", tmp, &para->solv->fft_p);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->fft_p);
+    ffd_log(msg, FFD_NORMAL);
+  }
   else if(!strcmp(tmp, "solv.advection_solver")) {
     sscanf(string, "%s%s", tmp, tmp2);
     sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
@@ -345,22 +477,22 @@ int assign_parameter(PARA_DATA *para, char *string) {
   | get the initial condition
   ****************************************************************************/
   else if(!strcmp(tmp, "init.T")) {
-    sscanf(string, "%s%f", tmp, &para->init->T);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->init->T);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->init->T);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "init.u")) {
-    sscanf(string, "%s%f", tmp, &para->init->u);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->init->u);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->init->u);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "init.v")) {
-    sscanf(string, "%s%f", tmp, &para->init->v);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->init->v);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->init->v);
     ffd_log(msg, FFD_NORMAL);
   }
   else if(!strcmp(tmp, "init.w")) {
-    sscanf(string, "%s%f", tmp, &para->init->w);
+    sscanf(string, "%s" REAL_FMT, tmp, &para->init->w);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->init->w);
     ffd_log(msg, FFD_NORMAL);
   }
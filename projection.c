@@ -17,86 +17,266 @@
 
 #include "projection.h"
 
+static REAL *p_ring[P_RING_SIZE]; // Pressure of the last time levels
+static int p_ring_head = 0; // Index of the latest time level
+static int p_ring_nb = 0; // Number of stored time levels
+static int p_ring_size = 0; // Number of cells of each time level
+static REAL p_ring_dt[P_RING_SIZE]; // Time step that ended at each time level
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the L2 norm of the residual of the pressure equation
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param p Pointer to pressure
+///
+///\return L2 norm of the residual in the fluid cells
+///////////////////////////////////////////////////////////////////////////////
+static double pressure_residual(PARA_DATA *para, REAL **var, REAL *p) {
+  int i, j, jj, k;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  REAL *ap = var[AP], *ae = var[AE], *aw = var[AW], *an = var[AN];
+  REAL *as = var[AS], *af = var[AF], *ab = var[AB], *b = var[B];
+  CELL_MASK *mask = para->geom->mask;
+  double r, sum = 0;
+
+  FOR_EACH_CELL_TILED
+    if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+    r = b[IX(i,j,k)] - ap[IX(i,j,k)]*p[IX(i,j,k)]
+      + ae[IX(i,j,k)]*p[IX(i+1,j,k)] + aw[IX(i,j,k)]*p[IX(i-1,j,k)]
+      + an[IX(i,j,k)]*p[IX(i,j+1,k)] + as[IX(i,j,k)]*p[IX(i,j-1,k)]
+      + af[IX(i,j,k)]*p[IX(i,j,k+1)] + ab[IX(i,j,k)]*p[IX(i,j,k-1)];
+    sum += r * r;
+  END_FOR_TILED
+
+  return sqrt(sum);
+} // End of pressure_residual()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Extrapolate the initial pressure from the last time levels
+///
+/// The pressure is extrapolated with the Lagrange polynomial through the
+/// stored time levels, whose weights follow from the current time step and
+/// the time steps of the stored levels. With a constant time step, the linear
+/// extrapolation is 2p(n)-p(n-1) and the quadratic one is
+/// 3p(n)-3p(n-1)+p(n-2). The order is reduced while fewer time levels
+/// are stored.
+///
+///\param para Pointer to FFD parameters
+///\param p Pointer to pressure
+///
+///\return Order of the extrapolation, 0 if nothing was done
+///////////////////////////////////////////////////////////////////////////////
+static int extrapolate_pressure(PARA_DATA *para, REAL *p) {
+  int i, j, k;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  CELL_MASK *mask = para->geom->mask;
+  REAL *p0, *p1, *p2;
+  REAL r0, r1, c0, c1, c2;
+  int order = min(para->solv->p_extrap, p_ring_nb-1);
+  int i1 = (p_ring_head+P_RING_SIZE-1) % P_RING_SIZE;
+  int i2 = (p_ring_head+P_RING_SIZE-2) % P_RING_SIZE;
+
+  if(order<=0) return 0;
+  if(order>P_RING_SIZE-1) order = P_RING_SIZE-1;
+
+  p0 = p_ring[p_ring_head];
+  p1 = p_ring[i1];
+  p2 = p_ring[i2];
+
+  /****************************************************************************
+  | Weights of the time levels n, n-1 and n-2 relative to the time step
+  | between the levels n-1 and n
+  ****************************************************************************/
+  r0 = para->mytime->dt / p_ring_dt[p_ring_head];
+  r1 = p_ring_dt[i1] / p_ring_dt[p_ring_head];
+  if(order==1) {
+    c0 = 1 + r0;
+    c1 = -r0;
+    c2 = 0;
+  }
+  else {
+    c0 = (r0+1) * (r0+1+r1) / (1+r1);
+    c1 = -r0 * (r0+1+r1) / r1;
+    c2 = r0 * (r0+1) / ((1+r1)*r1);
+  }
+
+  FOR_EACH_CELL
+    if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+    if(order==1)
+      p[IX(i,j,k)] = c0*p0[IX(i,j,k)] + c1*p1[IX(i,j,k)];
+    else
+      p[IX(i,j,k)] = c0*p0[IX(i,j,k)] + c1*p1[IX(i,j,k)] + c2*p2[IX(i,j,k)];
+  END_FOR
+
+  return order;
+} // End of extrapolate_pressure()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Store the pressure of the current time level
+///
+/// The time step of the current time level is stored with the pressure.
+///
+///\param para Pointer to FFD parameters
+///\param p Pointer to pressure
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int store_pressure(PARA_DATA *para, REAL *p) {
+  int i, size = (para->geom->imax+2) * (para->geom->jmax+2)
+              * (para->geom->kmax+2);
+
+  if(p_ring_size!=size) {
+    free_projection_data();
+    for(i=0; i<P_RING_SIZE; i++) {
+      p_ring[i] = (REAL *) malloc(size*sizeof(REAL));
+      if(p_ring[i]==NULL) {
+        ffd_log("store_pressure(): Could not allocate memory for the "
+                "pressure of previous time levels.", FFD_ERROR);
+        free_projection_data();
+        return 1;
+      }
+    }
+    p_ring_size = size;
+  }
+
+  p_ring_head = (p_ring_head+1) % P_RING_SIZE;
+  memcpy(p_ring[p_ring_head], p, size*sizeof(REAL));
+  p_ring_dt[p_ring_head] = para->mytime->dt;
+  if(p_ring_nb<P_RING_SIZE) p_ring_nb++;
+
+  return 0;
+} // End of store_pressure()
+
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Project the velocity
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int project(PARA_DATA *para, REAL **var, int **BINDEX) {
-  int i, j, k;
+int project(PARA_DATA *para, REAL **var) {
+  int i, j, k, r;
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL dt= para->mytime->dt;
-  REAL *x = var[X], *y = var[Y], *z = var[Z];
-  REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ]; 
+  REAL *dx = para->geom->mesh->dx, *dy = para->geom->mesh->dy;
+  REAL *dz = para->geom->mesh->dz;
+  REAL *rdxc = para->geom->mesh->rdxc, *rdyc = para->geom->mesh->rdyc;
+  REAL *rdzc = para->geom->mesh->rdzc;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];  
   REAL *p = var[IP], *b = var[B], *ap = var[AP], *ab = var[AB], *af = var[AF];
   REAL *ae = var[AE], *aw =var[AW], *an = var[AN], *as = var[AS];
-  REAL dxe,dxw, dyn,dys,dzf,dzb,Dx,Dy,Dz;
+  REAL *gpe = var[GPE], *gpn = var[GPN], *gpf = var[GPF];
+  REAL Dx,Dy,Dz;
+  int order = 0, iter;
+  double res_old = 0, res_guess = 0, res_new, saved;
   REAL residual = 1.0;  
-  REAL *flagu = var[FLAGU],*flagv = var[FLAGV],*flagw = var[FLAGW];
+  RUN_LIST *runs_u = cell_run(para, MASK_U);
+  RUN_LIST *runs_v = cell_run(para, MASK_V);
+  RUN_LIST *runs_w = cell_run(para, MASK_W);
   
   /****************************************************************************
   | Calculate all coefficents
   ****************************************************************************/
   FOR_EACH_CELL
-    dxe =  x[IX(i+1,j,  k)]   -  x[IX(i,  j,  k)];
-    dxw =  x[IX(i,  j,  k)]   -  x[IX(i-1,j,  k)];
-    dyn =  y[IX(i,  j+1,k)]   -  y[IX(i,  j,  k)];
-    dys =  y[IX(i,  j,  k)]   -  y[IX(i,  j-1,k)];
-    dzf =  z[IX(i,  j,  k+1)] -  z[IX(i,  j,  k)];
-    dzb =  z[IX(i,  j,  k)]   -  z[IX(i,  j,  k-1)];
-    Dx  = gx[IX(i,  j,  k)]   - gx[IX(i-1,j,  k)];
-    Dy  = gy[IX(i,  j,  k)]   - gy[IX(i,  j-1,k)];
-    Dz  = gz[IX(i,  j,  k)]   - gz[IX(i,  j,  k-1)];
+    Dx  = dx[i];
+    Dy  = dy[j];
+    Dz  = dz[k];
  
-    ae[IX(i,j,k)] = Dy*Dz/dxe;
-    aw[IX(i,j,k)] = Dy*Dz/dxw;      
-    an[IX(i,j,k)] = Dx*Dz/dyn;
-    as[IX(i,j,k)] = Dx*Dz/dys;
-    af[IX(i,j,k)] = Dx*Dy/dzf;
-    ab[IX(i,j,k)] = Dx*Dy/dzb;
-    b[IX(i,j,k)] = Dx*Dy*Dz/dt*((u[IX(i-1,j,k)]-u[IX(i,j,k)])/Dx
-                 + (v[IX(i,j-1,k)]-v[IX(i,j,k)])/Dy
-                 + (w[IX(i,j,k-1)]-w[IX(i,j,k)])/Dz);
+    ae[IX(i,j,k)] = gpe[IX(i,  j,  k)];
+    aw[IX(i,j,k)] = gpe[IX(i-1,j,  k)];
+    an[IX(i,j,k)] = gpn[IX(i,  j,  k)];
+    as[IX(i,j,k)] = gpn[IX(i,  j-1,k)];
+    af[IX(i,j,k)] = gpf[IX(i,  j,  k)];
+    ab[IX(i,j,k)] = gpf[IX(i,  j,  k-1)];
+    b[IX(i,j,k)] = (Dy*Dz*(u[IX(i-1,j,k)]-u[IX(i,j,k)])
+                 + Dx*Dz*(v[IX(i,j-1,k)]-v[IX(i,j,k)])
+                 + Dx*Dy*(w[IX(i,j,k-1)]-w[IX(i,j,k)])) / dt;
   END_FOR
 
   /****************************************************************************
   | Projection step
   ****************************************************************************/
-  set_bnd_pressure(para, var, p,BINDEX); 
+  set_bnd_pressure(para, var, p); 
 
   FOR_EACH_CELL    
     ap[IX(i,j,k)] = ae[IX(i,j,k)] + aw[IX(i,j,k)] + as[IX(i,j,k)] + an[IX(i,j,k)]
                   + af[IX(i,j,k)] + ab[IX(i,j,k)];
   END_FOR
 
-  GS_P(para, var, IP, p);
-  set_bnd_pressure(para, var, p,BINDEX); 
+  /****************************************************************************
+  | Extrapolate the initial pressure from the previous time levels
+  ****************************************************************************/
+  if(para->solv->p_extrap>0) {
+    if(para->solv->check_residual==1)
+      res_old = pressure_residual(para, var, p);
+    order = extrapolate_pressure(para, p);
+    if(order>0 && para->solv->check_residual==1)
+      res_guess = pressure_residual(para, var, p);
+  }
+
+  equ_solver(para, var, IP, p);
+  set_bnd_pressure(para, var, p); 
+
+  if(para->solv->p_extrap>0) {
+    /*-------------------------------------------------------------------------
+    | Estimate the saved iterations from the convergence rate of the solver
+    -------------------------------------------------------------------------*/
+    iter = para->solv->iter;
+    if(order>0 && para->solv->check_residual==1 && iter>0
+       && res_guess>0 && res_old>res_guess) {
+      res_new = pressure_residual(para, var, p);
+      if(res_new>0 && res_new<res_guess) {
+        saved = log(res_old/res_guess) / log(res_guess/res_new) * iter;
+        sprintf(msg, "project(): Pressure extrapolated with order %d saved "
+                "about %.1f of %d iterations", order, saved, iter);
+        ffd_log(msg, FFD_NORMAL);
+      }
+    }
+    store_pressure(para, p);
+  }
    
   /****************************************************************************
   | Correct the velocity
   ****************************************************************************/
-  FOR_U_CELL
-    if (flagu[IX(i,j,k)]>=0) continue;
-    u[IX(i,j,k)] -= dt*(p[IX(i+1,j,k)]-p[IX(i,j,k)]) / (x[IX(i+1,j,k)]-x[IX(i,j,k)]);
+  if(runs_u==NULL || runs_v==NULL || runs_w==NULL) return 1;
+
+  FOR_EACH_RUN(runs_u)
+    u[IX(i,j,k)] -= dt*(p[IX(i+1,j,k)]-p[IX(i,j,k)]) * rdxc[i];
   END_FOR
 
-  FOR_V_CELL
-    if (flagv[IX(i,j,k)]>=0) continue;
-    v[IX(i,j,k)] -= dt*(p[IX(i,j+1,k)]-p[IX(i,j,k)]) / (y[IX(i,j+1,k)]-y[IX(i,j,k)]);
+  FOR_EACH_RUN(runs_v)
+    v[IX(i,j,k)] -= dt*(p[IX(i,j+1,k)]-p[IX(i,j,k)]) * rdyc[j];
   END_FOR
 
-  FOR_W_CELL
-    if (flagw[IX(i,j,k)]>=0) continue;
-    w[IX(i,j,k)] -= dt*(p[IX(i,j,k+1)]-p[IX(i,j,k)]) / (z[IX(i,j,k+1)]-z[IX(i,j,k)]);
+  FOR_EACH_RUN(runs_w)
+    w[IX(i,j,k)] -= dt*(p[IX(i,j,k+1)]-p[IX(i,j,k)]) * rdzc[k];
   END_FOR
 
   return 0;
 } // End of project( )
 
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the pressure of previous time levels
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_projection_data() {
+  int i;
+
+  for(i=0; i<P_RING_SIZE; i++) {
+    if(p_ring[i]!=NULL) free(p_ring[i]);
+    p_ring[i] = NULL;
+  }
+  p_ring_size = 0;
+  p_ring_nb = 0;
+  p_ring_head = 0;
+} // End of free_projection_data()
@@ -25,7 +25,7 @@
 
 #ifndef _SOLVER_H
 #define _SOLVER_H
-#include "solver_gs.h"
+#include "solver.h"
 #endif
 
 #ifndef _SOLVER_TDMA_H
@@ -43,13 +43,21 @@
 #include "boundary.h"
 #endif
 
+#define P_RING_SIZE 3 // Number of stored time levels of pressure
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Project the velocity
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int project(PARA_DATA *para, REAL **var, int **BINDEX);
\ No newline at end of file
+int project(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the pressure of previous time levels
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_projection_data();
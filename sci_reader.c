@@ -40,7 +40,8 @@ int read_sci_max(PARA_DATA *para, REAL **var) {
 
   // Get the first line for the length in X, Y and Z directions
   fgets(string, 400, file_params);
-  sscanf(string,"%f %f %f", &para->geom->Lx, &para->geom->Ly, &para->geom->Lz);
+  sscanf(string, REAL_FMT REAL_FMT REAL_FMT, &para->geom->Lx, &para->geom->Ly,
+         &para->geom->Lz);
 
   // Get the second line for the number of cells in X, Y and Z directions
   fgets(string, 400, file_params);
@@ -65,12 +66,6 @@ int read_sci_max(PARA_DATA *para, REAL **var) {
 int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
   int i, j, k;
   int ii,ij,ik;
-  REAL tempx, tempy, tempz;
-  REAL Lx = para->geom->Lx;
-  REAL Ly = para->geom->Ly;
-  REAL Lz = para->geom->Lz;
-  REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ];
-  REAL *x = var[X], *y = var[Y], *z = var[Z];
   int IWWALL,IEWALL,ISWALL,INWALL,IBWALL,ITWALL;
   int SI,SJ,SK,EI,EJ,EK,FLTMP;
   REAL TMP,MASS,U,V,W;
@@ -83,10 +78,12 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2); 
   char string[400];
   REAL *delx, *dely, *delz;
-  REAL *flagp = var[FLAGP];
+  CELL_MASK *mask = cell_mask(para);
   int bcnameid = -1;
   char **outletName, **inletName;
 
+  if(mask==NULL) return 1;
+
   // Open the parameter file
   if((file_params=fopen(para->inpu->parameter_file_name,"r")) == NULL ) { 
     sprintf(msg,"read_sci_input(): Could not open the file \"%s\".", 
@@ -122,64 +119,19 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
   delz[0]=0;
 
   // Read cell dimensions in X, Y, Z directions
-  for(i=1; i<=imax; i++) fscanf(file_params, "%f", &delx[i]); 
+  for(i=1; i<=imax; i++) fscanf(file_params, REAL_FMT, &delx[i]); 
   fscanf(file_params,"\n");
-  for(j=1; j<=jmax; j++) fscanf(file_params, "%f", &dely[j]); 
+  for(j=1; j<=jmax; j++) fscanf(file_params, REAL_FMT, &dely[j]); 
   fscanf(file_params,"\n");
-  for(k=1; k<=kmax; k++) fscanf(file_params, "%f", &delz[k]); 
+  for(k=1; k<=kmax; k++) fscanf(file_params, REAL_FMT, &delz[k]); 
   fscanf(file_params,"\n");
 
-  // Store the locations of grid cell surfaces
-  // Fixme: use one "temp", not tempx tempy and tempz
-  tempx = 0.0; tempy = 0.0; tempz = 0.0;
-  for(i=0; i<=imax+1; i++) {
-    tempx += delx[i];
-    if(i>=imax) tempx = Lx;
-    for(j=0; j<=jmax+1; j++)
-      for(k=0; k<=kmax+1; k++) var[GX][IX(i,j,k)]=tempx;
-  }
-
-  for(j=0; j<=jmax+1; j++) {
-    tempy += dely[j];
-    if(j>=jmax) tempy = Ly;
-    for(i=0; i<=imax+1; i++)
-      for(k=0; k<=kmax+1; k++) var[GY][IX(i,j,k)] = tempy;
-  }
-
-  for(k=0; k<=kmax+1; k++) {
-    tempz += delz[k];
-    if(k>=kmax) tempz = Lz;
-    for(i=0; i<=imax+1; i++)
-      for(j=0; j<=jmax+1; j++) var[GZ][IX(i,j,k)] = tempz;
+  // Store the locations of grid cell surfaces and cell centers
+  if(set_mesh(para, delx, dely, delz)!=0) {
+    ffd_log("read_sci_input(): Could not build the mesh.", FFD_ERROR);
+    return 1;
   }
 
-  /*****************************************************************************
-  | Convert the coordinates for cell furfaces to 
-  | the coordinates for the cell center
-  *****************************************************************************/
-  FOR_ALL_CELL
-    if(i<1) 
-      x[IX(i,j,k)] = 0;
-    else if(i>imax) 
-      x[IX(i,j,k)] = Lx;
-    else 
-      x[IX(i,j,k)] = (REAL) 0.5 * (gx[IX(i,j,k)]+gx[IX(i-1,j,k)]);
-
-    if(j<1)  
-      y[IX(i,j,k)] = 0;
-    else if(j>jmax) 
-      y[IX(i,j,k)] = Ly;
-    else 
-      y[IX(i,j,k)] = (REAL) 0.5 * (gy[IX(i,j,k)]+gy[IX(i,j-1,k)]);
-
-    if(k<1)  
-      z[IX(i,j,k)] = 0;
-    else if(k>kmax) 
-      z[IX(i,j,k)] = Lz;
-    else 
-      z[IX(i,j,k)] = (REAL) 0.5 * (gz[IX(i,j,k)]+gz[IX(i,j,k-1)]);
-  END_FOR
-
   // Get the wall property
   fgets(string, 400, file_params);
   sscanf(string,"%d%d%d%d%d%d", &IWWALL, &IEWALL, &ISWALL, 
@@ -227,7 +179,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       inletName[i] = (char*)malloc((j+1)*sizeof(char));
       strncpy(inletName[i], (const char*)string, j);
       // Add an ending
-      inletName[i] = '\0';
+      inletName[i][j] = '\0';
       sprintf(msg, "read_sci_input(): inletName[%d]=%s",
               bcnameid, inletName[i]);
       ffd_log(msg, FFD_NORMAL);
@@ -235,7 +187,8 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       | Get the boundary conditions
       .......................................................................*/
       fgets(string, 400, file_params);
-      sscanf(string,"%d%d%d%d%d%d%f%f%f%f%f", &SI, &SJ, &SK, &EI, 
+      sscanf(string, "%d%d%d%d%d%d" REAL_FMT REAL_FMT REAL_FMT REAL_FMT
+             REAL_FMT, &SI, &SJ, &SK, &EI, 
              &EJ, &EK, &TMP, &MASS, &U, &V, &W);
       sprintf(msg, "read_sci_input(): VX=%f, VY=%f, VX=%f, T=%f, Xi=%f", 
               U, V, W, TMP, MASS);
@@ -275,7 +228,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
             var[VXBC][IX(ii,ij,ik)] = U; 
             var[VYBC][IX(ii,ij,ik)] = V; 
             var[VZBC][IX(ii,ij,ik)] = W;
-            flagp[IX(ii,ij,ik)] = INLET; // Cell flag to be inlet
+            SET_CELL_TYPE(mask[IX(ii,ij,ik)], INLET, MASK_P); // Cell to be inlet
           } // End of assigning the inlet B.C. for each cell 
 
     } // End of loop for each inlet boundary
@@ -316,7 +269,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       }
       strncpy(outletName[i], (const char*)string, j);
       // Add an ending
-      outletName[i] = '\0';
+      outletName[i][j] = '\0';
       sprintf(msg, "read_sci_input(): outletName[%d]=%s",
               bcnameid, outletName[i]);
       ffd_log(msg, FFD_NORMAL);
@@ -324,7 +277,8 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       | Get the boundary conditions
       .......................................................................*/
       fgets(string, 400, file_params);
-      sscanf(string,"%d%d%d%d%d%d%f%f%f%f%f", 
+      sscanf(string, "%d%d%d%d%d%d" REAL_FMT REAL_FMT REAL_FMT REAL_FMT
+             REAL_FMT, 
              &SI, &SJ, &SK, &EI, 
              &EJ, &EK, &TMP, &MASS, &U, &V, &W);
 
@@ -367,7 +321,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
             var[VXBC][IX(ii,ij,ik)] = U; 
             var[VYBC][IX(ii,ij,ik)] = V; 
             var[VZBC][IX(ii,ij,ik)] = W;
-            flagp[IX(ii,ij,ik)] = OUTLET;
+            SET_CELL_TYPE(mask[IX(ii,ij,ik)], OUTLET, MASK_P);
           } // End of assigning the outlet B.C. for each cell 
     } // End of loop for each outlet boundary
   } // End of setting outlet boundary
@@ -390,7 +344,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
     }
     // Copy the inlet names
     for(i=0; i<para->bc->nb_inlet; i++) {
-      para->bc->portName[i] = (char*) malloc(sizeof(char)*(sizeof(inletName[i])+1));
+      para->bc->portName[i] = (char*) malloc(sizeof(char)*(strlen(inletName[i])+1));
       if(para->bc->portName[i]==NULL) {
         ffd_log("read_sci_input():"
                 "Could not allocate memory for para->bc->portName.",
@@ -407,7 +361,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
     j = para->bc->nb_inlet;
     // Copy the outlet names
     for(i=0; i<para->bc->nb_outlet; i++) {      
-      para->bc->portName[i+j] = (char*) malloc(sizeof(char)*(sizeof(outletName[i])+1));
+      para->bc->portName[i+j] = (char*) malloc(sizeof(char)*(strlen(outletName[i])+1));
       if(para->bc->portName[i+j]==NULL) {
         ffd_log("read_sci_input(): Could not allocate memory for para->bc->portName.",
         FFD_ERROR);
@@ -444,7 +398,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       return 1;
     }
 
-    para->bc->velPortMean = (REAL*) malloc(para->bc->nb_port*sizeof(REAL));
+    para->bc->velPortMean = (double*) malloc(para->bc->nb_port*sizeof(double));
     if(para->bc->velPortMean==NULL) {
       ffd_log("read_sci_input(): Could not allocate memory for para->bc->velPortMean.",
       FFD_ERROR);
@@ -465,7 +419,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       return 1;
     }
     
-    para->bc->TPortMean = (REAL*) malloc(para->bc->nb_port*sizeof(REAL));
+    para->bc->TPortMean = (double*) malloc(para->bc->nb_port*sizeof(double));
     if(para->bc->TPortMean==NULL) {
       ffd_log("read_sci_input(): Could not allocate memory for para->bc->TPortMean.",
       FFD_ERROR);
@@ -519,12 +473,15 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       // X_index_start, Y_index_Start, Z_index_Start, 
       // X_index_End, Y_index_End, Z_index_End, 
       // Thermal Codition (0: Flux; 1:Temperature), Value of thermal conditon
-      sscanf(string,"%d%d%d%d%d%d%d%f", &SI, &SJ, &SK, &EI, &EJ, &EK, 
+      sscanf(string, "%d%d%d%d%d%d%d" REAL_FMT, &SI, &SJ, &SK, &EI, &EJ, &EK, 
                                         &FLTMP, &TMP);
       sprintf(msg, "read_sci_input(): VX=%f, VY=%f, VX=%f, ThermalBC=%d, T/q_dot=%f, Xi=%f", 
               U, V, W, FLTMP, TMP, MASS);
       ffd_log(msg, FFD_NORMAL);
 
+      // The heat flux on the boundary is only stored if it is used
+      if(FLTMP==0 && require_field(var, QFLUXBC)==NULL) return 1;
+
       if(SI==1) {   
         SI=0;
         if(EI>=imax) EI=EI+SI+1;
@@ -574,7 +531,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
                 return 1;
             }
 
-            flagp[IX(ii,ij,ik)] = SOLID; // Flag for solid
+            SET_CELL_TYPE(mask[IX(ii,ij,ik)], SOLID, MASK_P); // Solid
           } // End of assigning value for internal solid block
     }
   }
@@ -611,7 +568,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       ffd_log("read_sci_input(): Could not allocate memory for "
       "para->bc->temHeaAve.", FFD_ERROR);
     
-    para->bc->temHeaMean = (REAL*) malloc(para->bc->nb_wall*sizeof(REAL));
+    para->bc->temHeaMean = (double*) malloc(para->bc->nb_wall*sizeof(double));
     if(para->bc->temHeaMean==NULL)
       ffd_log("read_sci_input(): Could not allocate memory for "
       "para->bc->temHeaMean.", FFD_ERROR);
@@ -643,12 +600,14 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       // X_index_End, Y_index_End, Z_index_End, 
       // Thermal Codition (0: Flux; 1:Temperature), Value of thermal conditon
       fgets(string, 400, file_params);
-      sscanf(string,"%d%d%d%d%d%d%d%f", &SI, &SJ, &SK, &EI, 
+      sscanf(string, "%d%d%d%d%d%d%d" REAL_FMT, &SI, &SJ, &SK, &EI, 
              &EJ, &EK, &FLTMP, &TMP);
       sprintf(msg, "read_sci_input(): ThermalBC=%d, T/q_dot=%f", 
               FLTMP, TMP);
       ffd_log(msg, FFD_NORMAL);
 
+      if(FLTMP==0 && require_field(var, QFLUXBC)==NULL) return 1;
+
       // Reset X index
       if(SI==1) {
         SI = 0;
@@ -675,8 +634,8 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
       for(ii=SI; ii<=EI; ii++)
         for(ij=SJ; ij<=EJ; ij++)
           for(ik=SK; ik<=EK; ik++) {
-            // If cell hasn't been updated (default value -1)
-            if(flagp[IX(ii,ij,ik)]<0) {
+            // If cell hasn't been updated (default FLUID)
+            if(IS_FLUID(mask[IX(ii,ij,ik)], MASK_P)) {
               BINDEX[0][index] = ii;
               BINDEX[1][index] = ij;
               BINDEX[2][index] = ik;
@@ -686,7 +645,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
               index++;  
 
               // Set the cell to solid
-              flagp[IX(ii,ij,ik)] = SOLID; 
+              SET_CELL_TYPE(mask[IX(ii,ij,ik)], SOLID, MASK_P);
               if(FLTMP==1) var[TEMPBC][IX(ii,ij,ik)] = TMP; 
               if(FLTMP==0) var[QFLUXBC][IX(ii,ij,ik)] = TMP;
             }
@@ -705,7 +664,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
 
   
   if(para->bc->nb_source!=0) {
-    sscanf(string,"%s%d%d%d%d%d%d%f", 
+    sscanf(string, "%s%d%d%d%d%d%d" REAL_FMT, 
            &name, &SI, &SJ, &SK, &EI, &EJ, &EK, &MASS);
     bcnameid++;
  
@@ -833,7 +792,9 @@ int read_sci_zeroone(PARA_DATA *para, REAL **var, int **BINDEX) {
   int kmax = para->geom->kmax;
   int index = para->geom->index;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2); 
-  REAL *flagp = var[FLAGP];
+  CELL_MASK *mask = cell_mask(para);
+
+  if(mask==NULL) return 1;
 
   if( (file_params=fopen("zeroone.dat","r")) == NULL )
   {
@@ -852,10 +813,17 @@ int read_sci_zeroone(PARA_DATA *para, REAL **var, int **BINDEX) {
         // mark=1 block cell;mark=0 fluid cell
 
         if(mark==1) {
-          flagp[IX(i,j,k)] = SOLID;
+          // The block cells are adiabatic and do not belong to a boundary
+          if(require_field(var, QFLUXBC)==NULL) {
+            fclose(file_params);
+            return 1;
+          }
+          SET_CELL_TYPE(mask[IX(i,j,k)], SOLID, MASK_P);
           BINDEX[0][index] = i;
           BINDEX[1][index] = j;
           BINDEX[2][index] = k;
+          BINDEX[3][index] = 0;
+          BINDEX[4][index] = -1;
           index++;
         }
         delcount++;
@@ -880,71 +848,56 @@ int read_sci_zeroone(PARA_DATA *para, REAL **var, int **BINDEX) {
 /// Identify the properties of cells
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-void mark_cell(PARA_DATA *para, REAL **var) {
-  int i,j, k;
+void mark_cell(PARA_DATA *para) {
+  int i,j, k, t;
   int imax = para->geom->imax;
   int jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2); 
-  REAL *flagu = var[FLAGU],*flagv = var[FLAGV],*flagw = var[FLAGW];
-  REAL *flagp = var[FLAGP];
-
-  flagp[IX(0,0,0)] = SOLID;
-  flagp[IX(0,0,kmax+1)] = SOLID;
-  flagp[IX(0,jmax+1,0)] = SOLID;
-  flagp[IX(0,jmax+1,kmax+1)] = SOLID;
-  flagp[IX(imax+1,0,0)] = SOLID;
-  flagp[IX(imax+1,0,kmax+1)] = SOLID;
-  flagp[IX(imax+1,jmax+1,0)] = SOLID;
-  flagp[IX(imax+1,jmax+1,kmax+1)] = SOLID;
+  CELL_MASK *mask = cell_mask(para);
+
+  if(mask==NULL) return;
+
+  SET_CELL_TYPE(mask[IX(0,0,0)], SOLID, MASK_P);
+  SET_CELL_TYPE(mask[IX(0,0,kmax+1)], SOLID, MASK_P);
+  SET_CELL_TYPE(mask[IX(0,jmax+1,0)], SOLID, MASK_P);
+  SET_CELL_TYPE(mask[IX(0,jmax+1,kmax+1)], SOLID, MASK_P);
+  SET_CELL_TYPE(mask[IX(imax+1,0,0)], SOLID, MASK_P);
+  SET_CELL_TYPE(mask[IX(imax+1,0,kmax+1)], SOLID, MASK_P);
+  SET_CELL_TYPE(mask[IX(imax+1,jmax+1,0)], SOLID, MASK_P);
+  SET_CELL_TYPE(mask[IX(imax+1,jmax+1,kmax+1)], SOLID, MASK_P);
 
   FOR_EACH_CELL
 
-    if(flagp[IX(i,j,k)]>=0) continue;
+    if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
 
-    if(flagp[IX(i-1,j,k)]>=0 && flagp[IX(i+1,j,k)]>=0 &&
-      flagp[IX(i,j-1,k)]>=0 && flagp[IX(i,j+1,k)]>=0 &&
-      flagp[IX(i,j,k-1)]>=0 && flagp[IX(i,j,k+1)]>=0 )
-      flagp[IX(i,j,k)] = SOLID;
+    if(!IS_FLUID(mask[IX(i-1,j,k)], MASK_P)
+       && !IS_FLUID(mask[IX(i+1,j,k)], MASK_P)
+       && !IS_FLUID(mask[IX(i,j-1,k)], MASK_P)
+       && !IS_FLUID(mask[IX(i,j+1,k)], MASK_P)
+       && !IS_FLUID(mask[IX(i,j,k-1)], MASK_P)
+       && !IS_FLUID(mask[IX(i,j,k+1)], MASK_P))
+      SET_CELL_TYPE(mask[IX(i,j,k)], SOLID, MASK_P);
   END_FOR
 
+  // The velocity cells on the faces of a cell that is not fluid get its type
   FOR_ALL_CELL
+    t = CELL_TYPE(mask[IX(i,j,k)], MASK_P);
+    if(t==FLUID) continue;
 
-  if(flagp[IX(i,j,k)]==1) {
-
-    flagu[IX(i,j,k)]=1;
-    flagv[IX(i,j,k)]=1;
-    flagw[IX(i,j,k)]=1;
-
-    if(i!=0) flagu[IX(i-1,j,k)]=1;
-    if(j!=0) flagv[IX(i,j-1,k)]=1;
-    if(k!=0) flagw[IX(i,j,k-1)]=1;
-  }
-
-  if(flagp[IX(i,j,k)]==0) {
-    flagu[IX(i,j,k)]=0;
-    flagv[IX(i,j,k)]=0;
-    flagw[IX(i,j,k)]=0;
-
-    if(i!=0) flagu[IX(i-1,j,k)]=0;
-    if(j!=0) flagv[IX(i,j-1,k)]=0;
-    if(k!=0) flagw[IX(i,j,k-1)]=0;
-}
-
-  if(flagp[IX(i,j,k)]==2) {
-
-    flagu[IX(i,j,k)]=2;
-    flagv[IX(i,j,k)]=2;
-    flagw[IX(i,j,k)]=2;
-
-    if(i!=0) flagu[IX(i-1,j,k)]=2;
-    if(j!=0) flagv[IX(i,j-1,k)]=2;
-    if(k!=0) flagw[IX(i,j,k-1)]=2;
-}
+    SET_CELL_TYPE(mask[IX(i,j,k)], t, MASK_U);
+    SET_CELL_TYPE(mask[IX(i,j,k)], t, MASK_V);
+    SET_CELL_TYPE(mask[IX(i,j,k)], t, MASK_W);
 
+    if(i!=0) SET_CELL_TYPE(mask[IX(i-1,j,k)], t, MASK_U);
+    if(j!=0) SET_CELL_TYPE(mask[IX(i,j-1,k)], t, MASK_V);
+    if(k!=0) SET_CELL_TYPE(mask[IX(i,j,k-1)], t, MASK_W);
   END_FOR
+
+  // Boundary faces and runs of fluid cells used by the loops of the solvers
+  set_cell_mask(para);
+  set_cell_run(para);
 } // End of mark_cell()
\ No newline at end of file
@@ -76,10 +76,9 @@ int read_sci_zeroone(PARA_DATA *para, REAL **var, int **BINDEX);
 /// Identify the properties of cells
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-void mark_cell(PARA_DATA *para, REAL **var);
+void mark_cell(PARA_DATA *para);
 
 
@@ -32,33 +32,51 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
   int step_total = para->mytime->step_total;
   REAL t_steady = para->mytime->t_steady;
   int cal_mean = para->outp->cal_mean;
-  double t_cosim;
+  double t_cosim, t_end;
   int flag, next;
 
   if(para->solv->cosimulation == 1)
     t_cosim = para->mytime->t + para->cosim->modelica->dt;
 
+  // End of a single simulation with adaptive time step size, which keeps the
+  // simulated time of step_total steps of the initial size
+  t_end = para->mytime->t + step_total*para->mytime->dt;
+
   /***************************************************************************
   | Solver Loop
   ***************************************************************************/
   next = 1;
   while(next==1) {
+    //-------------------------------------------------------------------------
+    // Adapt the time step size so that a step ends at the next
+    // synchronization time or at the end of the simulation
+    //-------------------------------------------------------------------------
+    if(para->mytime->dt_adapt==1) {
+      flag = set_time_step(para, var,
+                           para->solv->cosimulation==1 ? t_cosim : t_end);
+      if(flag != 0) {
+        ffd_log("FFD_solver(): Could not adapt the time step size.",
+                FFD_ERROR);
+        return flag;
+      }
+    }
+
     //-------------------------------------------------------------------------
     // Integration
     //-------------------------------------------------------------------------
-    flag = vel_step(para, var, BINDEX);
+    flag = vel_step(para, var);
     if(flag != 0) {
       ffd_log("FFD_solver(): Could not solve velocity.", FFD_ERROR);
       return flag;
     }
 
-    flag = temp_step(para, var, BINDEX);
+    flag = temp_step(para, var);
     if(flag != 0) {
       ffd_log("FFD_solver(): Could not solve temperature.", FFD_ERROR);
       return flag;
     }
     
-    flag = den_step(para, var, BINDEX);
+    flag = den_step(para, var);
     if(flag != 0) {
       ffd_log("FFD_solver(): Could not solve trace substance.", FFD_ERROR);
       return flag;
@@ -150,7 +168,7 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
       .......................................................................*/
       else {
         // Integrate the data on the boundary surface
-        flag = surface_integrate(para, var, BINDEX);
+        flag = surface_integrate(para, var);
         if(flag != 0) {
           ffd_log("FFD_solver(): "
             "Could not average the data on boundary.",
@@ -192,7 +210,10 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
           return 1;
         }
       }
-      next = para->mytime->step_current < step_total ? 1 : 0;
+      if(para->mytime->dt_adapt==1)
+        next = t_end - para->mytime->t > SMALL ? 1 : 0;
+      else
+        next = para->mytime->step_current < step_total ? 1 : 0;
     }    
   } // End of While loop  
 
@@ -204,21 +225,20 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int temp_step(PARA_DATA *para, REAL **var, int **BINDEX) {
+int temp_step(PARA_DATA *para, REAL **var) {
   REAL *T = var[TEMP], *T0 = var[TMP1];
   int flag = 0;
 
-  flag = advect(para, var, TEMP, 0, T0, T, BINDEX); 
+  flag = advect(para, var, TEMP, 0, T0, T); 
   if(flag!=0) {
     ffd_log("temp_step(): Could not advect temperature.", FFD_ERROR);
     return flag;
   }
 
-  flag = diffusion(para, var, TEMP, 0, T, T0, BINDEX);
+  flag = diffusion(para, var, TEMP, 0, T, T0);
   if(flag!=0) {
     ffd_log("temp_step(): Could not diffuse temperature.", FFD_ERROR);
     return flag;
@@ -232,24 +252,23 @@ int temp_step(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 /////////////////////////////////////////////////////////////////////////////// 
-int den_step(PARA_DATA *para, REAL **var, int **BINDEX) {
+int den_step(PARA_DATA *para, REAL **var) {
   REAL *den, *den0 = var[TMP1];
   int i, flag = 0;
 
   for(i=0; i<para->bc->nb_Xi; i++) {
     den = var[TRACE+i];
-    flag = advect(para, var, TRACE, i, den0, den, BINDEX);
+    flag = advect(para, var, TRACE, i, den0, den);
     if(flag!=0) {
       sprintf(msg, "den_step(): Could not advect for trace substance %d", i);
       ffd_log(msg, FFD_ERROR);
       return flag;
     }
 
-    flag = diffusion(para, var, TRACE, i, den, den0, BINDEX);
+    flag = diffusion(para, var, TRACE, i, den, den0);
     if(flag!=0) {
       sprintf(msg, "den_step(): Could not diffuse trace substance %d", i);
       ffd_log(msg, FFD_ERROR);
@@ -265,58 +284,66 @@ int den_step(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 /////////////////////////////////////////////////////////////////////////////// 
-int vel_step(PARA_DATA *para, REAL **var,int **BINDEX) {
+int vel_step(PARA_DATA *para, REAL **var) {
   REAL *u  = var[VX],  *v  = var[VY],    *w  = var[VZ];
   REAL *u0 = var[TMP1], *v0 = var[TMP2], *w0 = var[TMP3];
   int flag = 0;
 
-  flag = advect(para, var, VX, 0, u0, u, BINDEX);
+  if(para->prob->tur_model==CHEN) {
+    flag = set_nu_t_chen_zero_equ(para, var);
+    if(flag!=0) {
+      ffd_log("vel_step(): Could not set the turbulent viscosity.",
+              FFD_ERROR);
+      return flag;
+    }
+  }
+
+  flag = advect(para, var, VX, 0, u0, u);
   if(flag!=0) {
     ffd_log("vel_step(): Could not advect for velocity X.", FFD_ERROR);
     return flag;
   }
 
-  flag = advect(para, var, VY, 0, v0, v, BINDEX);
+  flag = advect(para, var, VY, 0, v0, v);
   if(flag!=0) {
     ffd_log("vel_step(): Could not advect for velocity Y.", FFD_ERROR);
     return flag;
   }
 
-  flag = advect(para, var, VZ, 0, w0, w, BINDEX); 
+  flag = advect(para, var, VZ, 0, w0, w); 
   if(flag!=0) {
     ffd_log("vel_step(): Could not advect for velocity Z.", FFD_ERROR);
     return flag;
   }
 
-  flag = diffusion(para, var, VX, 0, u, u0, BINDEX);
+  flag = diffusion(para, var, VX, 0, u, u0);
   if(flag!=0) {
     ffd_log("vel_step(): Could not diffuse velocity X.", FFD_ERROR);
     return flag;
   }
 
-  flag = diffusion(para, var, VY, 0, v, v0, BINDEX);
+  flag = diffusion(para, var, VY, 0, v, v0);
   if(flag!=0) {
     ffd_log("vel_step(): Could not diffuse velocity Y.", FFD_ERROR);
     return flag;
   }
 
-  flag = diffusion(para, var, VZ, 0, w, w0, BINDEX); 
+  flag = diffusion(para, var, VZ, 0, w, w0); 
   if(flag!=0) {
     ffd_log("vel_step(): Could not diffuse velocity Z.", FFD_ERROR);
     return flag;
   }
 
-  flag = project(para, var,BINDEX);
+  flag = project(para, var);
   if(flag!=0) {
     ffd_log("vel_step(): Could not project velocity.", FFD_ERROR);
     return flag;
   }
 
-  if(para->bc->nb_outlet!=0) flag = mass_conservation(para, var,BINDEX);
+  if(para->bc->nb_outlet!=0) flag = mass_conservation(para, var);
   if(flag!=0) {
     ffd_log("vel_step(): Could not conduct mass conservation correction.",
             FFD_ERROR);
@@ -337,32 +364,72 @@ int vel_step(PARA_DATA *para, REAL **var,int **BINDEX) {
 ///\return 0 if not error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int equ_solver(PARA_DATA *para, REAL **var, int var_type, REAL *psi) {
-  REAL *flagp = var[FLAGP], *flagu = var[FLAGU],
-       *flagv = var[FLAGV], *flagw = var[FLAGW];
-  int flag = 0;
+  REAL tol;
+  int flag = 0, max_iter, shift;
 
   switch(var_type) {
     case VX:
-      Gauss_Seidel(para, var, flagu, psi);
-      break;
     case VY:
-      Gauss_Seidel(para, var, flagv, psi);
-      break;
     case VZ:
-      Gauss_Seidel(para, var, flagw, psi);
+      shift = var_type==VX ? MASK_U : (var_type==VY ? MASK_V : MASK_W);
+      tol = para->solv->vel_tol;
+      max_iter = para->solv->vel_max_iter;
       break;
     case TEMP:
-    case IP:
+      shift = MASK_P;
+      tol = para->solv->temp_tol;
+      max_iter = para->solv->temp_max_iter;
+      break;
     case TRACE:
-      Gauss_Seidel(para, var, flagp, psi);
+      shift = MASK_P;
+      tol = para->solv->trace_tol;
+      max_iter = para->solv->trace_max_iter;
       break;
+    case IP:
+      // Direct solver for empty box on uniform grid
+      if(para->solv->fft_p==1 && FFT_P_available(para, var))
+        return FFT_P(para, var, psi);
+
+      switch(para->solv->solver) {
+        case MG:
+          MG_P(para, var, psi);
+          break;
+        case GS_RB:
+          GS_P_RB(para, var, psi);
+          break;
+        case PCG:
+          PCG_P(para, var, psi);
+          break;
+        case CHOL:
+          flag = CHOL_P(para, var, psi);
+          break;
+        case TDMA:
+          flag = TDMA_3D(para, var, IP, psi, para->solv->p_tol,
+                         para->solv->p_max_iter>0 ? para->solv->p_max_iter
+                                                  : TDMA_P_MAX_ITER);
+          break;
+        default:
+          GS_P(para, var, psi);
+          break;
+      }
+      return flag;
     default:
       sprintf(msg, "equ_solver(): Solver for variable type %d is not defined.", 
               var_type);
       ffd_log(msg, FFD_ERROR);
       flag = 1;
-      break;
+      return flag;
   }
 
+  if(max_iter<=0)
+    max_iter = para->solv->solver==TDMA ? TDMA_MAX_ITER : GS_MAX_ITER;
+
+  if(para->solv->solver==TDMA)
+    flag = TDMA_3D(para, var, var_type, psi, tol, max_iter);
+  else if(para->solv->solver==GS_RB)
+    Gauss_Seidel_RB(para, var, shift, psi, tol, max_iter);
+  else
+    Gauss_Seidel(para, var, shift, psi, tol, max_iter);
+
   return flag;
 }// end of equ_solver
\ No newline at end of file
@@ -58,6 +58,31 @@
 #include "solver_tdma.h"
 #endif
 
+#ifndef _SOLVER_MG_H
+#define _SOLVER_MG_H
+#include "solver_mg.h"
+#endif
+
+#ifndef _SOLVER_PCG_H
+#define _SOLVER_PCG_H
+#include "solver_pcg.h"
+#endif
+
+#ifndef _SOLVER_CHOL_H
+#define _SOLVER_CHOL_H
+#include "solver_chol.h"
+#endif
+
+#ifndef _SOLVER_FFT_H
+#define _SOLVER_FFT_H
+#include "solver_fft.h"
+#endif
+
+#ifndef _CHEN_ZERO_EQU_MODEL_H
+#define _CHEN_ZERO_EQU_MODEL_H
+#include "chen_zero_equ_model.h"
+#endif
+
 #ifndef _BOUNDARY_H
 #define _BOUNDARY_H
 #include "boundary.h"
@@ -94,33 +119,30 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX);
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int temp_step(PARA_DATA *para, REAL **var, int **BINDEX);
+int temp_step(PARA_DATA *para, REAL **var);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the contaminant concentration
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 /////////////////////////////////////////////////////////////////////////////// 
-int den_step(PARA_DATA *para, REAL **var, int **BINDEX);
+int den_step(PARA_DATA *para, REAL **var);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the velocity
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to boundary index
 ///
 ///\return 0 if no error occurred
 /////////////////////////////////////////////////////////////////////////////// 
-int vel_step(PARA_DATA *para, REAL **var,int **BINDEX);
+int vel_step(PARA_DATA *para, REAL **var);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Solver for equations
@@ -0,0 +1,563 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_chol.c
+///
+/// \brief  Sparse Cholesky solver for pressure
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/16/2026
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "solver_chol.h"
+
+static int chol_size = 0; // Number of cells including boundary cells
+static int chol_n = 0; // Number of unknowns
+static int *chol_index = NULL; // Unknown of each cell, -1 if not solved
+static int *chol_cell = NULL; // Cell of each unknown
+static int *chol_ap = NULL; // Row pointers of lower triangle of the matrix
+static int *chol_aj = NULL; // Column indices of lower triangle of the matrix
+static double *chol_ax = NULL; // Values of lower triangle of the matrix
+static int *chol_parent = NULL; // Elimination tree
+static int *chol_lp = NULL; // Column pointers of the factor
+static int *chol_li = NULL; // Row indices of the factor
+static double *chol_lx = NULL; // Values of the factor
+static int *chol_pin = NULL; // 1: unknown is pinned to zero, 0: not pinned
+static int *chol_root = NULL; // Root of the elimination tree of each unknown
+static int *chol_nb = NULL; // Number of unknowns of the group of each root
+static double *chol_mean = NULL; // Work array for the means of the groups
+static int *chol_stack = NULL; // Work array for the row pattern
+static int *chol_mark = NULL; // Work array for the row pattern
+static double *chol_work = NULL; // Work array for values
+static int chol_factorized = 0; // 1: the factor is valid
+
+///////////////////////////////////////////////////////////////////////////////
+/// Number the fluid cells by geometric nested dissection
+///
+/// The box is split at the middle plane of its longest direction. The cells
+/// of the two halves are numbered first and the cells of the separating
+/// plane last, so that the halves are not coupled before the separator is
+/// eliminated.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param lo Lower indices of the box
+///\param hi Upper indices of the box
+///\param count Pointer to the number of cells numbered
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void chol_dissect(PARA_DATA *para, REAL **var, int lo[3], int hi[3],
+                         int *count) {
+  CELL_MASK *mask = para->geom->mask;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, d, dir, mid;
+  int lo1[3], hi1[3];
+
+  for(d=0, dir=0; d<3; d++) {
+    if(hi[d]<lo[d]) return;
+    if(hi[d]-lo[d]>hi[dir]-lo[dir]) dir = d;
+  }
+
+  /****************************************************************************
+  | Number the small box in natural order
+  ****************************************************************************/
+  if((hi[0]-lo[0]+1)*(hi[1]-lo[1]+1)*(hi[2]-lo[2]+1)<=CHOL_ND_LEAF
+     || hi[dir]-lo[dir]<2) {
+    for(k=lo[2]; k<=hi[2]; k++)
+      for(j=lo[1]; j<=hi[1]; j++)
+        for(i=lo[0]; i<=hi[0]; i++) {
+          if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+          chol_index[IX(i,j,k)] = *count;
+          chol_cell[*count] = IX(i,j,k);
+          (*count)++;
+        }
+    return;
+  }
+
+  /****************************************************************************
+  | Number the two halves and then the separator
+  ****************************************************************************/
+  mid = (lo[dir]+hi[dir]) / 2;
+  for(d=0; d<3; d++) {
+    lo1[d] = lo[d];
+    hi1[d] = hi[d];
+  }
+
+  hi1[dir] = mid - 1;
+  chol_dissect(para, var, lo1, hi1, count);
+
+  lo1[dir] = mid + 1;
+  hi1[dir] = hi[dir];
+  chol_dissect(para, var, lo1, hi1, count);
+
+  lo1[dir] = mid;
+  hi1[dir] = mid;
+  chol_dissect(para, var, lo1, hi1, count);
+} // End of chol_dissect()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Find the pattern of row k of the factor in the elimination tree
+///
+/// The columns are stored in chol_stack[top..n-1] in topological order.
+///
+///\param k Row index
+///
+///\return Index top of the first column
+///////////////////////////////////////////////////////////////////////////////
+static int chol_reach(int k) {
+  int n = chol_n, top = n, len, p, i;
+
+  chol_mark[k] = k;
+  for(p=chol_ap[k]; p<chol_ap[k+1]; p++) {
+    i = chol_aj[p];
+    if(i>=k) continue;
+    for(len=0; chol_mark[i]!=k; i=chol_parent[i]) {
+      chol_stack[len++] = i;
+      chol_mark[i] = k;
+    }
+    while(len>0) chol_stack[--top] = chol_stack[--len];
+  }
+
+  return top;
+} // End of chol_reach()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Number the unknowns and compute the patterns of the matrix and the factor
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int chol_analyse(PARA_DATA *para, REAL **var) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int size = (imax+2)*(jmax+2)*(kmax+2);
+  int i, j, k, c, n, nnz, p, top, next, lo[3], hi[3];
+  int *count, *ancestor;
+  int nb[6];
+
+  free_chol_data();
+
+  chol_index = (int *) malloc(size*sizeof(int));
+  chol_cell = (int *) malloc(size*sizeof(int));
+  if(!chol_index || !chol_cell) return 1;
+  chol_size = size;
+
+  for(c=0; c<size; c++) chol_index[c] = -1;
+
+  lo[0] = 1; lo[1] = 1; lo[2] = 1;
+  hi[0] = imax; hi[1] = jmax; hi[2] = kmax;
+  n = 0;
+  chol_dissect(para, var, lo, hi, &n);
+  chol_n = n;
+
+  /****************************************************************************
+  | Pattern of lower triangle of the matrix
+  ****************************************************************************/
+  chol_ap = (int *) malloc((n+1)*sizeof(int));
+  chol_aj = (int *) malloc((7*n+1)*sizeof(int));
+  chol_ax = (double *) calloc(7*n+1, sizeof(double));
+  chol_parent = (int *) malloc((n+1)*sizeof(int));
+  chol_lp = (int *) malloc((n+1)*sizeof(int));
+  chol_pin = (int *) calloc(n+1, sizeof(int));
+  chol_stack = (int *) malloc((n+1)*sizeof(int));
+  chol_mark = (int *) malloc((n+1)*sizeof(int));
+  chol_work = (double *) calloc(n+1, sizeof(double));
+  chol_root = (int *) malloc((n+1)*sizeof(int));
+  chol_nb = (int *) calloc(n+1, sizeof(int));
+  chol_mean = (double *) calloc(n+1, sizeof(double));
+  if(!chol_ap || !chol_aj || !chol_ax || !chol_parent || !chol_lp
+     || !chol_pin || !chol_stack || !chol_mark || !chol_work
+     || !chol_root || !chol_nb || !chol_mean) return 1;
+
+  nnz = 0;
+  for(c=0; c<n; c++) {
+    chol_ap[c] = nnz;
+    k = chol_cell[c] / IJMAX;
+    j = (chol_cell[c] - k*IJMAX) / IMAX;
+    i = chol_cell[c] - k*IJMAX - j*IMAX;
+
+    // Only interior cells are unknowns
+    nb[0] = i>1 ? chol_index[IX(i-1,j,k)] : -1;
+    nb[1] = i<imax ? chol_index[IX(i+1,j,k)] : -1;
+    nb[2] = j>1 ? chol_index[IX(i,j-1,k)] : -1;
+    nb[3] = j<jmax ? chol_index[IX(i,j+1,k)] : -1;
+    nb[4] = k>1 ? chol_index[IX(i,j,k-1)] : -1;
+    nb[5] = k<kmax ? chol_index[IX(i,j,k+1)] : -1;
+
+    for(p=0; p<6; p++)
+      if(nb[p]>=0 && nb[p]<c) chol_aj[nnz++] = nb[p];
+    chol_aj[nnz++] = c;
+  }
+  chol_ap[n] = nnz;
+
+  /****************************************************************************
+  | Elimination tree
+  ****************************************************************************/
+  ancestor = chol_stack;
+  for(k=0; k<n; k++) {
+    chol_parent[k] = -1;
+    ancestor[k] = -1;
+    for(p=chol_ap[k]; p<chol_ap[k+1]; p++) {
+      for(i=chol_aj[p]; i!=-1 && i<k; i=next) {
+        next = ancestor[i];
+        ancestor[i] = k;
+        if(next==-1) chol_parent[i] = k;
+      }
+    }
+  }
+
+  // The parent of an unknown is numbered after it
+  for(k=n-1; k>=0; k--) {
+    chol_root[k] = chol_parent[k]<0 ? k : chol_root[chol_parent[k]];
+    chol_nb[chol_root[k]]++;
+  }
+
+  /****************************************************************************
+  | Column counts of the factor
+  ****************************************************************************/
+  count = chol_lp;
+  for(k=0; k<=n; k++) {
+    count[k] = 1;
+    chol_mark[k] = -1;
+  }
+  for(k=0; k<n; k++)
+    for(top=chol_reach(k); top<n; top++) count[chol_stack[top]]++;
+
+  for(k=0, nnz=0; k<n; k++) {
+    p = count[k];
+    chol_lp[k] = nnz;
+    nnz += p;
+  }
+  chol_lp[n] = nnz;
+
+  chol_li = (int *) malloc((nnz+1)*sizeof(int));
+  chol_lx = (double *) malloc((nnz+1)*sizeof(double));
+  if(!chol_li || !chol_lx) return 1;
+
+  sprintf(msg, "chol_analyse(): %d unknowns with %d nonzeros in the factor.",
+          n, nnz);
+  ffd_log(msg, FFD_NORMAL);
+
+  return 0;
+} // End of chol_analyse()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy the coefficients into the matrix
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 1 if the matrix has changed, otherwise 0
+///////////////////////////////////////////////////////////////////////////////
+static int chol_assemble(PARA_DATA *para, REAL **var) {
+  REAL *aw = var[AW], *as = var[AS], *ab = var[AB], *ap = var[AP];
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int c, p, cell, changed = 0;
+  double a;
+
+  for(c=0; c<chol_n; c++) {
+    cell = chol_cell[c];
+    for(p=chol_ap[c]; p<chol_ap[c+1]; p++) {
+      if(chol_aj[p]==c)
+        a = ap[cell];
+      else if(chol_cell[chol_aj[p]]==cell-1)
+        a = -aw[cell];
+      else if(chol_cell[chol_aj[p]]==cell-IMAX)
+        a = -as[cell];
+      else if(chol_cell[chol_aj[p]]==cell-IJMAX)
+        a = -ab[cell];
+      // Neighbor with higher cell index, use symmetry of the matrix
+      else if(chol_cell[chol_aj[p]]==cell+1)
+        a = -aw[cell+1];
+      else if(chol_cell[chol_aj[p]]==cell+IMAX)
+        a = -as[cell+IMAX];
+      else
+        a = -ab[cell+IJMAX];
+
+      if(chol_ax[p]!=a) changed = 1;
+      chol_ax[p] = a;
+    }
+  }
+
+  return changed;
+} // End of chol_assemble()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Up-looking Cholesky factorization of the matrix
+///
+/// Row k of the factor is computed by a sparse triangular solve with the
+/// rows found by chol_reach(). Each root of the elimination tree is the last
+/// unknown of a connected group of fluid cells. If no equation of the group
+/// contains a fixed value, as for the pressure equation, the matrix of the
+/// group is singular and its root is pinned to zero, which removes the
+/// constant null space. Any other vanishing pivot is pinned as well.
+///
+///\return Number of pinned unknowns
+///////////////////////////////////////////////////////////////////////////////
+static int chol_factorize() {
+  int n = chol_n, k, p, q, i, top, nb_pin = 0;
+  double d, lki, *w = chol_work;
+  int *col; // End of the filled part of each column
+  int *fixed = chol_stack; // Not used by chol_reach() before the rows
+
+  col = (int *) malloc((n+1)*sizeof(int));
+  if(col==NULL) return -1;
+
+  /****************************************************************************
+  | Find the groups without fixed values by the row sums of the matrix
+  ****************************************************************************/
+  for(k=0; k<n; k++) {
+    col[k] = chol_lp[k];
+    chol_mark[k] = -1;
+    w[k] = 0;
+  }
+
+  for(k=0; k<n; k++)
+    for(p=chol_ap[k]; p<chol_ap[k+1]; p++) {
+      w[k] += chol_ax[p];
+      if(chol_aj[p]!=k) w[chol_aj[p]] += chol_ax[p];
+    }
+
+  // fixed is 1 if the subtree of an unknown contains a fixed value
+  for(k=0; k<n; k++) fixed[k] = 0;
+  for(k=0; k<n; k++) {
+    if(fabs(w[k])>1e-5*chol_ax[chol_ap[k+1]-1]) fixed[k] = 1;
+    if(fixed[k] && chol_parent[k]>=0) fixed[chol_parent[k]] = 1;
+    chol_pin[k] = chol_parent[k]<0 && !fixed[k];
+    w[k] = 0;
+  }
+
+  /****************************************************************************
+  | Factorize row by row
+  ****************************************************************************/
+  for(k=0; k<n; k++) {
+    top = chol_reach(k);
+    for(p=chol_ap[k]; p<chol_ap[k+1]; p++) w[chol_aj[p]] = chol_ax[p];
+    d = w[k];
+    w[k] = 0;
+
+    for(; top<n; top++) {
+      i = chol_stack[top];
+      lki = chol_pin[i] ? 0 : w[i] / chol_lx[chol_lp[i]];
+      w[i] = 0;
+      for(q=chol_lp[i]+1; q<col[i]; q++) w[chol_li[q]] -= chol_lx[q]*lki;
+      d -= lki*lki;
+      q = col[i]++;
+      chol_li[q] = k;
+      chol_lx[q] = lki;
+    }
+
+    q = col[k]++;
+    chol_li[q] = k;
+    // The diagonal is the last entry of row k
+    if(chol_pin[k] || d<=CHOL_PIVOT_TOL*chol_ax[chol_ap[k+1]-1]) {
+      chol_pin[k] = 1;
+      chol_lx[q] = 1;
+      nb_pin++;
+    }
+    else
+      chol_lx[q] = sqrt(d);
+  }
+
+  free(col);
+  return nb_pin;
+} // End of chol_factorize()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Sparse Cholesky solver for pressure
+///
+/// The matrix is analysed and factorized at the first call and factorized
+/// again only if the coefficients have changed. Coefficients linking to
+/// cells that are not solved are moved to the right hand side. The mean of
+/// the right hand side of each singular group is removed, as PCG_P() does,
+/// so that it does not end up in the pinned cell as a point source.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int CHOL_P(PARA_DATA *para, REAL **var, REAL *x) {
+  REAL *ae = var[AE], *aw = var[AW], *an = var[AN], *as = var[AS];
+  REAL *af = var[AF], *ab = var[AB], *ap = var[AP], *b = var[B];
+  CELL_MASK *mask = cell_mask(para);
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, c, p, nb_pin, size = (imax+2)*(jmax+2)*(kmax+2);
+  double *y, r, norm_r = 0, norm_b = 0;
+
+  if(mask==NULL) return 1;
+
+  /****************************************************************************
+  | Analyse the matrix again if the fluid cells have changed
+  ****************************************************************************/
+  if(chol_size==size) {
+    FOR_EACH_CELL
+      if(IS_FLUID(mask[IX(i,j,k)], MASK_P) != (chol_index[IX(i,j,k)]>=0)) {
+        chol_size = 0;
+        break;
+      }
+    END_FOR
+  }
+
+  if(chol_size!=size) {
+    if(chol_analyse(para, var)!=0) {
+      free_chol_data();
+      ffd_log("CHOL_P(): Could not allocate memory, "
+              "use conjugate gradient solver instead.", FFD_WARNING);
+      PCG_P(para, var, x);
+      return 0;
+    }
+    chol_factorized = 0;
+  }
+
+  if(chol_assemble(para, var) || !chol_factorized) {
+    nb_pin = chol_factorize();
+    if(nb_pin<0) {
+      ffd_log("CHOL_P(): Could not allocate memory, "
+              "use conjugate gradient solver instead.", FFD_WARNING);
+      PCG_P(para, var, x);
+      return 0;
+    }
+    chol_factorized = 1;
+    if(nb_pin>0) {
+      sprintf(msg, "CHOL_P(): %d pressure values pinned to zero.", nb_pin);
+      ffd_log(msg, FFD_NORMAL);
+    }
+  }
+
+  /****************************************************************************
+  | Right hand side with the coefficients of the cells not solved
+  ****************************************************************************/
+  y = chol_work;
+  for(c=0; c<chol_n; c++) {
+    // Boundary cells are never unknowns
+    p = chol_cell[c];
+    y[c] = b[p];
+    if(chol_index[p+1]<0) y[c] += ae[p]*x[p+1];
+    if(chol_index[p-1]<0) y[c] += aw[p]*x[p-1];
+    if(chol_index[p+IMAX]<0) y[c] += an[p]*x[p+IMAX];
+    if(chol_index[p-IMAX]<0) y[c] += as[p]*x[p-IMAX];
+    if(chol_index[p+IJMAX]<0) y[c] += af[p]*x[p+IJMAX];
+    if(chol_index[p-IJMAX]<0) y[c] += ab[p]*x[p-IJMAX];
+  }
+
+  /****************************************************************************
+  | Remove the mean of the right hand side of each group with a pinned root,
+  | so that the singular equations of the group have a solution
+  ****************************************************************************/
+  for(c=0; c<chol_n; c++) chol_mean[c] = 0;
+  for(c=0; c<chol_n; c++)
+    if(chol_pin[chol_root[c]]) chol_mean[chol_root[c]] += y[c];
+  for(c=0; c<chol_n; c++)
+    if(chol_pin[chol_root[c]])
+      y[c] -= chol_mean[chol_root[c]] / chol_nb[chol_root[c]];
+
+  /****************************************************************************
+  | Forward substitution L y = b and backward substitution L^T x = y
+  ****************************************************************************/
+  for(c=0; c<chol_n; c++) {
+    if(chol_pin[c]) {
+      y[c] = 0;
+      continue;
+    }
+    y[c] /= chol_lx[chol_lp[c]];
+    for(p=chol_lp[c]+1; p<chol_lp[c+1]; p++)
+      y[chol_li[p]] -= chol_lx[p]*y[c];
+  }
+
+  for(c=chol_n-1; c>=0; c--) {
+    for(p=chol_lp[c]+1; p<chol_lp[c+1]; p++)
+      y[c] -= chol_lx[p]*y[chol_li[p]];
+    y[c] = chol_pin[c] ? 0 : y[c]/chol_lx[chol_lp[c]];
+  }
+
+  for(c=0; c<chol_n; c++) x[chol_cell[c]] = (REAL) y[c];
+
+  para->solv->iter = 1;
+  para->solv->residual = 0;
+
+  // The means of the groups with a pinned root are excluded from the norms
+  if(para->solv->check_residual==1) {
+    for(c=0; c<chol_n; c++) {
+      chol_mean[c] = 0;
+      chol_work[c] = 0;
+    }
+    FOR_EACH_CELL
+      if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+      r = b[IX(i,j,k)] - ap[IX(i,j,k)]*x[IX(i,j,k)]
+        + ae[IX(i,j,k)]*x[IX(i+1,j,k)] + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+        + an[IX(i,j,k)]*x[IX(i,j+1,k)] + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+        + af[IX(i,j,k)]*x[IX(i,j,k+1)] + ab[IX(i,j,k)]*x[IX(i,j,k-1)];
+      norm_r += r * r;
+      norm_b += b[IX(i,j,k)] * b[IX(i,j,k)];
+      c = chol_root[chol_index[IX(i,j,k)]];
+      chol_mean[c] += r;
+      chol_work[c] += b[IX(i,j,k)];
+    END_FOR
+    for(c=0; c<chol_n; c++)
+      if(chol_pin[c] && chol_parent[c]<0) {
+        norm_r -= chol_mean[c] * chol_mean[c] / chol_nb[c];
+        norm_b -= chol_work[c] * chol_work[c] / chol_nb[c];
+      }
+    if(norm_r<0) norm_r = 0;
+    para->solv->residual = (REAL) (norm_b>0 ? sqrt(norm_r/norm_b) : 0);
+    sprintf(msg, "CHOL_P(): Residual of pressure is %e", para->solv->residual);
+    ffd_log(msg, FFD_NORMAL);
+  }
+
+  return 0;
+} // End of CHOL_P()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the sparse Cholesky solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_chol_data() {
+  if(chol_index!=NULL) free(chol_index);
+  if(chol_cell!=NULL) free(chol_cell);
+  if(chol_ap!=NULL) free(chol_ap);
+  if(chol_aj!=NULL) free(chol_aj);
+  if(chol_ax!=NULL) free(chol_ax);
+  if(chol_parent!=NULL) free(chol_parent);
+  if(chol_lp!=NULL) free(chol_lp);
+  if(chol_li!=NULL) free(chol_li);
+  if(chol_lx!=NULL) free(chol_lx);
+  if(chol_pin!=NULL) free(chol_pin);
+  if(chol_root!=NULL) free(chol_root);
+  if(chol_nb!=NULL) free(chol_nb);
+  if(chol_mean!=NULL) free(chol_mean);
+  if(chol_stack!=NULL) free(chol_stack);
+  if(chol_mark!=NULL) free(chol_mark);
+  if(chol_work!=NULL) free(chol_work);
+  chol_index = NULL;
+  chol_cell = NULL;
+  chol_ap = NULL;
+  chol_aj = NULL;
+  chol_ax = NULL;
+  chol_parent = NULL;
+  chol_lp = NULL;
+  chol_li = NULL;
+  chol_lx = NULL;
+  chol_pin = NULL;
+  chol_root = NULL;
+  chol_nb = NULL;
+  chol_mean = NULL;
+  chol_stack = NULL;
+  chol_mark = NULL;
+  chol_work = NULL;
+  chol_size = 0;
+  chol_n = 0;
+  chol_factorized = 0;
+} // End of free_chol_data()
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_chol.h
+///
+/// \brief  Sparse Cholesky solver for pressure
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/16/2026
+///
+/// The coefficients of the pressure equation only depend on the geometry and
+/// on the cell types, so that they do not change during a simulation. The
+/// matrix of the fluid pressure cells is assembled once in compressed
+/// sparse row (CSR) format and factorized by an up-looking Cholesky method
+/// after a geometric nested dissection ordering. Each time step then only
+/// needs a forward and a backward substitution. The factorization is
+/// repeated if the coefficients change.
+///
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _SOLVER_CHOL_H
+#define _SOLVER_CHOL_H
+#endif
+
+#ifndef _DATA_STRUCTURE_H
+#define _DATA_STRUCTURE_H
+#include "data_structure.h"
+#endif
+
+#ifndef _SOLVER_PCG_H
+#define _SOLVER_PCG_H
+#include "solver_pcg.h"
+#endif
+
+#ifndef _UTILITY_H
+#define _UTILITY_H
+#include "utility.h"
+#endif
+
+#define CHOL_ND_LEAF 8 // Maximum cells of a box not split by nested dissection
+#define CHOL_PIVOT_TOL 1e-8 // Relative pivot below which a cell is pinned
+
+///////////////////////////////////////////////////////////////////////////////
+/// Sparse Cholesky solver for pressure
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int CHOL_P(PARA_DATA *para, REAL **var, REAL *x);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the sparse Cholesky solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_chol_data();
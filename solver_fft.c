@@ -0,0 +1,424 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_fft.c
+///
+/// \brief  Direct solver for pressure based on fast cosine transform
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/16/2026
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "solver_fft.h"
+
+static FFT_PLAN fft_plan[3]; // Transforms in X, Y and Z directions
+static double *fft_data = NULL; // Interior values in transformed space
+static int fft_size = 0;
+static int fft_state = -1; // -1: not checked, 0: not available, 1: available
+static double fft_c[3]; // Uniform coefficients in X, Y and Z directions
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of one transform
+///
+///\param plan Pointer to the transform
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void fft_free_plan(FFT_PLAN *plan) {
+  if(plan->wre!=NULL) free(plan->wre);
+  if(plan->wim!=NULL) free(plan->wim);
+  if(plan->sre!=NULL) free(plan->sre);
+  if(plan->sim!=NULL) free(plan->sim);
+  if(plan->lambda!=NULL) free(plan->lambda);
+  if(plan->re!=NULL) free(plan->re);
+  if(plan->im!=NULL) free(plan->im);
+  if(plan->ore!=NULL) free(plan->ore);
+  if(plan->oim!=NULL) free(plan->oim);
+  if(plan->tre!=NULL) free(plan->tre);
+  if(plan->tim!=NULL) free(plan->tim);
+  memset(plan, 0, sizeof(FFT_PLAN));
+} // End of fft_free_plan()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set up the transform of length n
+///
+///\param plan Pointer to the transform
+///\param n Length of the transform
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int fft_set_plan(FFT_PLAN *plan, int n) {
+  int m, p, rest;
+
+  if(plan->n==n) return 0;
+  fft_free_plan(plan);
+
+  plan->wre = (double *) malloc(n*sizeof(double));
+  plan->wim = (double *) malloc(n*sizeof(double));
+  plan->sre = (double *) malloc(n*sizeof(double));
+  plan->sim = (double *) malloc(n*sizeof(double));
+  plan->lambda = (double *) malloc(n*sizeof(double));
+  plan->re = (double *) malloc(n*sizeof(double));
+  plan->im = (double *) malloc(n*sizeof(double));
+  plan->ore = (double *) malloc(n*sizeof(double));
+  plan->oim = (double *) malloc(n*sizeof(double));
+  plan->tre = (double *) malloc(n*sizeof(double));
+  plan->tim = (double *) malloc(n*sizeof(double));
+  if(!plan->wre || !plan->wim || !plan->sre || !plan->sim || !plan->lambda
+     || !plan->re || !plan->im || !plan->ore || !plan->oim
+     || !plan->tre || !plan->tim) {
+    fft_free_plan(plan);
+    return 1;
+  }
+
+  for(m=0; m<n; m++) {
+    plan->wre[m] = cos(2.0*FFT_PI*m/n);
+    plan->wim[m] = -sin(2.0*FFT_PI*m/n);
+    plan->sre[m] = cos(0.5*FFT_PI*m/n);
+    plan->sim[m] = -sin(0.5*FFT_PI*m/n);
+    plan->lambda[m] = 2.0 - 2.0*cos(FFT_PI*m/n);
+  }
+
+  // Prime factors of n, the transform is split by the smallest one first
+  plan->nb_factor = 0;
+  rest = n;
+  for(p=2; rest>1; p++)
+    while(rest%p==0) {
+      plan->factor[plan->nb_factor++] = p;
+      rest /= p;
+    }
+
+  plan->n = n;
+  return 0;
+} // End of fft_set_plan()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Mixed radix fast Fourier transform by recursive decimation in time
+///
+/// The transform of length n is split into p transforms of length n/p, where
+/// p is the factor at the given depth. The results are combined in place
+/// using the twiddle factors of the full length.
+///
+///\param plan Pointer to the transform
+///\param in_re Pointer to the real part of the input
+///\param in_im Pointer to the imaginary part of the input
+///\param stride Stride of the input
+///\param out_re Pointer to the real part of the output
+///\param out_im Pointer to the imaginary part of the output
+///\param n Length of the transform
+///\param depth Index of the factor
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void fft_recursive(FFT_PLAN *plan, double *in_re, double *in_im,
+                          int stride, double *out_re, double *out_im, int n,
+                          int depth) {
+  int p, m, r, q, k, e, step;
+  double sre, sim;
+
+  if(n==1) {
+    out_re[0] = in_re[0];
+    out_im[0] = in_im[0];
+    return;
+  }
+
+  p = plan->factor[depth];
+  m = n / p;
+  step = plan->n / n;
+
+  for(r=0; r<p; r++)
+    fft_recursive(plan, in_re+r*stride, in_im+r*stride, stride*p,
+                  out_re+r*m, out_im+r*m, m, depth+1);
+
+  for(k=0; k<m; k++) {
+    // Sub-transforms twiddled by W_n^(r*k)
+    for(r=0; r<p; r++) {
+      e = (r*k*step) % plan->n;
+      plan->tre[r] = out_re[r*m+k]*plan->wre[e] - out_im[r*m+k]*plan->wim[e];
+      plan->tim[r] = out_re[r*m+k]*plan->wim[e] + out_im[r*m+k]*plan->wre[e];
+    }
+    // DFT of length p
+    for(q=0; q<p; q++) {
+      sre = 0;
+      sim = 0;
+      for(r=0; r<p; r++) {
+        e = (r*q*m*step) % plan->n;
+        sre += plan->tre[r]*plan->wre[e] - plan->tim[r]*plan->wim[e];
+        sim += plan->tre[r]*plan->wim[e] + plan->tim[r]*plan->wre[e];
+      }
+      out_re[q*m+k] = sre;
+      out_im[q*m+k] = sim;
+    }
+  }
+} // End of fft_recursive()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Discrete cosine transform of the line stored in plan->re
+///
+/// The forward transform (DCT-II) is
+/// X[m] = sum_k x[k] cos(PI*m*(2k+1)/(2n)).
+/// The backward transform is the exact inverse of the forward one. Both are
+/// computed by one complex FFT of length n after reordering the input with
+/// even indices first and odd indices reversed.
+///
+///\param plan Pointer to the transform
+///\param backward 0: forward transform, 1: backward transform
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void fft_dct(FFT_PLAN *plan, int backward) {
+  int n = plan->n, k, m;
+  double *re = plan->re, *im = plan->im, *ore = plan->ore, *oim = plan->oim;
+  double xm, xnm;
+
+  if(n==1) return;
+
+  if(!backward) {
+    for(k=0; k<n; k++) {
+      m = k%2==0 ? k/2 : n-1-k/2;
+      ore[m] = re[k];
+      oim[m] = 0;
+    }
+    fft_recursive(plan, ore, oim, 1, re, im, n, 0);
+    for(m=0; m<n; m++)
+      re[m] = re[m]*plan->sre[m] - im[m]*plan->sim[m];
+  }
+  else {
+    // The inverse FFT is the conjugate of the forward FFT of the conjugate,
+    // conj(V[m]) = conj(exp(i*PI*m/(2n)) * (X[m] - i*X[n-m])) with X[n] = 0
+    ore[0] = re[0];
+    oim[0] = 0;
+    for(m=1; m<n; m++) {
+      xm = re[m];
+      xnm = re[n-m];
+      ore[m] = xm*plan->sre[m] - xnm*plan->sim[m];
+      oim[m] = xm*plan->sim[m] + xnm*plan->sre[m];
+    }
+    fft_recursive(plan, ore, oim, 1, re, im, n, 0);
+    // The result is real
+    for(m=0; m<n; m++) ore[m] = re[m];
+    for(k=0; k<n; k++) {
+      m = k%2==0 ? k/2 : n-1-k/2;
+      re[k] = ore[m] / n;
+    }
+  }
+} // End of fft_dct()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Apply the discrete cosine transform to all lines in one direction
+///
+///\param para Pointer to FFD parameters
+///\param dir Direction: 0 for X, 1 for Y, 2 for Z
+///\param backward 0: forward transform, 1: backward transform
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void fft_transform(PARA_DATA *para, int dir, int backward) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int n[3], stride[3], a, b, c, l;
+  int d1 = (dir+1)%3, d2 = (dir+2)%3;
+  FFT_PLAN *plan = &fft_plan[dir];
+  double *line;
+
+  n[0] = imax; n[1] = jmax; n[2] = kmax;
+  stride[0] = 1; stride[1] = imax; stride[2] = imax*jmax;
+
+  if(n[dir]==1) return;
+
+  for(b=0; b<n[d2]; b++)
+    for(a=0; a<n[d1]; a++) {
+      line = fft_data + a*stride[d1] + b*stride[d2];
+      for(l=0, c=0; l<n[dir]; l++, c+=stride[dir]) plan->re[l] = line[c];
+      fft_dct(plan, backward);
+      for(l=0, c=0; l<n[dir]; l++, c+=stride[dir]) line[c] = plan->re[l];
+    }
+} // End of fft_transform()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the largest prime factor of a length
+///
+///\param n Length
+///
+///\return Largest prime factor, 1 for n=1
+///////////////////////////////////////////////////////////////////////////////
+static int fft_max_factor(int n) {
+  int p, f = 1;
+
+  for(p=2; p*p<=n; p++)
+    while(n%p==0) {
+      f = p;
+      n /= p;
+    }
+
+  return n>1 ? n : f;
+} // End of fft_max_factor()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Check if the pressure equation can be solved by FFT_P()
+///
+/// The equation must have fluid in all interior cells, the same coefficient
+/// on all interior faces of each direction and no link to the boundary
+/// cells, which is the case for an empty box on a uniform grid. The number
+/// of cells in each direction must not have a prime factor larger than
+/// FFT_MAX_FACTOR, since each factor p costs p operations per value. The
+/// result is stored since the coefficients only depend on the geometry.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 1 if the equation can be solved, otherwise 0
+///////////////////////////////////////////////////////////////////////////////
+int FFT_P_available(PARA_DATA *para, REAL **var) {
+  REAL *ae = var[AE], *aw = var[AW], *an = var[AN], *as = var[AS];
+  REAL *af = var[AF], *ab = var[AB], *ap = var[AP];
+  CELL_MASK *mask = cell_mask(para);
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, f, size = imax*jmax*kmax;
+  double cx, cy, cz, tol = 1e-4;
+
+  if(fft_state>=0 && fft_size==size) return fft_state;
+  if(mask==NULL) return 0;
+
+  fft_state = 0;
+  fft_size = size;
+
+  f = max(fft_max_factor(imax), fft_max_factor(jmax));
+  f = max(f, fft_max_factor(kmax));
+  if(f>FFT_MAX_FACTOR) {
+    sprintf(msg, "FFT_P_available(): The mesh of %dx%dx%d cells has the "
+            "prime factor %d, which is larger than %d. The pressure is solved "
+            "by the selected solver.", imax, jmax, kmax, f, FFT_MAX_FACTOR);
+    ffd_log(msg, FFD_WARNING);
+    return 0;
+  }
+
+  cx = imax>1 ? ae[IX(1,1,1)] : 0;
+  cy = jmax>1 ? an[IX(1,1,1)] : 0;
+  cz = kmax>1 ? af[IX(1,1,1)] : 0;
+  if(cx<0 || cy<0 || cz<0 || cx+cy+cz<=0) return 0;
+
+  FOR_EACH_CELL
+    if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) return 0;
+
+    if(fabs(ae[IX(i,j,k)] - (i<imax ? cx : 0))>tol*cx) return 0;
+    if(fabs(aw[IX(i,j,k)] - (i>1 ? cx : 0))>tol*cx) return 0;
+    if(fabs(an[IX(i,j,k)] - (j<jmax ? cy : 0))>tol*cy) return 0;
+    if(fabs(as[IX(i,j,k)] - (j>1 ? cy : 0))>tol*cy) return 0;
+    if(fabs(af[IX(i,j,k)] - (k<kmax ? cz : 0))>tol*cz) return 0;
+    if(fabs(ab[IX(i,j,k)] - (k>1 ? cz : 0))>tol*cz) return 0;
+    if(fabs(ap[IX(i,j,k)] - ae[IX(i,j,k)] - aw[IX(i,j,k)] - an[IX(i,j,k)]
+            - as[IX(i,j,k)] - af[IX(i,j,k)] - ab[IX(i,j,k)])
+       >tol*ap[IX(i,j,k)]) return 0;
+  END_FOR
+
+  fft_c[0] = cx;
+  fft_c[1] = cy;
+  fft_c[2] = cz;
+  fft_state = 1;
+
+  sprintf(msg, "FFT_P_available(): Pressure is solved by fast cosine "
+          "transform on %dx%dx%d cells.", imax, jmax, kmax);
+  ffd_log(msg, FFD_NORMAL);
+
+  return fft_state;
+} // End of FFT_P_available()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Direct solver for pressure based on fast cosine transform
+///
+/// The right hand side is transformed in X, Y and Z directions, divided by
+/// the eigenvalues cx*lx+cy*ly+cz*lz with l=2-2cos(PI*m/n) and transformed
+/// back. The pressure is only determined up to a constant and the solution
+/// with zero mean is returned.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int FFT_P(PARA_DATA *para, REAL **var, REAL *x) {
+  REAL *ae = var[AE], *aw = var[AW], *an = var[AN], *as = var[AS];
+  REAL *af = var[AF], *ab = var[AB], *ap = var[AP], *b = var[B];
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, c, size = imax*jmax*kmax;
+  double eig, r, norm_r = 0, norm_b = 0;
+
+  if(fft_data==NULL) {
+    fft_data = (double *) malloc(size*sizeof(double));
+    if(fft_data==NULL
+       || fft_set_plan(&fft_plan[0], imax)!=0
+       || fft_set_plan(&fft_plan[1], jmax)!=0
+       || fft_set_plan(&fft_plan[2], kmax)!=0) {
+      ffd_log("FFT_P(): Could not allocate memory.", FFD_ERROR);
+      free_fft_data();
+      return 1;
+    }
+  }
+
+  FOR_EACH_CELL
+    fft_data[(i-1)+imax*(j-1)+imax*jmax*(k-1)] = b[IX(i,j,k)];
+  END_FOR
+
+  fft_transform(para, 0, 0);
+  fft_transform(para, 1, 0);
+  fft_transform(para, 2, 0);
+
+  for(k=0; k<kmax; k++)
+    for(j=0; j<jmax; j++)
+      for(i=0; i<imax; i++) {
+        c = i + imax*j + imax*jmax*k;
+        eig = fft_c[0]*fft_plan[0].lambda[i] + fft_c[1]*fft_plan[1].lambda[j]
+            + fft_c[2]*fft_plan[2].lambda[k];
+        fft_data[c] = c==0 ? 0 : fft_data[c]/eig;
+      }
+
+  fft_transform(para, 2, 1);
+  fft_transform(para, 1, 1);
+  fft_transform(para, 0, 1);
+
+  FOR_EACH_CELL
+    x[IX(i,j,k)] = (REAL) fft_data[(i-1)+imax*(j-1)+imax*jmax*(k-1)];
+  END_FOR
+
+  para->solv->iter = 1;
+  para->solv->residual = 0;
+
+  if(para->solv->check_residual==1) {
+    FOR_EACH_CELL
+      r = b[IX(i,j,k)] - ap[IX(i,j,k)]*x[IX(i,j,k)]
+        + ae[IX(i,j,k)]*x[IX(i+1,j,k)] + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+        + an[IX(i,j,k)]*x[IX(i,j+1,k)] + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+        + af[IX(i,j,k)]*x[IX(i,j,k+1)] + ab[IX(i,j,k)]*x[IX(i,j,k-1)];
+      norm_r += r * r;
+      norm_b += b[IX(i,j,k)] * b[IX(i,j,k)];
+    END_FOR
+    para->solv->residual = (REAL) (norm_b>0 ? sqrt(norm_r/norm_b) : 0);
+    sprintf(msg, "FFT_P(): Residual of pressure is %e", para->solv->residual);
+    ffd_log(msg, FFD_NORMAL);
+  }
+
+  return 0;
+} // End of FFT_P()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the FFT solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_fft_data() {
+  if(fft_data!=NULL) free(fft_data);
+  fft_data = NULL;
+  fft_free_plan(&fft_plan[0]);
+  fft_free_plan(&fft_plan[1]);
+  fft_free_plan(&fft_plan[2]);
+  fft_size = 0;
+  fft_state = -1;
+} // End of free_fft_data()
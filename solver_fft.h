@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_fft.h
+///
+/// \brief  Direct solver for pressure based on fast cosine transform
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/16/2026
+///
+/// For an empty box on a uniform grid whose walls are all boundary cells,
+/// the pressure equation assembled in project() is the Laplace operator with
+/// zero gradient on all walls. Its eigenvectors are the cosine functions, so
+/// that the equation is solved directly by a discrete cosine transform (DCT)
+/// in each direction. The DCT is computed by a mixed radix fast Fourier
+/// transform (FFT) with O(N log N) operations. The factors of the FFT are
+/// transformed directly, so the mesh sizes must not have a prime factor
+/// larger than FFT_MAX_FACTOR.
+///
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _SOLVER_FFT_H
+#define _SOLVER_FFT_H
+#endif
+
+#ifndef _DATA_STRUCTURE_H
+#define _DATA_STRUCTURE_H
+#include "data_structure.h"
+#endif
+
+#ifndef _UTILITY_H
+#define _UTILITY_H
+#include "utility.h"
+#endif
+
+#define FFT_PI 3.14159265358979323846 // PI in data_structure.h is too short
+#define FFT_MAX_FACTOR 7 // Largest prime factor of the mesh sizes for FFT
+
+// Transform of one direction
+typedef struct {
+  int n; // Length
+  int nb_factor; // Number of prime factors of n
+  int factor[32]; // Prime factors of n
+  double *wre, *wim; // Twiddle factors exp(-2*PI*i*t/n)
+  double *sre, *sim; // Shift factors exp(-PI*i*m/(2n))
+  double *lambda; // Eigenvalues 2-2cos(PI*m/n)
+  double *re, *im, *ore, *oim, *tre, *tim; // Work arrays
+}FFT_PLAN;
+
+///////////////////////////////////////////////////////////////////////////////
+/// Check if the pressure equation can be solved by FFT_P()
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 1 if the equation can be solved, otherwise 0
+///////////////////////////////////////////////////////////////////////////////
+int FFT_P_available(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Direct solver for pressure based on fast cosine transform
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int FFT_P(PARA_DATA *para, REAL **var, REAL *x);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the FFT solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_fft_data();
@@ -17,114 +17,213 @@
 
 #include "solver_gs.h"
 
+static STENCIL *gs_stencil = NULL; // Interleaved coefficients of the cells
+static int gs_stencil_size = 0;
+
 ///////////////////////////////////////////////////////////////////////////////
-/// Gauss-Seidel solver for pressure
+/// Copy the coefficients into the interleaved storage
+///
+/// If para->solv->stencil is 1, the coefficients ap, ae, aw, an, as, af, ab
+/// and b of each cell are copied next to each other, so that the update of
+/// a cell reads one stream of coefficients instead of eight. Only the cells
+/// of the runs are copied. The copy is made once per solve, so that it pays
+/// off if the solver makes several sweeps.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param Type Type of variable
+///\param list Pointer to the runs of the cells to be solved
+///
+///\return Pointer to the coefficients, NULL if the separate arrays are used
+///////////////////////////////////////////////////////////////////////////////
+static STENCIL *GS_pack_stencil(PARA_DATA *para, REAL **var, RUN_LIST *list) {
+  REAL *as = var[AS], *aw = var[AW], *ae = var[AE], *an = var[AN];
+  REAL *ap = var[AP], *af = var[AF], *ab = var[AB], *b = var[B];
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int size = IJMAX*(kmax+2);
+  int i, j, k, r, c;
+  STENCIL *st;
+
+  if(para->solv->stencil!=1 || list==NULL) return NULL;
+
+  if(gs_stencil==NULL || gs_stencil_size<size) {
+    free_gs_data();
+    gs_stencil = (STENCIL *) malloc(size*sizeof(STENCIL));
+    if(gs_stencil==NULL) {
+      ffd_log("GS_pack_stencil(): Could not allocate memory, use separate "
+              "coefficients.", FFD_WARNING);
+      para->solv->stencil = 0;
+      return NULL;
+    }
+    gs_stencil_size = size;
+  }
+
+  st = gs_stencil;
+  FOR_EACH_RUN(list)
+    c = IX(i,j,k);
+    st[c].ap = ap[c];
+    st[c].ae = ae[c];
+    st[c].aw = aw[c];
+    st[c].an = an[c];
+    st[c].as = as[c];
+    st[c].af = af[c];
+    st[c].ab = ab[c];
+    st[c].b = b[c];
+  END_FOR
+
+  return st;
+} // End of GS_pack_stencil()
+
+///////////////////////////////////////////////////////////////////////////////
+/// One sweep of the Gauss-Seidel solver with interleaved coefficients
+///
+/// Same as GS_sweep() but the coefficients are read from GS_pack_stencil().
+///
+///\param para Pointer to FFD parameters
+///\param list Pointer to the runs of the cells to be solved
+///\param st Pointer to the interleaved coefficients
 ///\param x Pointer to variable
+///\param dir Direction of the sweep
 ///
 ///\return Residual
 ///////////////////////////////////////////////////////////////////////////////
-REAL GS_P(PARA_DATA *para, REAL **var, int Type, REAL *x) {
+static REAL GS_sweep_stencil(PARA_DATA *para, RUN_LIST *list, STENCIL *st,
+                             REAL *x, int dir) {
+  int imax = para->geom->imax, jmax= para->geom->jmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, n, r, c, c1, c2, step;
+  REAL tmp;
+  double sum_r = 0, sum_x = 0.0000000001;
+
+  for(n=0; n<list->nb_run; n++) {
+    r = dir<2 ? n : list->nb_run-1-n;
+    i = list->run[r].i1;
+    j = list->run[r].j;
+    k = list->run[r].k;
+    c1 = IX(i,j,k);
+    c2 = c1 + list->run[r].i2 - i;
+    step = dir%3==0 ? 1 : -1;
+    if(step<0) {
+      c = c1;
+      c1 = c2;
+      c2 = c;
+    }
+
+    for(c=c1; c!=c2+step; c+=step) {
+      tmp = (  st[c].ae*x[c+1] + st[c].aw*x[c-1]
+             + st[c].an*x[c+IMAX] + st[c].as*x[c-IMAX]
+             + st[c].af*x[c+IJMAX] + st[c].ab*x[c-IJMAX]
+             + st[c].b ) / st[c].ap;
+
+      sum_r += fabs(st[c].ap*(tmp-x[c]));
+      sum_x += fabs(st[c].ap*tmp);
+      x[c] = tmp;
+    }
+  }
+
+  return (REAL) (sum_r/sum_x);
+} // End of GS_sweep_stencil()
+
+///////////////////////////////////////////////////////////////////////////////
+/// One sweep of the Gauss-Seidel solver
+///
+/// The residual is accumulated during the sweep. Before a cell is updated,
+/// ap*(x_new-x_old) equals the residual of its equation, so that no extra
+/// pass over the cells is needed.
+///
+/// Only the runs of fluid cells from cell_run() are visited. The directions
+/// of the sweep are:
+/// 0: Z(1->kmax), Y(1->jmax), X(1->imax)
+/// 1: Z(1->kmax), Y(1->jmax), X(imax->1)
+/// 2: Z(kmax->1), Y(jmax->1), X(imax->1)
+/// 3: Z(kmax->1), Y(jmax->1), X(1->imax)
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param shift Shift of the location in the cell types: MASK_P, MASK_U,
+///             MASK_V or MASK_W
+///\param x Pointer to variable
+///\param dir Direction of the sweep
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL GS_sweep(PARA_DATA *para, REAL **var, int shift, REAL *x, int dir) {
   REAL *as = var[AS], *aw = var[AW], *ae = var[AE], *an = var[AN];
   REAL *ap = var[AP], *af = var[AF], *ab = var[AB], *b = var[B];
   int imax = para->geom->imax, jmax= para->geom->jmax;
-  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);  
-  int i, j, k, it;
-  float tmp1, tmp2, residual;
-  REAL *flagp = var[FLAGP];
-
-  /****************************************************************************
-  | Solve the space using G-S sovler for 5 * 6 = 30 times
-  ****************************************************************************/
-  for(it=0; it<5; it++) {
-    /*-------------------------------------------------------------------------
-    | Solve in X(1->imax), Y(1->jmax), Z(1->kmax)
-    -------------------------------------------------------------------------*/
-    for(i=1; i<=imax; i++)
-      for(j=1; j<=jmax; j++)
-        for(k=1; k<=kmax; k++) {
-          if (flagp[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
-    }
+  int i, j, k, n, r, c, c1, c2, step;
+  REAL tmp;
+  double sum_r = 0, sum_x = 0.0000000001;
+  RUN_LIST *list = cell_run(para, shift);
 
-    /*-------------------------------------------------------------------------
-    | Solve in Y(1->kmax), X(1->imax), Z(1->kmax)
-    -------------------------------------------------------------------------*/
-    for(j=1; j<=jmax; j++)
-      for(i=1; i<=imax; i++)
-        for(k=1; k<=kmax; k++) {
-          if (flagp[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
-    }
-    /*-------------------------------------------------------------------------
-    | Solve in X(imax->), Y(jmax->1), Z(1->kmax)
-    -------------------------------------------------------------------------*/
-    for(i=imax; i>=1; i--)
-      for(j=jmax; j>=1; j--)
-        for(k=1; k<=kmax; k++) {
-          if (flagp[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+  if(list==NULL) return 0;
+
+  for(n=0; n<list->nb_run; n++) {
+    r = dir<2 ? n : list->nb_run-1-n;
+    i = list->run[r].i1;
+    j = list->run[r].j;
+    k = list->run[r].k;
+    c1 = IX(i,j,k);
+    c2 = c1 + list->run[r].i2 - i;
+    step = dir%3==0 ? 1 : -1;
+    if(step<0) {
+      c = c1;
+      c1 = c2;
+      c2 = c;
     }
-    /*-------------------------------------------------------------------------
-    | Solve in Y(jmax->1), X(imax->1), Z(1->kmax)
-    -------------------------------------------------------------------------*/
-    for(j=jmax; j>=1; j--)
-      for(i=imax; i>=1; i--)
-        for(k=1; k<=kmax; k++) {
-          if (flagp[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+
+    for(c=c1; c!=c2+step; c+=step) {
+      tmp = (  ae[c]*x[c+1] + aw[c]*x[c-1]
+             + an[c]*x[c+IMAX] + as[c]*x[c-IMAX]
+             + af[c]*x[c+IJMAX] + ab[c]*x[c-IJMAX]
+             + b[c] ) / ap[c];
+
+      sum_r += fabs(ap[c]*(tmp-x[c]));
+      sum_x += fabs(ap[c]*tmp);
+      x[c] = tmp;
     }
   }
 
-  /****************************************************************************
-  | Calculate residual
-  ****************************************************************************/
-  tmp1 = 0;
-  tmp2 = (REAL)0.0000000001;
-
-  FOR_EACH_CELL
-    if (flagp[IX(i,j,k)]>=0) continue;
-    tmp1 += (REAL) fabs(ap[IX(i,j,k)]*x[IX(i,j,k)] 
-        - ae[IX(i,j,k)]*x[IX(i+1,j,k)] - aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-        - an[IX(i,j,k)]*x[IX(i,j+1,k)] - as[IX(i,j,k)]*x[IX(i,j-1,k)]
-        - af[IX(i,j,k)]*x[IX(i,j,k+1)] - ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-        - b[IX(i,j,k)]);
-    tmp2 += (REAL) fabs(ap[IX(i,j,k)]*x[IX(i,j,k)]);
-  END_FOR
+  return (REAL) (sum_r/sum_x);
+} // End of GS_sweep()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Gauss-Seidel solver for pressure
+///
+/// Each iteration consists of 4 sweeps in the directions 0 to 3 of
+/// GS_sweep(). The solver stops after the first sweep whose residual is
+/// below para->solv->p_tol or after para->solv->p_max_iter iterations
+/// (GS_P_MAX_ITER if 0). The residual is the relative change of the sweep
+/// sum|ap*(x_new-x_old)|/sum|ap*x_new|, so that a tolerance of 0 gives a
+/// fixed number of sweeps.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL GS_P(PARA_DATA *para, REAL **var, REAL *x) {
+  int it, dir, sweep = 0;
+  int max_iter = para->solv->p_max_iter>0 ? para->solv->p_max_iter
+                                          : GS_P_MAX_ITER;
+  REAL residual = 1;
+  RUN_LIST *list = cell_run(para, MASK_P);
+  STENCIL *st = GS_pack_stencil(para, var, list);
 
-  residual = tmp1 /tmp2;
+  for(it=0; it<max_iter && residual>para->solv->p_tol; it++)
+    for(dir=0; dir<4 && residual>para->solv->p_tol; dir++) {
+      if(st!=NULL)
+        residual = GS_sweep_stencil(para, list, st, x, dir);
+      else
+        residual = GS_sweep(para, var, MASK_P, x, dir);
+      sweep++;
+    }
+
+  para->solv->iter = sweep;
+  para->solv->residual = residual;
 
   return residual;
 } // End of GS_P()
@@ -132,74 +231,278 @@ REAL GS_P(PARA_DATA *para, REAL **var, int Type, REAL *x) {
 ///////////////////////////////////////////////////////////////////////////////
 /// Gauss-Seidel solver
 ///
+/// Each iteration consists of a forward (direction 0) and a backward 
+/// (direction 2) sweep. The solver stops after the first sweep whose residual
+/// is below tol or after max_iter iterations.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param flag Pointer to the cell property flag
+///\param shift Shift of the location in the cell types: MASK_P, MASK_U,
+///             MASK_V or MASK_W
 ///\param x Pointer to variable
+///\param tol Tolerance of the residual
+///\param max_iter Maximum number of iterations
 ///
 ///\return Residual
 ///////////////////////////////////////////////////////////////////////////////
-REAL Gauss_Seidel(PARA_DATA *para, REAL **var, REAL *flag, REAL *x) {
+REAL Gauss_Seidel(PARA_DATA *para, REAL **var, int shift, REAL *x,
+                  REAL tol, int max_iter) {
+  int it, dir, sweep = 0;
+  REAL residual = 1;
+  RUN_LIST *list = cell_run(para, shift);
+  STENCIL *st = GS_pack_stencil(para, var, list);
+
+  for(it=0; it<max_iter && residual>tol; it++)
+    for(dir=0; dir<4 && residual>tol; dir+=2) {
+      if(st!=NULL)
+        residual = GS_sweep_stencil(para, list, st, x, dir);
+      else
+        residual = GS_sweep(para, var, shift, x, dir);
+      sweep++;
+    }
+
+  para->solv->iter = sweep;
+  para->solv->residual = residual;
+
+  return residual;
+} // End of Gauss-Seidel( )
+
+///////////////////////////////////////////////////////////////////////////////
+/// Update the cells of one color in red-black ordered Gauss-Seidel solver
+///
+/// A cell (i,j,k) has the color (i+j+k)%2. The cells of one color only depend
+/// on the cells of the other color, so that the k-planes are updated in
+/// parallel and the result does not depend on the number of threads. The
+/// sums of the residual are added to sum_r[k] and sum_x[k] of each k-plane.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param shift Shift of the location in the cell types: MASK_P, MASK_U,
+///             MASK_V or MASK_W
+///\param x Pointer to variable
+///\param color Color of the cells to be updated: 0 or 1
+///\param sum_r Pointer to the sums of |ap*(x_new-x_old)| in each k-plane
+///\param sum_x Pointer to the sums of |ap*x_new| in each k-plane
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void GS_color_sweep(PARA_DATA *para, REAL **var, int shift, REAL *x,
+                    int color, double *sum_r, double *sum_x) {
   REAL *as = var[AS], *aw = var[AW], *ae = var[AE], *an = var[AN];
   REAL *ap = var[AP], *af = var[AF], *ab = var[AB], *b = var[B];
   int imax = para->geom->imax, jmax= para->geom->jmax;
   int kmax = para->geom->kmax;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);  
-  int i, j, k, it=0;
-  float tmp1, tmp2, residual;
-
-  /****************************************************************************
-  | Gauss-Seidel solver
-  ****************************************************************************/
-  for(it=0; it<1; it++) {
-    for(i=1; i<=imax; i++)
-      for(j=1; j<=jmax; j++)
-        for(k=1; k<=kmax; k++) {
-          if (flag[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
-
-        }
-    
-    for(i=imax; i>=1; i--)
-      for(j=jmax; j>=1; j--)
-        for(k=1; k<=kmax; k++) {
-          if (flag[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
-        }    
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, r;
+  REAL tmp;
+  RUN_LIST *list = cell_run(para, shift);
+
+  if(list==NULL) return;
+
+#pragma omp parallel for private(i, j, r, tmp) schedule(static)
+  for(k=1; k<=kmax; k++)
+    for(r=list->plane[k]; r<list->plane[k+1]; r++) {
+      j = list->run[r].j;
+      i = list->run[r].i1;
+      // First cell of the color in the run
+      if((i+j+k+color)%2!=0) i++;
+      for(; i<=list->run[r].i2; i+=2) {
+        tmp = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
+               + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+               + an[IX(i,j,k)]*x[IX(i,j+1,k)]
+               + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+               + af[IX(i,j,k)]*x[IX(i,j,k+1)]
+               + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
+               + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+
+        sum_r[k] += fabs(ap[IX(i,j,k)]*(tmp-x[IX(i,j,k)]));
+        sum_x[k] += fabs(ap[IX(i,j,k)]*tmp);
+        x[IX(i,j,k)] = tmp;
+      }
+    }
+} // End of GS_color_sweep()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Update the cells of one color with interleaved coefficients
+///
+/// Same as GS_color_sweep() but the coefficients are read from
+/// GS_pack_stencil().
+///
+///\param para Pointer to FFD parameters
+///\param list Pointer to the runs of the cells to be solved
+///\param st Pointer to the interleaved coefficients
+///\param x Pointer to variable
+///\param color Color of the cells to be updated: 0 or 1
+///\param sum_r Pointer to the sums of |ap*(x_new-x_old)| in each k-plane
+///\param sum_x Pointer to the sums of |ap*x_new| in each k-plane
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void GS_color_sweep_stencil(PARA_DATA *para, RUN_LIST *list,
+                                   STENCIL *st, REAL *x, int color,
+                                   double *sum_r, double *sum_x) {
+  int imax = para->geom->imax, jmax= para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, r, c;
+  REAL tmp;
+
+#pragma omp parallel for private(i, j, r, c, tmp) schedule(static)
+  for(k=1; k<=kmax; k++)
+    for(r=list->plane[k]; r<list->plane[k+1]; r++) {
+      j = list->run[r].j;
+      i = list->run[r].i1;
+      // First cell of the color in the run
+      if((i+j+k+color)%2!=0) i++;
+      for(; i<=list->run[r].i2; i+=2) {
+        c = IX(i,j,k);
+        tmp = (  st[c].ae*x[c+1] + st[c].aw*x[c-1]
+               + st[c].an*x[c+IMAX] + st[c].as*x[c-IMAX]
+               + st[c].af*x[c+IJMAX] + st[c].ab*x[c-IJMAX]
+               + st[c].b ) / st[c].ap;
+
+        sum_r[k] += fabs(st[c].ap*(tmp-x[c]));
+        sum_x[k] += fabs(st[c].ap*tmp);
+        x[c] = tmp;
+      }
+    }
+} // End of GS_color_sweep_stencil()
+
+///////////////////////////////////////////////////////////////////////////////
+/// One red-black sweep with the residual
+///
+/// The sums of the k-planes are added in the order of k, which keeps the
+/// residual independent of the number of threads.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param shift Shift of the location in the cell types: MASK_P, MASK_U,
+///             MASK_V or MASK_W
+///\param x Pointer to variable
+///\param first Color updated first: 0 or 1
+///\param sum Pointer to the work array of size 2*(kmax+2)
+///\param st Pointer to the interleaved coefficients, NULL for the separate
+///          arrays
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+static REAL GS_rb_sweep(PARA_DATA *para, REAL **var, int shift, REAL *x,
+                        int first, double *sum, STENCIL *st) {
+  int k, kmax = para->geom->kmax;
+  double *sum_r = sum, *sum_x = sum + kmax + 2;
+  double tmp1 = 0, tmp2 = 0.0000000001;
+  RUN_LIST *list;
+
+  for(k=0; k<2*(kmax+2); k++)
+    sum[k] = 0;
+
+  if(st!=NULL) {
+    list = cell_run(para, shift);
+    GS_color_sweep_stencil(para, list, st, x, first, sum_r, sum_x);
+    GS_color_sweep_stencil(para, list, st, x, 1-first, sum_r, sum_x);
+  }
+  else {
+    GS_color_sweep(para, var, shift, x, first, sum_r, sum_x);
+    GS_color_sweep(para, var, shift, x, 1-first, sum_r, sum_x);
   }
 
-  /****************************************************************************
-  | Calculate residual
-  ****************************************************************************/
-  tmp1 = 0;
-  tmp2 = (REAL)0.0000000001;
-
-  FOR_EACH_CELL
-    if (flag[IX(i,j,k)]>=0) continue;
-    tmp1 += (REAL) fabs(ap[IX(i,j,k)]*x[IX(i,j,k)] 
-        - ae[IX(i,j,k)]*x[IX(i+1,j,k)] - aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-        - an[IX(i,j,k)]*x[IX(i,j+1,k)] - as[IX(i,j,k)]*x[IX(i,j-1,k)]
-        - af[IX(i,j,k)]*x[IX(i,j,k+1)] - ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-        - b[IX(i,j,k)]);
-    tmp2 += (REAL) fabs(ap[IX(i,j,k)]*x[IX(i,j,k)]);
-  END_FOR
+  for(k=1; k<=kmax; k++) {
+    tmp1 += sum_r[k];
+    tmp2 += sum_x[k];
+  }
 
-  residual = tmp1 /tmp2;
+  return (REAL) (tmp1/tmp2);
+} // End of GS_rb_sweep()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Red-black ordered Gauss-Seidel solver for pressure
+///
+/// Same stopping criterion and amount of work per iteration as GS_P().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL GS_P_RB(PARA_DATA *para, REAL **var, REAL *x) {
+  int it, n, sweep = 0;
+  int max_iter = para->solv->p_max_iter>0 ? para->solv->p_max_iter
+                                          : GS_P_MAX_ITER;
+  double *sum;
+  REAL residual = 1;
+  STENCIL *st = GS_pack_stencil(para, var, cell_run(para, MASK_P));
+
+  sum = (double *) malloc(2*(para->geom->kmax+2)*sizeof(double));
+  if(sum==NULL) {
+    ffd_log("GS_P_RB(): Could not allocate memory.", FFD_ERROR);
+    return -1;
+  }
+
+  for(it=0; it<max_iter && residual>para->solv->p_tol; it++)
+    for(n=0; n<4 && residual>para->solv->p_tol; n++) {
+      residual = GS_rb_sweep(para, var, MASK_P, x, n%2, sum, st);
+      sweep++;
+    }
+
+  free(sum);
+
+  para->solv->iter = sweep;
+  para->solv->residual = residual;
 
   return residual;
-} // End of Gauss-Seidel( )
+} // End of GS_P_RB()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Red-black ordered Gauss-Seidel solver
+///
+/// Same stopping criterion as Gauss_Seidel(): the red and black cells are 
+/// updated in a forward (red, black) and a backward (black, red) sweep.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param shift Shift of the location in the cell types: MASK_P, MASK_U,
+///             MASK_V or MASK_W
+///\param x Pointer to variable
+///\param tol Tolerance of the residual
+///\param max_iter Maximum number of iterations
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL Gauss_Seidel_RB(PARA_DATA *para, REAL **var, int shift, REAL *x,
+                     REAL tol, int max_iter) {
+  int it, n, sweep = 0;
+  double *sum;
+  REAL residual = 1;
+  STENCIL *st = GS_pack_stencil(para, var, cell_run(para, shift));
+
+  sum = (double *) malloc(2*(para->geom->kmax+2)*sizeof(double));
+  if(sum==NULL) {
+    ffd_log("Gauss_Seidel_RB(): Could not allocate memory.", FFD_ERROR);
+    return -1;
+  }
 
+  for(it=0; it<max_iter && residual>tol; it++)
+    for(n=0; n<2 && residual>tol; n++) {
+      residual = GS_rb_sweep(para, var, shift, x, n, sum, st);
+      sweep++;
+    }
+
+  free(sum);
+
+  para->solv->iter = sweep;
+  para->solv->residual = residual;
+
+  return residual;
+} // End of Gauss_Seidel_RB()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the interleaved coefficients of Gauss-Seidel solvers
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_gs_data() {
+  if(gs_stencil!=NULL) free(gs_stencil);
+  gs_stencil = NULL;
+  gs_stencil_size = 0;
+} // End of free_gs_data()
@@ -34,27 +34,102 @@
 #include "utility.h"
 #endif
 
+#define GS_P_MAX_ITER 5 // Default iterations of Gauss-Seidel solver for pressure
+#define GS_MAX_ITER 1 // Default iterations of Gauss-Seidel solver for transport
+
+// Coefficients of the equation of one cell stored next to each other
+typedef struct {
+  REAL ap, ae, aw, an, as, af, ab, b;
+}STENCIL;
+
+///////////////////////////////////////////////////////////////////////////////
+/// One sweep of the Gauss-Seidel solver
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param shift Shift of the location in the cell types: MASK_P, MASK_U,
+///             MASK_V or MASK_W
+///\param x Pointer to variable
+///\param dir Direction of the sweep
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL GS_sweep(PARA_DATA *para, REAL **var, int shift, REAL *x, int dir);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Gauss-Seidel solver for pressure
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param Type Type of variable
 ///\param x Pointer to variable
 ///
 ///\return Residual
 ///////////////////////////////////////////////////////////////////////////////
-REAL GS_P(PARA_DATA *para, REAL **var, int Type, REAL *x);
+REAL GS_P(PARA_DATA *para, REAL **var, REAL *x);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Gauss-Seidel solver
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param flag Pointer to the cell property flag
+///\param shift Shift of the location in the cell types: MASK_P, MASK_U,
+///             MASK_V or MASK_W
+///\param x Pointer to variable
+///\param tol Tolerance of the residual
+///\param max_iter Maximum number of iterations
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL Gauss_Seidel(PARA_DATA *para, REAL **var, int shift, REAL *x,
+                  REAL tol, int max_iter);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Update the cells of one color in red-black ordered Gauss-Seidel solver
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param shift Shift of the location in the cell types: MASK_P, MASK_U,
+///             MASK_V or MASK_W
 ///\param x Pointer to variable
+///\param color Color of the cells to be updated: 0 or 1
+///\param sum_r Pointer to the sums of |ap*(x_new-x_old)| in each k-plane
+///\param sum_x Pointer to the sums of |ap*x_new| in each k-plane
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void GS_color_sweep(PARA_DATA *para, REAL **var, int shift, REAL *x,
+                    int color, double *sum_r, double *sum_x);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Red-black ordered Gauss-Seidel solver for pressure
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL GS_P_RB(PARA_DATA *para, REAL **var, REAL *x);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Red-black ordered Gauss-Seidel solver
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param shift Shift of the location in the cell types: MASK_P, MASK_U,
+///             MASK_V or MASK_W
+///\param x Pointer to variable
+///\param tol Tolerance of the residual
+///\param max_iter Maximum number of iterations
 ///
 ///\return Residual
 ///////////////////////////////////////////////////////////////////////////////
-REAL Gauss_Seidel(PARA_DATA *para, REAL **var, REAL *flagp, REAL *x);
+REAL Gauss_Seidel_RB(PARA_DATA *para, REAL **var, int shift, REAL *x,
+                     REAL tol, int max_iter);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Free the interleaved coefficients of Gauss-Seidel solvers
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_gs_data();
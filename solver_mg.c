@@ -0,0 +1,580 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_mg.c
+///
+/// \brief  Geometric multigrid solver for pressure
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/16/2026
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "solver_mg.h"
+
+// Index on the coarse grid
+#define IXC(i,j,k) ((i)+(CIMAX)*(j)+(CIJMAX)*(k))
+
+static MG_LEVEL mg[MG_MAX_LEVEL];
+static int mg_nlev = 0;
+static int mg_singular = 1;
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the memory for a coarse grid level
+///
+///\param lev Pointer to the grid level
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int mg_allocate_level(MG_LEVEL *lev) {
+  int size = (lev->imax+2) * (lev->jmax+2) * (lev->kmax+2);
+
+  lev->ap = (REAL *) calloc(size, sizeof(REAL));
+  lev->ae = (REAL *) calloc(size, sizeof(REAL));
+  lev->aw = (REAL *) calloc(size, sizeof(REAL));
+  lev->an = (REAL *) calloc(size, sizeof(REAL));
+  lev->as = (REAL *) calloc(size, sizeof(REAL));
+  lev->af = (REAL *) calloc(size, sizeof(REAL));
+  lev->ab = (REAL *) calloc(size, sizeof(REAL));
+  lev->b = (REAL *) calloc(size, sizeof(REAL));
+  lev->x = (REAL *) calloc(size, sizeof(REAL));
+  lev->r = (REAL *) calloc(size, sizeof(REAL));
+  lev->flag = (CELL_MASK *) calloc(size, sizeof(CELL_MASK));
+
+  if(!lev->ap || !lev->ae || !lev->aw || !lev->an || !lev->as || !lev->af
+     || !lev->ab || !lev->b || !lev->x || !lev->r || !lev->flag)
+    return 1;
+
+  return 0;
+} // End of mg_allocate_level()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Build the grid hierarchy
+///
+/// The coarse grids are only allocated at the first call. The finest level
+/// points to the coefficients stored in var.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int mg_build_hierarchy(PARA_DATA *para, REAL **var, REAL *x) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int n;
+  MG_LEVEL *f, *c;
+
+  if(mg_nlev>0 && (mg[0].imax!=imax || mg[0].jmax!=jmax || mg[0].kmax!=kmax))
+    free_mg_data();
+
+  /****************************************************************************
+  | The finest level uses the coefficients in var
+  ****************************************************************************/
+  mg[0].imax = imax;
+  mg[0].jmax = jmax;
+  mg[0].kmax = kmax;
+  mg[0].ap = var[AP];
+  mg[0].ae = var[AE];
+  mg[0].aw = var[AW];
+  mg[0].an = var[AN];
+  mg[0].as = var[AS];
+  mg[0].af = var[AF];
+  mg[0].ab = var[AB];
+  mg[0].b = var[B];
+  mg[0].x = x;
+  mg[0].flag = cell_mask(para);
+  if(mg[0].flag==NULL) return 1;
+
+  if(mg_nlev>0) return 0;
+
+  mg[0].r = (REAL *) calloc((imax+2)*(jmax+2)*(kmax+2), sizeof(REAL));
+  if(mg[0].r==NULL) {
+    ffd_log("mg_build_hierarchy(): Could not allocate memory.", FFD_ERROR);
+    return 1;
+  }
+  mg_nlev = 1;
+
+  /****************************************************************************
+  | Coarsen a direction as long as it has more than 2 cells
+  ****************************************************************************/
+  for(n=1; n<MG_MAX_LEVEL; n++) {
+    f = &mg[n-1];
+    if(f->imax<=2 && f->jmax<=2 && f->kmax<=2) break;
+
+    f->ci = f->imax>2 ? 2 : 1;
+    f->cj = f->jmax>2 ? 2 : 1;
+    f->ck = f->kmax>2 ? 2 : 1;
+
+    c = &mg[n];
+    c->imax = (f->imax+f->ci-1) / f->ci;
+    c->jmax = (f->jmax+f->cj-1) / f->cj;
+    c->kmax = (f->kmax+f->ck-1) / f->ck;
+
+    mg_nlev++;
+    if(mg_allocate_level(c)!=0) {
+      ffd_log("mg_build_hierarchy(): Could not allocate memory.", FFD_ERROR);
+      free_mg_data();
+      return 1;
+    }
+  }
+
+  sprintf(msg, "mg_build_hierarchy(): Built %d grid levels for multigrid solver.",
+          mg_nlev);
+  ffd_log(msg, FFD_NORMAL);
+
+  return 0;
+} // End of mg_build_hierarchy()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Assemble the equations on the next coarser level
+///
+/// The equations of the fluid cells merged into one coarse cell are summed.
+/// Connections between the merged cells cancel out, while the connections to
+/// the cells which are not solved (boundaries) remain in the coarse
+/// coefficient ap.
+///
+///\param f Pointer to the fine grid level
+///\param c Pointer to the coarse grid level
+///
+///\return 1 if the fine equations contain no fixed value, otherwise 0
+///////////////////////////////////////////////////////////////////////////////
+static int mg_coarsen(MG_LEVEL *f, MG_LEVEL *c) {
+  int i, j, k, I, J, K, n;
+  int IMAX = f->imax+2, IJMAX = (f->imax+2)*(f->jmax+2);
+  int CIMAX = c->imax+2, CIJMAX = (c->imax+2)*(c->jmax+2);
+  int size = (c->imax+2) * (c->jmax+2) * (c->kmax+2);
+  int singular = 1;
+  REAL sx = f->ci==2 ? (REAL) 0.5 : 1;
+  REAL sy = f->cj==2 ? (REAL) 0.5 : 1;
+  REAL sz = f->ck==2 ? (REAL) 0.5 : 1;
+  REAL tmp;
+
+  for(n=0; n<size; n++) {
+    c->ap[n] = 0;
+    c->ae[n] = 0;
+    c->aw[n] = 0;
+    c->an[n] = 0;
+    c->as[n] = 0;
+    c->af[n] = 0;
+    c->ab[n] = 0;
+    c->flag[n] = CELL_CODE(SOLID, MASK_P);
+  }
+
+  for(k=1; k<=f->kmax; k++)
+    for(j=1; j<=f->jmax; j++)
+      for(i=1; i<=f->imax; i++) {
+        if(!IS_FLUID(f->flag[IX(i,j,k)], MASK_P)) continue;
+
+        I = (i-1)/f->ci + 1;
+        J = (j-1)/f->cj + 1;
+        K = (k-1)/f->ck + 1;
+        c->flag[IXC(I,J,K)] = CELL_CODE(FLUID, MASK_P);
+
+        /*---------------------------------------------------------------------
+        | Part of ap which is not related to the neighbors
+        ---------------------------------------------------------------------*/
+        tmp = f->ap[IX(i,j,k)] - f->ae[IX(i,j,k)] - f->aw[IX(i,j,k)]
+            - f->an[IX(i,j,k)] - f->as[IX(i,j,k)] - f->af[IX(i,j,k)]
+            - f->ab[IX(i,j,k)];
+        if(fabs(tmp) > 1e-5*f->ap[IX(i,j,k)]) {
+          c->ap[IXC(I,J,K)] += tmp;
+          singular = 0;
+        }
+
+        /*---------------------------------------------------------------------
+        | East and west
+        ---------------------------------------------------------------------*/
+        if(f->ae[IX(i,j,k)]!=0) {
+          if(i<f->imax && IS_FLUID(f->flag[IX(i+1,j,k)], MASK_P)) {
+            if(i/f->ci+1 != I) c->ae[IXC(I,J,K)] += sx*f->ae[IX(i,j,k)];
+          }
+          else {
+            c->ap[IXC(I,J,K)] += sx*f->ae[IX(i,j,k)];
+            singular = 0;
+          }
+        }
+        if(f->aw[IX(i,j,k)]!=0) {
+          if(i>1 && IS_FLUID(f->flag[IX(i-1,j,k)], MASK_P)) {
+            if((i-2)/f->ci+1 != I) c->aw[IXC(I,J,K)] += sx*f->aw[IX(i,j,k)];
+          }
+          else {
+            c->ap[IXC(I,J,K)] += sx*f->aw[IX(i,j,k)];
+            singular = 0;
+          }
+        }
+
+        /*---------------------------------------------------------------------
+        | North and south
+        ---------------------------------------------------------------------*/
+        if(f->an[IX(i,j,k)]!=0) {
+          if(j<f->jmax && IS_FLUID(f->flag[IX(i,j+1,k)], MASK_P)) {
+            if(j/f->cj+1 != J) c->an[IXC(I,J,K)] += sy*f->an[IX(i,j,k)];
+          }
+          else {
+            c->ap[IXC(I,J,K)] += sy*f->an[IX(i,j,k)];
+            singular = 0;
+          }
+        }
+        if(f->as[IX(i,j,k)]!=0) {
+          if(j>1 && IS_FLUID(f->flag[IX(i,j-1,k)], MASK_P)) {
+            if((j-2)/f->cj+1 != J) c->as[IXC(I,J,K)] += sy*f->as[IX(i,j,k)];
+          }
+          else {
+            c->ap[IXC(I,J,K)] += sy*f->as[IX(i,j,k)];
+            singular = 0;
+          }
+        }
+
+        /*---------------------------------------------------------------------
+        | Front and back
+        ---------------------------------------------------------------------*/
+        if(f->af[IX(i,j,k)]!=0) {
+          if(k<f->kmax && IS_FLUID(f->flag[IX(i,j,k+1)], MASK_P)) {
+            if(k/f->ck+1 != K) c->af[IXC(I,J,K)] += sz*f->af[IX(i,j,k)];
+          }
+          else {
+            c->ap[IXC(I,J,K)] += sz*f->af[IX(i,j,k)];
+            singular = 0;
+          }
+        }
+        if(f->ab[IX(i,j,k)]!=0) {
+          if(k>1 && IS_FLUID(f->flag[IX(i,j,k-1)], MASK_P)) {
+            if((k-2)/f->ck+1 != K) c->ab[IXC(I,J,K)] += sz*f->ab[IX(i,j,k)];
+          }
+          else {
+            c->ap[IXC(I,J,K)] += sz*f->ab[IX(i,j,k)];
+            singular = 0;
+          }
+        }
+      }
+
+  /****************************************************************************
+  | Add the connections to the neighbors to ap and count the fluid cells
+  ****************************************************************************/
+  c->nb_active = 0;
+  for(K=1; K<=c->kmax; K++)
+    for(J=1; J<=c->jmax; J++)
+      for(I=1; I<=c->imax; I++) {
+        if(!IS_FLUID(c->flag[IXC(I,J,K)], MASK_P)) continue;
+
+        c->ap[IXC(I,J,K)] += c->ae[IXC(I,J,K)] + c->aw[IXC(I,J,K)]
+                           + c->an[IXC(I,J,K)] + c->as[IXC(I,J,K)]
+                           + c->af[IXC(I,J,K)] + c->ab[IXC(I,J,K)];
+        // An isolated fluid region merged into one cell is not solved
+        if(c->ap[IXC(I,J,K)]==0)
+          c->flag[IXC(I,J,K)] = CELL_CODE(SOLID, MASK_P);
+        else
+          c->nb_active++;
+      }
+
+  return singular;
+} // End of mg_coarsen()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Symmetric Gauss-Seidel smoother
+///
+///\param lev Pointer to the grid level
+///\param nsweep Number of forward and backward sweeps
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void mg_relax(MG_LEVEL *lev, int nsweep) {
+  int i, j, k, n;
+  int IMAX = lev->imax+2, IJMAX = (lev->imax+2)*(lev->jmax+2);
+  REAL *ap = lev->ap, *ae = lev->ae, *aw = lev->aw, *an = lev->an;
+  REAL *as = lev->as, *af = lev->af, *ab = lev->ab, *b = lev->b;
+  REAL *x = lev->x;
+  CELL_MASK *flag = lev->flag;
+
+  for(n=0; n<nsweep; n++) {
+    for(k=1; k<=lev->kmax; k++)
+      for(j=1; j<=lev->jmax; j++)
+        for(i=1; i<=lev->imax; i++) {
+          if(!IS_FLUID(flag[IX(i,j,k)], MASK_P)) continue;
+
+          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)]
+                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
+                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
+                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
+                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+        }
+
+    for(k=lev->kmax; k>=1; k--)
+      for(j=lev->jmax; j>=1; j--)
+        for(i=lev->imax; i>=1; i--) {
+          if(!IS_FLUID(flag[IX(i,j,k)], MASK_P)) continue;
+
+          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)]
+                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
+                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
+                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
+                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+        }
+  }
+} // End of mg_relax()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the residual r = b - A*x
+///
+/// If the equations contain no fixed value, the solution is only determined
+/// up to a constant and the mean of the residual is excluded from the norm.
+///
+///\param lev Pointer to the grid level
+///
+///\return L2 norm of the residual
+///////////////////////////////////////////////////////////////////////////////
+static double mg_residual(MG_LEVEL *lev) {
+  int i, j, k;
+  int IMAX = lev->imax+2, IJMAX = (lev->imax+2)*(lev->jmax+2);
+  REAL *ap = lev->ap, *ae = lev->ae, *aw = lev->aw, *an = lev->an;
+  REAL *as = lev->as, *af = lev->af, *ab = lev->ab, *b = lev->b;
+  REAL *x = lev->x, *r = lev->r;
+  CELL_MASK *flag = lev->flag;
+  double sum = 0, sum2 = 0;
+
+  for(k=1; k<=lev->kmax; k++)
+    for(j=1; j<=lev->jmax; j++)
+      for(i=1; i<=lev->imax; i++) {
+        if(!IS_FLUID(flag[IX(i,j,k)], MASK_P)) {
+          r[IX(i,j,k)] = 0;
+          continue;
+        }
+
+        r[IX(i,j,k)] = b[IX(i,j,k)] - ap[IX(i,j,k)]*x[IX(i,j,k)]
+                     + ae[IX(i,j,k)]*x[IX(i+1,j,k)]
+                     + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+                     + an[IX(i,j,k)]*x[IX(i,j+1,k)]
+                     + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+                     + af[IX(i,j,k)]*x[IX(i,j,k+1)]
+                     + ab[IX(i,j,k)]*x[IX(i,j,k-1)];
+        sum += r[IX(i,j,k)];
+        sum2 += r[IX(i,j,k)] * r[IX(i,j,k)];
+      }
+
+  if(mg_singular && lev->nb_active>0)
+    sum2 -= sum * sum / lev->nb_active;
+
+  return sqrt(sum2>0 ? sum2 : 0);
+} // End of mg_residual()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Remove the mean value of a vector in the fluid cells of a grid level
+///
+/// The pressure equation without fixed value is singular and only has a
+/// solution if the sum of its right hand side is 0.
+///
+///\param lev Pointer to the grid level
+///\param psi Pointer to the vector
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void mg_remove_mean(MG_LEVEL *lev, REAL *psi) {
+  int i, j, k;
+  int IMAX = lev->imax+2, IJMAX = (lev->imax+2)*(lev->jmax+2);
+  CELL_MASK *flag = lev->flag;
+  double sum = 0;
+
+  if(lev->nb_active<=0) return;
+
+  for(k=1; k<=lev->kmax; k++)
+    for(j=1; j<=lev->jmax; j++)
+      for(i=1; i<=lev->imax; i++)
+        if(IS_FLUID(flag[IX(i,j,k)], MASK_P)) sum += psi[IX(i,j,k)];
+  sum /= lev->nb_active;
+
+  for(k=1; k<=lev->kmax; k++)
+    for(j=1; j<=lev->jmax; j++)
+      for(i=1; i<=lev->imax; i++)
+        if(IS_FLUID(flag[IX(i,j,k)], MASK_P)) psi[IX(i,j,k)] -= (REAL) sum;
+} // End of mg_remove_mean()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Multigrid cycle starting from a grid level
+///
+///\param n Index of the grid level
+///\param gamma Number of coarse grid corrections: 1 for V-cycle, 2 for W-cycle
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void mg_cycle(int n, int gamma) {
+  int i, j, k, I, J, K, g;
+  MG_LEVEL *f = &mg[n], *c;
+  int IMAX = f->imax+2, IJMAX = (f->imax+2)*(f->jmax+2);
+  int CIMAX, CIJMAX, size;
+
+  /****************************************************************************
+  | Solve the coarsest level by sweeps
+  ****************************************************************************/
+  if(n==mg_nlev-1) {
+    mg_relax(f, MG_COARSE_SWEEP);
+    return;
+  }
+
+  c = &mg[n+1];
+  CIMAX = c->imax+2;
+  CIJMAX = (c->imax+2)*(c->jmax+2);
+  size = (c->imax+2) * (c->jmax+2) * (c->kmax+2);
+
+  /****************************************************************************
+  | Pre-smoothing and restriction of residual
+  ****************************************************************************/
+  mg_relax(f, MG_NU1);
+  mg_residual(f);
+
+  for(i=0; i<size; i++) {
+    c->b[i] = 0;
+    c->x[i] = 0;
+  }
+
+  for(k=1; k<=f->kmax; k++)
+    for(j=1; j<=f->jmax; j++)
+      for(i=1; i<=f->imax; i++) {
+        if(!IS_FLUID(f->flag[IX(i,j,k)], MASK_P)) continue;
+        I = (i-1)/f->ci + 1;
+        J = (j-1)/f->cj + 1;
+        K = (k-1)/f->ck + 1;
+        c->b[IXC(I,J,K)] += f->r[IX(i,j,k)];
+      }
+  if(mg_singular) mg_remove_mean(c, c->b);
+
+  /****************************************************************************
+  | Coarse grid correction
+  ****************************************************************************/
+  for(g=0; g<gamma; g++)
+    mg_cycle(n+1, gamma);
+
+  for(k=1; k<=f->kmax; k++)
+    for(j=1; j<=f->jmax; j++)
+      for(i=1; i<=f->imax; i++) {
+        if(!IS_FLUID(f->flag[IX(i,j,k)], MASK_P)) continue;
+        I = (i-1)/f->ci + 1;
+        J = (j-1)/f->cj + 1;
+        K = (k-1)/f->ck + 1;
+        f->x[IX(i,j,k)] += c->x[IXC(I,J,K)];
+      }
+
+  /****************************************************************************
+  | Post-smoothing
+  ****************************************************************************/
+  mg_relax(f, MG_NU2);
+} // End of mg_cycle()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Multigrid solver for pressure
+///
+/// The cycles are repeated until the L2 norm of the residual relative to the
+/// L2 norm of the right hand side is below para->solv->p_tol (MG_TOL if 0)
+/// or the number of cycles reaches para->solv->p_max_iter (MG_MAX_CYCLE if
+/// 0). If no pressure is fixed, the equation is singular and the mean of the
+/// right hand side in var[B] and of the restricted residual of every level
+/// is removed, as PCG_P() does for its residual.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL MG_P(PARA_DATA *para, REAL **var, REAL *x) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, n, it;
+  int gamma = para->solv->mg_cycle==WCYCLE ? 2 : 1;
+  int max_iter = para->solv->p_max_iter>0 ? para->solv->p_max_iter
+                                          : MG_MAX_CYCLE;
+  double tol = para->solv->p_tol>0 ? para->solv->p_tol : MG_TOL;
+  REAL *b = var[B];
+  CELL_MASK *mask;
+  double norm_b = 0, sum = 0, residual;
+
+  if(mg_build_hierarchy(para, var, x)!=0) {
+    ffd_log("MG_P(): Could not build the grid hierarchy, "
+            "use Gauss-Seidel solver instead.", FFD_WARNING);
+    return GS_P(para, var, x);
+  }
+  mask = mg[0].flag;
+
+  /****************************************************************************
+  | Assemble the coarse equations
+  ****************************************************************************/
+  mg[0].nb_active = 0;
+  FOR_EACH_CELL
+    if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+    mg[0].nb_active++;
+    sum += b[IX(i,j,k)];
+    norm_b += b[IX(i,j,k)] * b[IX(i,j,k)];
+  END_FOR
+
+  for(n=1; n<mg_nlev; n++) {
+    if(n==1)
+      mg_singular = mg_coarsen(&mg[0], &mg[1]);
+    else
+      mg_coarsen(&mg[n-1], &mg[n]);
+  }
+
+  /****************************************************************************
+  | Solve until the residual is small enough
+  ****************************************************************************/
+  // The singular equation is solved for the right hand side without its mean
+  if(mg_singular && mg[0].nb_active>0) {
+    norm_b -= sum * sum / mg[0].nb_active;
+    mg_remove_mean(&mg[0], b);
+  }
+  norm_b = sqrt(norm_b>0 ? norm_b : 0);
+
+  para->solv->iter = 0;
+  para->solv->residual = 0;
+  if(norm_b<SMALL) return 0;
+
+  residual = mg_residual(&mg[0]) / norm_b;
+  for(it=0; it<max_iter && residual>tol; it++) {
+    mg_cycle(0, gamma);
+    residual = mg_residual(&mg[0]) / norm_b;
+  }
+
+  para->solv->iter = it;
+  para->solv->residual = (REAL) residual;
+
+  if(para->solv->check_residual==1) {
+    sprintf(msg, "MG_P(): Residual is %e after %d cycles.", residual, it);
+    ffd_log(msg, FFD_NORMAL);
+  }
+
+  return (REAL) residual;
+} // End of MG_P()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the multigrid solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_mg_data() {
+  int n;
+
+  if(mg_nlev>0 && mg[0].r!=NULL) free(mg[0].r);
+  mg[0].r = NULL;
+
+  for(n=1; n<mg_nlev; n++) {
+    free(mg[n].ap);
+    free(mg[n].ae);
+    free(mg[n].aw);
+    free(mg[n].an);
+    free(mg[n].as);
+    free(mg[n].af);
+    free(mg[n].ab);
+    free(mg[n].b);
+    free(mg[n].x);
+    free(mg[n].r);
+    free(mg[n].flag);
+  }
+
+  mg_nlev = 0;
+} // End of free_mg_data()
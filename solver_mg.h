@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_mg.h
+///
+/// \brief  Geometric multigrid solver for pressure
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/16/2026
+///
+/// The pressure equation is solved on a hierarchy of grids. Each coarse cell
+/// merges up to 2x2x2 fine cells and a direction is only coarsened while it
+/// has more than two cells. The coarse equations are obtained by summing the
+/// fine equations of the merged cells, where only fluid pressure cells are
+/// merged. The coefficients in a coarsened direction are scaled by 0.5 since
+/// the distance between the coarse cell centers is doubled. Cells in solid,
+/// inlet and outlet are therefore excluded on every grid level.
+///
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _SOLVER_MG_H
+#define _SOLVER_MG_H
+#endif
+
+#ifndef _DATA_STRUCTURE_H
+#define _DATA_STRUCTURE_H
+#include "data_structure.h"
+#endif
+
+#ifndef _SOLVER_GS_H
+#define _SOLVER_GS_H
+#include "solver_gs.h"
+#endif
+
+#ifndef _UTILITY_H
+#define _UTILITY_H
+#include "utility.h"
+#endif
+
+#define MG_MAX_LEVEL 16 // Maximum number of grid levels
+#define MG_NU1 1 // Number of pre-smoothing sweeps
+#define MG_NU2 1 // Number of post-smoothing sweeps
+#define MG_COARSE_SWEEP 20 // Number of sweeps on the coarsest grid
+#define MG_MAX_CYCLE 20 // Default maximum number of cycles
+#define MG_TOL 1e-4 // Default tolerance of the relative residual
+
+// Data of one grid level in the multigrid solver
+typedef struct {
+  int imax, jmax, kmax; // Number of interior cells
+  int ci, cj, ck; // Coarsening ratio to the next level: 1 or 2
+  int nb_active; // Number of fluid cells
+  REAL *ap, *ae, *aw, *an, *as, *af, *ab; // Coefficients
+  REAL *b; // Right hand side
+  REAL *x; // Solution (correction on coarse levels)
+  REAL *r; // Residual
+  CELL_MASK *flag; // Cell types, only the bits of MASK_P are used
+}MG_LEVEL;
+
+///////////////////////////////////////////////////////////////////////////////
+/// Multigrid solver for pressure
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL MG_P(PARA_DATA *para, REAL **var, REAL *x);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the multigrid solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_mg_data();
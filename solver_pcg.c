@@ -0,0 +1,401 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_pcg.c
+///
+/// \brief  Preconditioned conjugate gradient solver for pressure
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/16/2026
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "solver_pcg.h"
+
+static REAL *pcg_r = NULL; // Residual
+static REAL *pcg_z = NULL; // Preconditioned residual
+static REAL *pcg_d = NULL; // Search direction
+static REAL *pcg_q = NULL; // Product of matrix and search direction
+static REAL *pcg_diag = NULL; // Diagonal of the preconditioner
+static int pcg_size = 0;
+static REAL *pcg_hist = NULL; // Residual history
+static int pcg_hist_size = 0;
+static int pcg_nb_iter = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the work arrays
+///
+///\param para Pointer to FFD parameters
+///\param max_iter Maximum number of iterations
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int pcg_allocate(PARA_DATA *para, int max_iter) {
+  int size = (para->geom->imax+2) * (para->geom->jmax+2)
+           * (para->geom->kmax+2);
+
+  if(pcg_size!=size) {
+    free_pcg_data();
+    pcg_r = (REAL *) calloc(size, sizeof(REAL));
+    pcg_z = (REAL *) calloc(size, sizeof(REAL));
+    pcg_d = (REAL *) calloc(size, sizeof(REAL));
+    pcg_q = (REAL *) calloc(size, sizeof(REAL));
+    pcg_diag = (REAL *) calloc(size, sizeof(REAL));
+    pcg_size = size;
+    if(!pcg_r || !pcg_z || !pcg_d || !pcg_q || !pcg_diag) {
+      free_pcg_data();
+      return 1;
+    }
+  }
+
+  if(pcg_hist_size<max_iter+1) {
+    if(pcg_hist!=NULL) free(pcg_hist);
+    pcg_hist_size = max_iter+1;
+    pcg_hist = (REAL *) calloc(pcg_hist_size, sizeof(REAL));
+    if(pcg_hist==NULL) {
+      pcg_hist_size = 0;
+      return 1;
+    }
+  }
+
+  return 0;
+} // End of pcg_allocate()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the diagonal of the preconditioner
+///
+/// For IC, the diagonal of the incomplete Cholesky factor without fill-in is
+/// calculated. For SSOR, the diagonal is ap/omega.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void pcg_set_preconditioner(PARA_DATA *para, REAL **var) {
+  REAL *aw = var[AW], *as = var[AS], *ab = var[AB], *ap = var[AP];
+  REAL *d = pcg_diag;
+  CELL_MASK *mask = para->geom->mask;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+  REAL tmp;
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+
+        if(para->solv->pcg_precond==SSOR) {
+          d[IX(i,j,k)] = ap[IX(i,j,k)] / (REAL) PCG_SSOR_OMEGA;
+          continue;
+        }
+
+        tmp = ap[IX(i,j,k)];
+        if(i>1 && IS_FLUID(mask[IX(i-1,j,k)], MASK_P))
+          tmp -= aw[IX(i,j,k)]*aw[IX(i,j,k)] / d[IX(i-1,j,k)];
+        if(j>1 && IS_FLUID(mask[IX(i,j-1,k)], MASK_P))
+          tmp -= as[IX(i,j,k)]*as[IX(i,j,k)] / d[IX(i,j-1,k)];
+        if(k>1 && IS_FLUID(mask[IX(i,j,k-1)], MASK_P))
+          tmp -= ab[IX(i,j,k)]*ab[IX(i,j,k)] / d[IX(i,j,k-1)];
+
+        // Avoid a vanishing pivot of the singular pressure equation
+        d[IX(i,j,k)] = tmp>(REAL)1e-3*ap[IX(i,j,k)] ? tmp : ap[IX(i,j,k)];
+      }
+} // End of pcg_set_preconditioner()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Apply the preconditioner z = M^-1 r
+///
+/// M = (D+L) D^-1 (D+U), where L and U are the lower and upper parts of the
+/// matrix and D is the diagonal calculated in pcg_set_preconditioner().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param r Pointer to residual
+///\param z Pointer to the preconditioned residual
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void pcg_precondition(PARA_DATA *para, REAL **var, REAL *r, REAL *z) {
+  REAL *ae = var[AE], *aw = var[AW], *an = var[AN], *as = var[AS];
+  REAL *af = var[AF], *ab = var[AB];
+  REAL *d = pcg_diag;
+  CELL_MASK *mask = para->geom->mask;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+  REAL tmp;
+
+  /****************************************************************************
+  | Forward substitution (D+L) z = r
+  ****************************************************************************/
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+
+        tmp = r[IX(i,j,k)];
+        if(i>1 && IS_FLUID(mask[IX(i-1,j,k)], MASK_P)) tmp += aw[IX(i,j,k)]*z[IX(i-1,j,k)];
+        if(j>1 && IS_FLUID(mask[IX(i,j-1,k)], MASK_P)) tmp += as[IX(i,j,k)]*z[IX(i,j-1,k)];
+        if(k>1 && IS_FLUID(mask[IX(i,j,k-1)], MASK_P)) tmp += ab[IX(i,j,k)]*z[IX(i,j,k-1)];
+        z[IX(i,j,k)] = tmp / d[IX(i,j,k)];
+      }
+
+  /****************************************************************************
+  | Backward substitution (D+U) z = D z
+  ****************************************************************************/
+  for(k=kmax; k>=1; k--)
+    for(j=jmax; j>=1; j--)
+      for(i=imax; i>=1; i--) {
+        if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+
+        tmp = 0;
+        if(i<imax && IS_FLUID(mask[IX(i+1,j,k)], MASK_P)) tmp += ae[IX(i,j,k)]*z[IX(i+1,j,k)];
+        if(j<jmax && IS_FLUID(mask[IX(i,j+1,k)], MASK_P)) tmp += an[IX(i,j,k)]*z[IX(i,j+1,k)];
+        if(k<kmax && IS_FLUID(mask[IX(i,j,k+1)], MASK_P)) tmp += af[IX(i,j,k)]*z[IX(i,j,k+1)];
+        z[IX(i,j,k)] += tmp / d[IX(i,j,k)];
+      }
+} // End of pcg_precondition()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Remove the mean value of a vector in the fluid cells
+///
+///\param para Pointer to FFD parameters
+///\param psi Pointer to the vector
+///\param nb_active Number of fluid cells
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void pcg_remove_mean(PARA_DATA *para, REAL *psi, int nb_active) {
+  CELL_MASK *mask = para->geom->mask;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+  double sum = 0;
+
+  FOR_EACH_CELL
+    if(IS_FLUID(mask[IX(i,j,k)], MASK_P)) sum += psi[IX(i,j,k)];
+  END_FOR
+
+  sum /= nb_active;
+
+  FOR_EACH_CELL
+    if(IS_FLUID(mask[IX(i,j,k)], MASK_P)) psi[IX(i,j,k)] -= (REAL) sum;
+  END_FOR
+} // End of pcg_remove_mean()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Preconditioned conjugate gradient solver for pressure
+///
+/// The iteration stops when the L2 norm of the residual relative to the L2
+/// norm of the right hand side is below para->solv->p_tol (PCG_TOL if 0) or
+/// the number of iterations reaches para->solv->p_max_iter (PCG_MAX_ITER if
+/// 0). If no cell value is fixed, the pressure is only determined up to a
+/// constant and the mean is removed from the residual.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL PCG_P(PARA_DATA *para, REAL **var, REAL *x) {
+  REAL *ae = var[AE], *aw = var[AW], *an = var[AN], *as = var[AS];
+  REAL *af = var[AF], *ab = var[AB], *ap = var[AP], *b = var[B];
+  CELL_MASK *mask = cell_mask(para);
+  REAL *r, *z, *d, *q;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, jj, k, it, nb_active = 0, singular = 1;
+  int max_iter = para->solv->p_max_iter>0 ? para->solv->p_max_iter
+                                          : PCG_MAX_ITER;
+  double tol = para->solv->p_tol>0 ? para->solv->p_tol : PCG_TOL;
+  double norm_b = 0, sum_b = 0, rz, rz_old, dq, alpha, residual;
+  REAL tmp;
+
+  if(mask==NULL || pcg_allocate(para, max_iter)!=0) {
+    ffd_log("PCG_P(): Could not allocate memory, "
+            "use Gauss-Seidel solver instead.", FFD_WARNING);
+    return GS_P(para, var, x);
+  }
+  r = pcg_r;
+  z = pcg_z;
+  d = pcg_d;
+  q = pcg_q;
+
+  /****************************************************************************
+  | Initial residual r = b - A*x
+  ****************************************************************************/
+  FOR_EACH_CELL_TILED
+    if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+
+    nb_active++;
+    sum_b += b[IX(i,j,k)];
+    norm_b += b[IX(i,j,k)] * b[IX(i,j,k)];
+
+    r[IX(i,j,k)] = b[IX(i,j,k)] - ap[IX(i,j,k)]*x[IX(i,j,k)]
+                 + ae[IX(i,j,k)]*x[IX(i+1,j,k)] + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+                 + an[IX(i,j,k)]*x[IX(i,j+1,k)] + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+                 + af[IX(i,j,k)]*x[IX(i,j,k+1)] + ab[IX(i,j,k)]*x[IX(i,j,k-1)];
+    d[IX(i,j,k)] = 0;
+
+    // The equations contain fixed values if a coefficient links to a cell
+    // that is not solved or if ap is larger than the sum of the coefficients
+    tmp = ap[IX(i,j,k)] - ae[IX(i,j,k)] - aw[IX(i,j,k)] - an[IX(i,j,k)]
+        - as[IX(i,j,k)] - af[IX(i,j,k)] - ab[IX(i,j,k)];
+    if(fabs(tmp)>1e-5*ap[IX(i,j,k)]
+       || (ae[IX(i,j,k)]!=0 && (i==imax || !IS_FLUID(mask[IX(i+1,j,k)], MASK_P)))
+       || (aw[IX(i,j,k)]!=0 && (i==1 || !IS_FLUID(mask[IX(i-1,j,k)], MASK_P)))
+       || (an[IX(i,j,k)]!=0 && (j==jmax || !IS_FLUID(mask[IX(i,j+1,k)], MASK_P)))
+       || (as[IX(i,j,k)]!=0 && (j==1 || !IS_FLUID(mask[IX(i,j-1,k)], MASK_P)))
+       || (af[IX(i,j,k)]!=0 && (k==kmax || !IS_FLUID(mask[IX(i,j,k+1)], MASK_P)))
+       || (ab[IX(i,j,k)]!=0 && (k==1 || !IS_FLUID(mask[IX(i,j,k-1)], MASK_P))))
+      singular = 0;
+  END_FOR_TILED
+
+  pcg_nb_iter = 0;
+  para->solv->iter = 0;
+  para->solv->residual = 0;
+  if(nb_active==0) return 0;
+
+  if(singular) {
+    norm_b -= sum_b * sum_b / nb_active;
+    pcg_remove_mean(para, r, nb_active);
+  }
+  norm_b = sqrt(norm_b>0 ? norm_b : 0);
+  if(norm_b<SMALL) return 0;
+
+  residual = 0;
+  FOR_EACH_CELL
+    if(IS_FLUID(mask[IX(i,j,k)], MASK_P)) residual += r[IX(i,j,k)] * r[IX(i,j,k)];
+  END_FOR
+  residual = sqrt(residual) / norm_b;
+  pcg_hist[0] = (REAL) residual;
+  para->solv->residual = (REAL) residual;
+
+  if(residual<=tol) return (REAL) residual;
+
+  /****************************************************************************
+  | Conjugate gradient iterations
+  ****************************************************************************/
+  pcg_set_preconditioner(para, var);
+  pcg_precondition(para, var, r, z);
+  if(singular) pcg_remove_mean(para, z, nb_active);
+
+  rz = 0;
+  FOR_EACH_CELL
+    if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+    d[IX(i,j,k)] = z[IX(i,j,k)];
+    rz += r[IX(i,j,k)] * z[IX(i,j,k)];
+  END_FOR
+
+  for(it=1; it<=max_iter; it++) {
+    // q = A*d, the search direction is zero in the cells not solved
+    dq = 0;
+    FOR_EACH_CELL_TILED
+      if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+      q[IX(i,j,k)] = ap[IX(i,j,k)]*d[IX(i,j,k)]
+                   - ae[IX(i,j,k)]*d[IX(i+1,j,k)] - aw[IX(i,j,k)]*d[IX(i-1,j,k)]
+                   - an[IX(i,j,k)]*d[IX(i,j+1,k)] - as[IX(i,j,k)]*d[IX(i,j-1,k)]
+                   - af[IX(i,j,k)]*d[IX(i,j,k+1)] - ab[IX(i,j,k)]*d[IX(i,j,k-1)];
+      dq += d[IX(i,j,k)] * q[IX(i,j,k)];
+    END_FOR_TILED
+
+    if(dq<=0) break;
+    alpha = rz / dq;
+
+    residual = 0;
+    FOR_EACH_CELL
+      if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+      x[IX(i,j,k)] += (REAL) alpha * d[IX(i,j,k)];
+      r[IX(i,j,k)] -= (REAL) alpha * q[IX(i,j,k)];
+      residual += r[IX(i,j,k)] * r[IX(i,j,k)];
+    END_FOR
+
+    if(singular) {
+      pcg_remove_mean(para, r, nb_active);
+      residual = 0;
+      FOR_EACH_CELL
+        if(IS_FLUID(mask[IX(i,j,k)], MASK_P)) residual += r[IX(i,j,k)] * r[IX(i,j,k)];
+      END_FOR
+    }
+
+    residual = sqrt(residual) / norm_b;
+    pcg_hist[it] = (REAL) residual;
+    pcg_nb_iter = it;
+    if(residual<=tol) break;
+
+    pcg_precondition(para, var, r, z);
+    if(singular) pcg_remove_mean(para, z, nb_active);
+
+    rz_old = rz;
+    rz = 0;
+    FOR_EACH_CELL
+      if(IS_FLUID(mask[IX(i,j,k)], MASK_P)) rz += r[IX(i,j,k)] * z[IX(i,j,k)];
+    END_FOR
+
+    FOR_EACH_CELL
+      if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+      d[IX(i,j,k)] = z[IX(i,j,k)] + (REAL) (rz/rz_old) * d[IX(i,j,k)];
+    END_FOR
+  }
+
+  para->solv->iter = pcg_nb_iter;
+  para->solv->residual = (REAL) residual;
+
+  /****************************************************************************
+  | Report the residual history
+  ****************************************************************************/
+  if(para->solv->check_residual==1) {
+    sprintf(msg, "PCG_P(): Residual is %e after %d iterations.",
+            residual, pcg_nb_iter);
+    ffd_log(msg, FFD_NORMAL);
+    for(it=0; it<=pcg_nb_iter; it++) {
+      sprintf(msg, "\tIteration %d: %e", it, pcg_hist[it]);
+      ffd_log(msg, FFD_NORMAL);
+    }
+  }
+
+  return (REAL) residual;
+} // End of PCG_P()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the residual history of the last call of PCG_P()
+///
+///\param nb_iter Pointer to the number of iterations
+///
+///\return Pointer to the relative residuals before each iteration
+///////////////////////////////////////////////////////////////////////////////
+REAL *PCG_history(int *nb_iter) {
+  *nb_iter = pcg_nb_iter;
+  return pcg_hist;
+} // End of PCG_history()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the preconditioned conjugate gradient solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_pcg_data() {
+  if(pcg_r!=NULL) free(pcg_r);
+  if(pcg_z!=NULL) free(pcg_z);
+  if(pcg_d!=NULL) free(pcg_d);
+  if(pcg_q!=NULL) free(pcg_q);
+  if(pcg_diag!=NULL) free(pcg_diag);
+  if(pcg_hist!=NULL) free(pcg_hist);
+
+  pcg_r = NULL;
+  pcg_z = NULL;
+  pcg_d = NULL;
+  pcg_q = NULL;
+  pcg_diag = NULL;
+  pcg_hist = NULL;
+  pcg_size = 0;
+  pcg_hist_size = 0;
+} // End of free_pcg_data()
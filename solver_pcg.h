@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_pcg.h
+///
+/// \brief  Preconditioned conjugate gradient solver for pressure
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/16/2026
+///
+/// The solver works on the coefficients AP, AE, AW, AN, AS, AF, AB and B
+/// assembled in project(). Only the fluid pressure cells are unknowns and
+/// the values in the other cells are kept fixed. The preconditioner is
+/// either the incomplete Cholesky factorization without fill-in (IC) or the
+/// symmetric successive over-relaxation (SSOR).
+///
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _SOLVER_PCG_H
+#define _SOLVER_PCG_H
+#endif
+
+#ifndef _DATA_STRUCTURE_H
+#define _DATA_STRUCTURE_H
+#include "data_structure.h"
+#endif
+
+#ifndef _SOLVER_GS_H
+#define _SOLVER_GS_H
+#include "solver_gs.h"
+#endif
+
+#ifndef _UTILITY_H
+#define _UTILITY_H
+#include "utility.h"
+#endif
+
+#define PCG_SSOR_OMEGA 1.2 // Relaxation factor of SSOR preconditioner
+#define PCG_MAX_ITER 200 // Default maximum number of iterations
+#define PCG_TOL 1e-4 // Default tolerance of the relative residual
+
+///////////////////////////////////////////////////////////////////////////////
+/// Preconditioned conjugate gradient solver for pressure
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL PCG_P(PARA_DATA *para, REAL **var, REAL *x);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the residual history of the last call of PCG_P()
+///
+///\param nb_iter Pointer to the number of iterations
+///
+///\return Pointer to the relative residuals before each iteration
+///////////////////////////////////////////////////////////////////////////////
+REAL *PCG_history(int *nb_iter);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the preconditioned conjugate gradient solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_pcg_data();
@@ -17,343 +17,466 @@
 
 #include "solver_tdma.h"
 
+static TDMA_WORK *tdma_work = NULL;
+static int tdma_nb_work = 0;
+static double *tdma_sum = NULL; // Residual sums of each plane
+
 ///////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for 3D
+/// Allocate the workspaces of TDMA solver
+///
+/// One workspace is allocated for each thread. The workspaces are kept until
+/// free_tdma_data() is called.
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param type Type of variable
-///\param psi Pointer to variable
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_3D(PARA_DATA *para, REAL **var, int type, REAL *psi) {
-  int imax = para->geom->imax;
-  int jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int i, j, k;
+int TDMA_allocate(PARA_DATA *para) {
+  int n, size;
+  int len = max(para->geom->imax, max(para->geom->jmax, para->geom->kmax)) + 2;
+  int nb_work = 1;
 
-  //West to East
-  for(i=1; i<=imax; i++) {
-    if(TDMA_YZ(para, var, psi, i)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_YZ.", FFD_ERROR);
-      return 1;
-    }     
+#ifdef _OPENMP
+  nb_work = omp_get_max_threads();
+#endif
+
+  if(tdma_work!=NULL && tdma_nb_work>=nb_work && tdma_work[0].len>=len)
+    return 0;
+
+  free_tdma_data();
+
+  tdma_work = (TDMA_WORK *) calloc(nb_work, sizeof(TDMA_WORK));
+  if(tdma_work==NULL) {
+    ffd_log("TDMA_allocate(): Could not allocate memory for workspaces.",
+            FFD_ERROR);
+    return 1;
   }
-  //South to North
-  for(j=1; j<=jmax; j++) {
-    if(TDMA_ZX(para, var, psi, j)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_ZX.", FFD_ERROR);
-      return 1;
-    } 
+  tdma_nb_work = nb_work;
+
+  tdma_sum = (double *) malloc(2*len*sizeof(double));
+  if(tdma_sum==NULL) {
+    ffd_log("TDMA_allocate(): Could not allocate memory for workspaces.",
+            FFD_ERROR);
+    free_tdma_data();
+    return 1;
   }
-  //Back to Front
-  for(k=1; k<=kmax; k++) {
-    if(TDMA_XY(para, var, psi, k)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_XY.", FFD_ERROR);
+
+  size = len * TDMA_LANES;
+  for(n=0; n<nb_work; n++) {
+    tdma_work[n].len = len;
+    tdma_work[n].ap = (REAL *) malloc(7*size*sizeof(REAL));
+    if(tdma_work[n].ap==NULL) {
+      ffd_log("TDMA_allocate(): Could not allocate memory for workspaces.",
+              FFD_ERROR);
+      free_tdma_data();
       return 1;
-    }     
+    }
+    tdma_work[n].ae = tdma_work[n].ap + size;
+    tdma_work[n].aw = tdma_work[n].ae + size;
+    tdma_work[n].b = tdma_work[n].aw + size;
+    tdma_work[n].psi = tdma_work[n].b + size;
+    tdma_work[n].P = tdma_work[n].psi + size;
+    tdma_work[n].Q = tdma_work[n].P + size;
   }
-  //East to West
-  for(i=imax; i>=1; i--) {
-    if(TDMA_YZ(para, var, psi, i)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_YZ.", FFD_ERROR);
-      return 1;
-    }     
+
+  return 0;
+} // End of TDMA_allocate()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the workspaces of TDMA solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_tdma_data() {
+  int n;
+
+  if(tdma_work==NULL) return;
+
+  for(n=0; n<tdma_nb_work; n++)
+    if(tdma_work[n].ap!=NULL) free(tdma_work[n].ap);
+
+  free(tdma_work);
+  tdma_work = NULL;
+  tdma_nb_work = 0;
+
+  if(tdma_sum!=NULL) free(tdma_sum);
+  tdma_sum = NULL;
+} // End of free_tdma_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the workspace of the calling thread
+///
+///\return Pointer to the workspace
+///////////////////////////////////////////////////////////////////////////////
+static TDMA_WORK *TDMA_workspace() {
+#ifdef _OPENMP
+  return &tdma_work[omp_get_thread_num()];
+#else
+  return &tdma_work[0];
+#endif
+} // End of TDMA_workspace()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Sweep all planes normal to one direction
+///
+/// The planes are solved in a zebra order: first all planes with odd index
+/// and then all planes with even index (reversed for backward sweeps). A
+/// plane only depends on its neighboring planes, so the planes of the same
+/// parity are solved in parallel, in batches of TDMA_LANES planes. The
+/// residual sums of each plane are added in the order of the planes, which
+/// keeps the result independent of the number of threads.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param mask Pointer to the packed cell types
+///\param shift Shift of the bits of the solved location in the cell types
+///\param psi Pointer to variable
+///\param dir Normal direction of the planes: X, Y or Z
+///\param forward 1: odd planes first, 0: even planes first
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+static REAL TDMA_sweep(PARA_DATA *para, REAL **var, CELL_MASK *mask,
+                       int shift, REAL *psi, int dir, int forward) {
+  int n, p, l, nb, phase, start;
+  double sum_r = 0, sum_x = 0.0000000001;
+
+  switch(dir) {
+    case X:
+      n = para->geom->imax;
+      break;
+    case Y:
+      n = para->geom->jmax;
+      break;
+    default:
+      n = para->geom->kmax;
   }
-  //North to South
-  for(j=jmax; j>=1; j--) {
-    if(TDMA_ZX(para, var, psi, j)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_ZX.", FFD_ERROR);
-      return 1;
-    }     
+
+  for(phase=0; phase<2; phase++) {
+    start = forward ? 1+phase : 2-phase;
+
+#pragma omp parallel for private(l, nb) schedule(dynamic)
+    for(p=start; p<=n; p+=2*TDMA_LANES) {
+      nb = min(TDMA_LANES, (n-p)/2+1);
+      for(l=0; l<nb; l++) {
+        tdma_sum[2*(p+2*l)] = 0;
+        tdma_sum[2*(p+2*l)+1] = 0;
+      }
+      switch(dir) {
+        case X:
+          TDMA_YZ(para, var, mask, shift, psi, p, nb, &tdma_sum[2*p]);
+          break;
+        case Y:
+          TDMA_ZX(para, var, mask, shift, psi, p, nb, &tdma_sum[2*p]);
+          break;
+        default:
+          TDMA_XY(para, var, mask, shift, psi, p, nb, &tdma_sum[2*p]);
+      }
+    }
   }
-  //Front to Back
-  for(k=kmax; k>=1; k--) {
-    if(TDMA_XY(para, var, psi, k)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_YZ.", FFD_ERROR);
-      return 1;
-    }          
+
+  for(p=1; p<=n; p++) {
+    sum_r += tdma_sum[2*p];
+    sum_x += tdma_sum[2*p+1];
   }
+
+  return (REAL) (sum_r/sum_x);
+} // End of TDMA_sweep()
+
+///////////////////////////////////////////////////////////////////////////////
+/// TDMA solver for 3D
+///
+/// Each iteration sweeps the planes from west to east, south to north, back
+/// to front and then back in the opposite directions. The solver stops after
+/// the first sweep whose residual is below tol or after max_iter iterations.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param type Type of variable
+///\param psi Pointer to variable
+///\param tol Tolerance of the residual
+///\param max_iter Maximum number of iterations
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int TDMA_3D(PARA_DATA *para, REAL **var, int type, REAL *psi, REAL tol,
+            int max_iter) {
+  int it, n, sweep = 0;
+  int dir[6] = {X, Y, Z, X, Y, Z};
+  int shift;
+  REAL residual = 1;
+  CELL_MASK *mask = cell_mask(para);
+
+  switch(type) {
+    case VX:
+      shift = MASK_U;
+      break;
+    case VY:
+      shift = MASK_V;
+      break;
+    case VZ:
+      shift = MASK_W;
+      break;
+    default:
+      shift = MASK_P;
+  }
+
+  if(mask==NULL || TDMA_allocate(para)!=0) {
+    ffd_log("TDMA_3D: Could not allocate workspaces.", FFD_ERROR);
+    return 1;
+  }
+
+  for(it=0; it<max_iter && residual>tol; it++)
+    for(n=0; n<6 && residual>tol; n++) {
+      residual = TDMA_sweep(para, var, mask, shift, psi, dir[n], n<3);
+      sweep++;
+    }
+
+  para->solv->iter = sweep;
+  para->solv->residual = residual;
+
   return 0;
 }// end of TDMA_3D()
 
+///////////////////////////////////////////////////////////////////////////////
+/// Solve a batch of parallel lines in a plane
+///
+/// Cell m of line l has the index base + m*s_line + l*s_lane, where m=0 and
+/// m=n+1 are the cells at both ends which are kept fixed. The coefficients
+/// along the line are alo (to m-1) and ahi (to m+1), while the neighbors
+/// outside the line (c1p, c1m with stride s1 and c2p, c2m with stride s2)
+/// are moved to the right hand side. The cells which are not fluid are not
+/// solved.
+///
+/// The lines are stored interleaved in the workspace, so that the Thomas
+/// algorithm runs in lockstep for all lines and the inner loops over the
+/// lines can be vectorized by the compiler. All lines of a batch see the
+/// values of the other lines from before the batch, so the lines must not
+/// be coupled. The callers take them from planes of the same parity, which
+/// keeps the line by line Gauss-Seidel order within each plane.
+///
+///\param var Pointer to FFD simulation variables
+///\param mask Pointer to the packed cell types
+///\param shift Shift of the bits of the solved location in the cell types
+///\param psi Pointer to variable
+///\param base Index of the first cell of the first line
+///\param n Number of unknowns in each line
+///\param s_line Index stride along the lines
+///\param nb_lane Number of lines, not more than TDMA_LANES
+///\param s_lane Index stride between the lines
+///\param alo Coefficient to the previous cell in the line
+///\param ahi Coefficient to the next cell in the line
+///\param c1p Coefficient to the neighbor at +s1
+///\param c1m Coefficient to the neighbor at -s1
+///\param s1 First index stride across the lines
+///\param c2p Coefficient to the neighbor at +s2
+///\param c2m Coefficient to the neighbor at -s2
+///\param s2 Second index stride across the lines
+///\param sum Sums of |ap*(psi_new-psi_old)| and |ap*psi_new|, those of
+///           line l at sum[4*l] and sum[4*l+1]
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void TDMA_lines(REAL **var, CELL_MASK *mask, int shift, REAL *psi,
+                       int base, int n, int s_line, int nb_lane, int s_lane,
+                       REAL *alo, REAL *ahi, REAL *c1p, REAL *c1m, int s1,
+                       REAL *c2p, REAL *c2m, int s2, double *sum) {
+  TDMA_WORK *ws = TDMA_workspace();
+  REAL *ap = var[AP], *b = var[B];
+  int m, l, c, w;
+
+  /****************************************************************************
+  | Gather the coefficients of the lines
+  ****************************************************************************/
+  for(m=0; m<=n+1; m++)
+    for(l=0; l<TDMA_LANES; l++) {
+      w = m*TDMA_LANES + l;
+      c = base + m*s_line + l*s_lane;
+
+      if(l>=nb_lane) {
+        ws->ap[w] = 1;
+        ws->ae[w] = 0;
+        ws->aw[w] = 0;
+        ws->b[w] = 0;
+        ws->psi[w] = 0;
+        continue;
+      }
+
+      ws->psi[w] = psi[c];
+      if(m==0 || m==n+1) continue;
+
+      if(!IS_FLUID(mask[c], shift)) {
+        ws->ap[w] = 1;
+        ws->ae[w] = 0;
+        ws->aw[w] = 0;
+        ws->b[w] = psi[c];
+      }
+      else {
+        ws->ap[w] = ap[c];
+        ws->ae[w] = ahi[c];
+        ws->aw[w] = alo[c];
+        ws->b[w] = b[c] + c1p[c]*psi[c+s1] + c1m[c]*psi[c-s1]
+                 + c2p[c]*psi[c+s2] + c2m[c]*psi[c-s2];
+      }
+    }
+
+  TDMA_1D(ws->ap, ws->ae, ws->aw, ws->b, ws->psi, ws->P, ws->Q, n);
+
+  /****************************************************************************
+  | Scatter the solution and sum up the residual
+  ****************************************************************************/
+  for(m=1; m<=n; m++)
+    for(l=0; l<nb_lane; l++) {
+      w = m*TDMA_LANES + l;
+      c = base + m*s_line + l*s_lane;
+      if(!IS_FLUID(mask[c], shift)) continue;
+
+      sum[4*l] += fabs(ap[c]*(ws->psi[w]-psi[c]));
+      sum[4*l+1] += fabs(ap[c]*ws->psi[w]);
+      psi[c] = ws->psi[w];
+    }
+} // End of TDMA_lines()
+
 ///////////////////////////////////////////////////////////////////////////////
 /// TDMA solver for XY-plane 
 ///
+/// The planes k, k+2, ..., k+2*(nb_plane-1) are solved together. The lines
+/// in Y direction are solved from i=1 to imax, the line i of all planes in
+/// one batch.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param mask Pointer to the packed cell types
+///\param shift Shift of the bits of the solved location in the cell types
 ///\param psi Pointer to variable
-///\param k K-index of the plane
+///\param k K-index of the first plane
+///\param nb_plane Number of planes, not more than TDMA_LANES
+///\param sum Sums of |ap*(psi_new-psi_old)| and |ap*psi_new|, those of
+///           plane k+2*l at sum[4*l] and sum[4*l+1]
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_XY(PARA_DATA *para, REAL **var, REAL *psi, int k) {
+int TDMA_XY(PARA_DATA *para, REAL **var, CELL_MASK *mask, int shift,
+            REAL *psi, int k, int nb_plane, double *sum) {
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int i, j;
+  int i;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *b = var[B], *ap = var[AP], *af = var[AF], *ab = var[AB];
-  REAL *ae = var[AE], *aw =var[AW], *an = var[AN], *as = var[AS];
-  REAL *temp_ap, *temp_aw, *temp_ae, *temp_b, *temp_psi;
-  
-  temp_ap = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_ap==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_ap.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_ae = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_ae==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_ae.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_aw = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_aw==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_aw.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_b = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_b==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_b.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_psi = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_psi==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_psi.",
-            FFD_ERROR);
-    return 1;
-  }
 
-  //line-by-line from West to East
-  for(i=1; i<=imax; i++) {
-    for(j=1; j<=jmax; j++) {
-      temp_b[j] = b[IX(i,j,k)] 
-                + ae[IX(i,j,k)]*psi[IX(i+1,j,k)] + aw[IX(i,j,k)]*psi[IX(i-1,j,k)]
-                + af[IX(i,j,k)]*psi[IX(i,j,k+1)] + ab[IX(i,j,k)]*psi[IX(i,j,k-1)];
-      temp_ap[j] = ap[IX(i,j,k)];
-      temp_aw[j] = as[IX(i,j,k)];
-      temp_ae[j] = an[IX(i,j,k)];
-      temp_psi[j] = psi[IX(i,j,k)];
-    }
+  for(i=1; i<=imax; i++)
+    TDMA_lines(var, mask, shift, psi, IX(i,0,k), jmax, IMAX, nb_plane,
+               2*IJMAX, var[AS], var[AN], var[AE], var[AW], 1, var[AF],
+               var[AB], IJMAX, sum);
 
-    if(TDMA_1D(temp_ap, temp_ae, temp_aw, temp_b, temp_psi, jmax)) {
-      ffd_log("TDMA_XY(): Could not compute TDMA_1D", FFD_ERROR);
-      return 1;
-    }   
-    for(j=1; j<=jmax; j++)  
-      psi[IX(i,j,k)] = temp_psi[j];
-  }
-  
-  free(temp_ap);
-  free(temp_ae);
-  free(temp_aw);
-  free(temp_b);
-  free(temp_psi);
   return 0;
 } // End of TDMA_XY()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// TDMA solver for YZ-plane 
 ///
+/// The planes i, i+2, ..., i+2*(nb_plane-1) are solved together. The lines
+/// in Z direction are solved from j=1 to jmax, the line j of all planes in
+/// one batch.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param mask Pointer to the packed cell types
+///\param shift Shift of the bits of the solved location in the cell types
 ///\param psi Pointer to variable
-///\param i I-index of the plane
+///\param i I-index of the first plane
+///\param nb_plane Number of planes, not more than TDMA_LANES
+///\param sum Sums of |ap*(psi_new-psi_old)| and |ap*psi_new|, those of
+///           plane i+2*l at sum[4*l] and sum[4*l+1]
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_YZ(PARA_DATA *para, REAL **var, REAL *psi, int i)
-{
-  int imax = para->geom->imax;
-  int jmax = para->geom->jmax;
+int TDMA_YZ(PARA_DATA *para, REAL **var, CELL_MASK *mask, int shift,
+            REAL *psi, int i, int nb_plane, double *sum) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
-  int j, k;
+  int j;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *b = var[B], *ap = var[AP], *af = var[AF], *ab = var[AB];
-  REAL *ae = var[AE], *aw =var[AW], *an = var[AN], *as = var[AS];
-  REAL *temp_ap, *temp_aw, *temp_ae, *temp_b, *temp_psi;
-  
-  temp_ap = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_ap==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_ap.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_ae = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_ae==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_ae.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_aw = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_aw==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_aw.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_b = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_b==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_b.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_psi = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_psi==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_psi.",
-            FFD_ERROR);
-    return 1;
-  }
-  
-  //line-by-line from South to North
-  for(j=1; j<=jmax; j++) {
-    for(k=1; k<=kmax; k++) {
-      temp_b[k] = b[IX(i,j,k)] 
-                + ae[IX(i,j,k)]*psi[IX(i+1,j,k)] + aw[IX(i,j,k)]*psi[IX(i-1,j,k)]
-                + an[IX(i,j,k)]*psi[IX(i,j+1,k)] + as[IX(i,j,k)]*psi[IX(i,j-1,k)];
-      temp_ap[k] = ap[IX(i,j,k)];
-      temp_aw[k] = ab[IX(i,j,k)];
-      temp_ae[k] = af[IX(i,j,k)];
-      temp_psi[k] = psi[IX(i,j,k)];
-    }
 
-    if(TDMA_1D(temp_ap, temp_ae, temp_aw, temp_b, temp_psi, kmax)) {
-      ffd_log("TDMA_YZ(): Could not compute TDMA_1D", FFD_ERROR);
-      return 1;
-    }
-    for(k=1; k<=kmax; k++)  psi[IX(i,j,k)] = temp_psi[k];
+  for(j=1; j<=jmax; j++)
+    TDMA_lines(var, mask, shift, psi, IX(i,j,0), kmax, IJMAX, nb_plane, 2,
+               var[AB], var[AF], var[AE], var[AW], 1, var[AN], var[AS],
+               IMAX, sum);
 
-  }
-  
-  free(temp_ap);
-  free(temp_ae);
-  free(temp_aw);
-  free(temp_b);
-  free(temp_psi);
   return 0;
 } // End of TDMA_YZ()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// TDMA solver for ZX-plane 
 ///
+/// The planes j, j+2, ..., j+2*(nb_plane-1) are solved together. The lines
+/// in X direction are solved from k=1 to kmax, the line k of all planes in
+/// one batch.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param mask Pointer to the packed cell types
+///\param shift Shift of the bits of the solved location in the cell types
 ///\param psi Pointer to variable
-///\param j J-index of the plane
+///\param j J-index of the first plane
+///\param nb_plane Number of planes, not more than TDMA_LANES
+///\param sum Sums of |ap*(psi_new-psi_old)| and |ap*psi_new|, those of
+///           plane j+2*l at sum[4*l] and sum[4*l+1]
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_ZX(PARA_DATA *para, REAL **var, REAL *psi, int j)
-{
-  int imax = para->geom->imax;
-  int jmax = para->geom->jmax;
+int TDMA_ZX(PARA_DATA *para, REAL **var, CELL_MASK *mask, int shift,
+            REAL *psi, int j, int nb_plane, double *sum) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
-  int k, i;
+  int k;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *b = var[B], *ap = var[AP], *af = var[AF], *ab = var[AB];
-  REAL *ae = var[AE], *aw =var[AW], *an = var[AN], *as = var[AS];
-  REAL *temp_ap, *temp_aw, *temp_ae, *temp_b, *temp_psi;
 
-  temp_ap = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_ap==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_ap.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_ae = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_ae==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_ae.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_aw = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_aw==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_aw.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_b = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_b==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_b.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_psi = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_psi==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_psi.",
-            FFD_ERROR);
-    return 1;
-  }
-  
-  //line-by-line from South to North
-  for(k=1; k<=kmax; k++) {
-    for(i=1; i<=imax; i++) {
-      temp_b[i] = b[IX(i,j,k)] 
-               + af[IX(i,j,k)]*psi[IX(i,j,k+1)] + ab[IX(i,j,k)]*psi[IX(i,j,k-1)]
-               + an[IX(i,j,k)]*psi[IX(i,j+1,k)] + as[IX(i,j,k)]*psi[IX(i,j-1,k)];
-      temp_ap[i] = ap[IX(i,j,k)];
-      temp_aw[i] = aw[IX(i,j,k)];
-      temp_ae[i] = ae[IX(i,j,k)];
-      temp_psi[i] = psi[IX(i,j,k)];
-    }
-
-    if(TDMA_1D(temp_ap, temp_ae, temp_aw, temp_b, temp_psi, imax)) {
-      ffd_log("TDMA_ZX(): Could not compute TDMA_1D", FFD_ERROR);
-      return 1;
-    }
+  for(k=1; k<=kmax; k++)
+    TDMA_lines(var, mask, shift, psi, IX(0,j,k), imax, 1, nb_plane,
+               2*IMAX, var[AW], var[AE], var[AN], var[AS], IMAX, var[AF],
+               var[AB], IJMAX, sum);
 
-    for(i=1; i<=imax; i++)  psi[IX(i,j,k)] = temp_psi[i];
-  }
-  
-  free(temp_ap);
-  free(temp_ae);
-  free(temp_aw);
-  free(temp_b);
-  free(temp_psi);
   return 0;
 } // End of TDMA_ZX()
 
 ///////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for 1D array 
+/// TDMA solver for a batch of 1D arrays
+///
+/// TDMA_LANES arrays are stored interleaved: element m of array l is at
+/// m*TDMA_LANES+l. The elements 0 and LENGTH+1 of psi are the fixed values
+/// at both ends. All arrays are solved in lockstep.
 ///
 ///\param ap Pointer to coefficient for center 
 ///\param ae Pointer to coefficient for east
 ///\param aw Pointer to coefficient for west
 ///\param b Pointer to b
 ///\param psi Pointer to variable
-///\param LENGTH Length of the array
+///\param P Pointer to work array
+///\param Q Pointer to work array
+///\param LENGTH Number of unknowns in each array
 ///
-///\return 0 if no error occurred
+///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_1D(REAL *ap, REAL *ae, REAL *aw, REAL *b, REAL *psi, 
-             int LENGTH) {
-  REAL *P, *Q;
-  int i;
+void TDMA_1D(REAL *ap, REAL *ae, REAL *aw, REAL *b, REAL *psi, REAL *P,
+             REAL *Q, int LENGTH) {
+  int i, l, w;
+  REAL denom;
 
-  P = (REAL *)malloc(LENGTH * sizeof(REAL));
-  if(P==NULL) {
-    ffd_log("TDMA_1D(): Could not allocate memory for P.", FFD_ERROR);
-    return 1;
-  }
-  Q = (REAL *)malloc(LENGTH * sizeof(REAL));
-  if(Q==NULL) {
-    ffd_log("TDMA_1D(): Could not allocate memory for Q.", FFD_ERROR);
-    return 1;
-  }
-  for(i=1; i<=LENGTH-1; i++) {
-    P[i] = ae[i] / (ap[i] - aw[i]*P[i-1]);
-    Q[i] = (b[i] + aw[i]*Q[i-1]) / (ap[i] - aw[i]*P[i-1]);
+  for(l=0; l<TDMA_LANES; l++) {
+    P[l] = 0;
+    Q[l] = psi[l];
   }
 
-  for(i=LENGTH-1; i>=1; i--)
-    psi[i] = P[i]*psi[i+1] + Q[i];
-
-  free(P);
-  free(Q);
-  return 0;
-} /* end of TDMA_1D() */
-
+  for(i=1; i<=LENGTH; i++)
+    for(l=0; l<TDMA_LANES; l++) {
+      w = i*TDMA_LANES + l;
+      denom = ap[w] - aw[w]*P[w-TDMA_LANES];
+      P[w] = ae[w] / denom;
+      Q[w] = (b[w] + aw[w]*Q[w-TDMA_LANES]) / denom;
+    }
 
-  
\ No newline at end of file
+  for(i=LENGTH; i>=1; i--)
+    for(l=0; l<TDMA_LANES; l++) {
+      w = i*TDMA_LANES + l;
+      psi[w] = P[w]*psi[w+TDMA_LANES] + Q[w];
+    }
+} // End of TDMA_1D()
@@ -29,6 +29,38 @@
 #endif
 
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define TDMA_LANES 8 // Number of lines solved together
+#define TDMA_P_MAX_ITER 3 // Default iterations of TDMA solver for pressure
+#define TDMA_MAX_ITER 1 // Default iterations of TDMA solver for transport
+
+// Workspace of TDMA solver for one thread
+typedef struct {
+  int len; // Maximum length of lines including both ends
+  REAL *ap, *ae, *aw, *b; // Coefficients of the lines
+  REAL *psi; // Variable of the lines
+  REAL *P, *Q; // Work arrays of Thomas algorithm
+}TDMA_WORK;
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the workspaces of TDMA solver
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int TDMA_allocate(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the workspaces of TDMA solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_tdma_data();
+
 ///////////////////////////////////////////////////////////////////////////////
 /// TDMA solver for 3D
 ///
@@ -36,57 +68,81 @@
 ///\param var Pointer to FFD simulation variables
 ///\param type Type of variable
 ///\param psi Pointer to variable
+///\param tol Tolerance of the residual
+///\param max_iter Maximum number of iterations
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_3D(PARA_DATA *para, REAL **var, int type, REAL *psi);
+int TDMA_3D(PARA_DATA *para, REAL **var, int type, REAL *psi, REAL tol,
+            int max_iter);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// TDMA solver for XY-plane 
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param mask Pointer to the packed cell types
+///\param shift Shift of the bits of the solved location in the cell types
 ///\param psi Pointer to variable
-///\param k K-index of the plane
+///\param k K-index of the first plane
+///\param nb_plane Number of planes, not more than TDMA_LANES
+///\param sum Sums of |ap*(psi_new-psi_old)| and |ap*psi_new|, those of
+///           plane k+2*l at sum[4*l] and sum[4*l+1]
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_XY(PARA_DATA *para, REAL **var, REAL *psi, int k);
+int TDMA_XY(PARA_DATA *para, REAL **var, CELL_MASK *mask, int shift,
+            REAL *psi, int k, int nb_plane, double *sum);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// TDMA solver for YZ-plane 
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param mask Pointer to the packed cell types
+///\param shift Shift of the bits of the solved location in the cell types
 ///\param psi Pointer to variable
-///\param i I-index of the plane
+///\param i I-index of the first plane
+///\param nb_plane Number of planes, not more than TDMA_LANES
+///\param sum Sums of |ap*(psi_new-psi_old)| and |ap*psi_new|, those of
+///           plane i+2*l at sum[4*l] and sum[4*l+1]
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_YZ(PARA_DATA *para, REAL **var, REAL *psi, int i);
+int TDMA_YZ(PARA_DATA *para, REAL **var, CELL_MASK *mask, int shift,
+            REAL *psi, int i, int nb_plane, double *sum);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// TDMA solver for ZX-plane 
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param mask Pointer to the packed cell types
+///\param shift Shift of the bits of the solved location in the cell types
 ///\param psi Pointer to variable
-///\param j J-index of the plane
+///\param j J-index of the first plane
+///\param nb_plane Number of planes, not more than TDMA_LANES
+///\param sum Sums of |ap*(psi_new-psi_old)| and |ap*psi_new|, those of
+///           plane j+2*l at sum[4*l] and sum[4*l+1]
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_ZX(PARA_DATA *para, REAL **var, REAL *psi, int j);
+int TDMA_ZX(PARA_DATA *para, REAL **var, CELL_MASK *mask, int shift,
+            REAL *psi, int j, int nb_plane, double *sum);
 
-//////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for 1D array 
+///////////////////////////////////////////////////////////////////////////////
+/// TDMA solver for a batch of 1D arrays
 ///
 ///\param ap Pointer to coefficient for center 
 ///\param ae Pointer to coefficient for east
 ///\param aw Pointer to coefficient for west
 ///\param b Pointer to b
 ///\param psi Pointer to variable
-///\param LENGTH Length of the array
+///\param P Pointer to work array
+///\param Q Pointer to work array
+///\param LENGTH Number of unknowns in each array
 ///
-///\return 0 if no error occurred
+///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_1D(REAL *a, REAL *b, REAL *c, REAL *d, REAL *psi, int LENGTH);
\ No newline at end of file
+void TDMA_1D(REAL *ap, REAL *ae, REAL *aw, REAL *b, REAL *psi, REAL *P,
+             REAL *Q, int LENGTH);
@@ -37,4 +37,82 @@ void timing(PARA_DATA *para) {
          para->mytime->t, cputime, para->mytime->t/cputime);
   ffd_log(msg, FFD_NORMAL);
 
-} // End of timing( )
\ No newline at end of file
+} // End of timing( )
+
+///////////////////////////////////////////////////////////////////////////////
+/// Adapt the time step size to the flow
+///
+/// The time step size is the largest one for which the CFL number
+/// |u|dt/dx+|v|dt/dy+|w|dt/dz and the diffusion number
+/// kapa*dt*(1/dx^2+1/dy^2+1/dz^2) of every fluid cell do not exceed
+/// para->mytime->cfl_max and para->mytime->dif_max. It grows at most by
+/// DT_GROW per step and is limited by para->mytime->dt_min and
+/// para->mytime->dt_max. The rest of the time until t_next is then split
+/// into steps of equal size, so that a step ends exactly at t_next.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param t_next Time that must be reached by a step, e.g. the next
+///              synchronization time of the cosimulation
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_time_step(PARA_DATA *para, REAL **var, double t_next) {
+  int i, j, k;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  CELL_MASK *mask = cell_mask(para);
+  REAL *u = var[VX], *v = var[VY], *w = var[VZ], *nut = var[NUT];
+  REAL *rdx = para->geom->mesh->rdx, *rdy = para->geom->mesh->rdy;
+  REAL *rdz = para->geom->mesh->rdz;
+  REAL nu = para->prob->nu, alpha = para->prob->alpha;
+  REAL cfl_max = para->mytime->cfl_max, dif_max = para->mytime->dif_max;
+  double kapa, kapa_t = 0, cfl = 0, dif = 0, c, d, dt, rest;
+
+  if(mask==NULL) return 1;
+
+  rest = t_next - para->mytime->t;
+  if(rest<SMALL) {
+    sprintf(msg, "set_time_step(): The time t=%f[s] is not before the "
+            "time t_next=%f[s] to be reached.", para->mytime->t, t_next);
+    ffd_log(msg, FFD_ERROR);
+    return 1;
+  }
+
+  // Largest diffusivity of velocity and scalars, the turbulent viscosity
+  // of Chen's model is added for each cell
+  kapa = nu > alpha ? nu : alpha;
+  if(para->prob->tur_model==CONSTANT)
+    kapa *= 101.0;
+  else if(para->prob->tur_model==CHEN)
+    kapa_t = alpha > nu ? alpha/nu : 1;
+
+  FOR_EACH_CELL
+    if(!IS_FLUID(mask[IX(i,j,k)], MASK_P)) continue;
+
+    c = max(fabs(u[IX(i-1,j,k)]), fabs(u[IX(i,j,k)])) * rdx[i]
+      + max(fabs(v[IX(i,j-1,k)]), fabs(v[IX(i,j,k)])) * rdy[j]
+      + max(fabs(w[IX(i,j,k-1)]), fabs(w[IX(i,j,k)])) * rdz[k];
+    if(c>cfl) cfl = c;
+
+    d = rdx[i]*rdx[i] + rdy[j]*rdy[j] + rdz[k]*rdz[k];
+    if(kapa_t>0)
+      d *= kapa + kapa_t*nut[IX(i,j,k)];
+    else
+      d *= kapa;
+    if(d>dif) dif = d;
+  END_FOR
+
+  dt = para->mytime->dt * DT_GROW;
+  if(cfl_max>0 && cfl*dt>cfl_max) dt = cfl_max / cfl;
+  if(dif_max>0 && dif*dt>dif_max) dt = dif_max / dif;
+  if(para->mytime->dt_max>0 && dt>para->mytime->dt_max)
+    dt = para->mytime->dt_max;
+  if(dt<para->mytime->dt_min) dt = para->mytime->dt_min;
+
+  // Steps of equal size until t_next
+  para->mytime->dt = rest / ceil(rest/dt);
+
+  return 0;
+} // End of set_time_step()
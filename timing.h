@@ -28,6 +28,8 @@
 #include "utility.h"
 #endif
 
+#define DT_GROW 1.2 // Maximum growth of the adaptive time step size per step
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the simulation time and time ratio
 ///
@@ -35,4 +37,15 @@
 ///
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void timing(PARA_DATA *para);
\ No newline at end of file
+void timing(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Adapt the time step size to the flow
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param t_next Time that must be reached by a step
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_time_step(PARA_DATA *para, REAL **var, double t_next);
@@ -17,6 +17,13 @@
 
 #include "utility.h"
 
+static REAL *field_arena = NULL; // Memory of the variables that are not optional
+static size_t field_size = 0; // Number of cells of a variable
+static size_t field_stride = 0; // Padded length of a variable
+static int field_nb = 0; // Number of variables
+static double *mean_sum = NULL; // Sums of VX, VY, VZ and TEMP for the means
+static double *bnd_sum = NULL; // Sums of the boundary and sensor data for the means
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Check the residual of equation
 ///
@@ -29,22 +36,23 @@
 REAL check_residual(PARA_DATA *para, REAL **var, REAL *x) {
   int imax = para->geom->imax, jmax = para->geom->jmax; 
   int kmax = para->geom->kmax;
-  int i, j, k;
+  int i, j, jj, k;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
   REAL *ap = var[AP], *ab = var[AB], *af = var[AF], *b = var[B];  
-  REAL tmp, residual = 0.0; 
+  REAL tmp;
+  double residual = 0.0; 
 
-  FOR_EACH_CELL
+  FOR_EACH_CELL_TILED
     tmp = ap[IX(i,j,k)]*x[IX(i,j,k)] 
         - ae[IX(i,j,k)]*x[IX(i+1,j,k)] - aw[IX(i,j,k)]*x[IX(i-1,j,k)]
         - an[IX(i,j,k)]*x[IX(i,j+1,k)] - as[IX(i,j,k)]*x[IX(i,j-1,k)]
         - af[IX(i,j,k)]*x[IX(i,j,k+1)] - ab[IX(i,j,k)]*x[IX(i,j,k-1)]
         - b[IX(i,j,k)];
     residual += tmp * tmp;
-  END_FOR
+  END_FOR_TILED
     
-  return residual / (imax*jmax*kmax);
+  return (REAL) (residual / (imax*jmax*kmax));
 
 }// End of check_residual( )
 
@@ -88,51 +96,43 @@ void ffd_log(char *message, FFD_MSG_TYPE msg_type) {
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param psi Pointer to the variable
-///\param BINDEX Pointer to the boudnary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-REAL outflow(PARA_DATA *para, REAL **var, REAL *psi, int **BINDEX) {
-  int i, j, k;
+REAL outflow(PARA_DATA *para, REAL **var, REAL *psi) {
   int it;
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int index= para->geom->index;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ];
+  int nb_bcell = para->geom->nb_bcell;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
-  REAL mass_out=0;
-  REAL *flagp = var[FLAGP];
+  double mass_out=0;
+  BOUNDARY_CELL *bnd = para->geom->bcell;
 
   /*---------------------------------------------------------------------------
   | Compute the total outflow
   ---------------------------------------------------------------------------*/
-  for(it=0;it<index;it++) {
-    i=BINDEX[0][it];
-    j=BINDEX[1][it];
-    k=BINDEX[2][it];
-    if(flagp[IX(i,j,k)]==2) {
-      if(i==0) 
-        mass_out += psi[IX(i,j,k)] * (-u[IX(i,j,k)])
-                  * (gy[IX(i,j,k)]-gy[IX(i,j-1,k)])
-                  * (gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-      if(i==imax+1)
-        mass_out += psi[IX(i-1,j,k)] * u[IX(i-1,j,k)] 
-                  * (gy[IX(i,j,k)]-gy[IX(i,j-1,k)])
-                  * (gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-      if(j==0) mass_out += psi[IX(i,j,k)]*(-v[IX(i,j,k)])*(gx[IX(i,j,k)]
-                          -gx[IX(i-1,j,k)])* (gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-      if(j==jmax+1) mass_out += psi[IX(i,j,k)]*v[IX(i,j-1,k)]*(gx[IX(i,j,k)]
-                          -gx[IX(i-1,j,k)])* (gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-      if(k==0) mass_out += psi[IX(i,j,k)]*(-w[IX(i,j,k)])*(gx[IX(i,j,k)]
-                          -gx[IX(i-1,j,k)])* (gy[IX(i,j,k)]-gy[IX(i,j-1,k)]);
-      if(k==kmax+1) mass_out += psi[IX(i,j,k)]*w[IX(i,j,k-1)]*(gx[IX(i,j,k)]
-                          -gx[IX(i-1,j,k)])* (gy[IX(i,j,k)]-gy[IX(i,j-1,k)]);  
-    }
-
-  }
+  for(it=0; it<nb_bcell; it++, bnd++)
+    if(bnd->type==OUTLET)
+      switch(bnd->face) {
+        case FACE_W:
+          mass_out += psi[bnd->id] * (-u[bnd->id]) * bnd->area;
+          break;
+        case FACE_E:
+          mass_out += psi[bnd->nb] * u[bnd->nb] * bnd->area;
+          break;
+        case FACE_S:
+          mass_out += psi[bnd->id] * (-v[bnd->id]) * bnd->area;
+          break;
+        case FACE_N:
+          mass_out += psi[bnd->id] * v[bnd->nb] * bnd->area;
+          break;
+        case FACE_B:
+          mass_out += psi[bnd->id] * (-w[bnd->id]) * bnd->area;
+          break;
+        case FACE_F:
+          mass_out += psi[bnd->id] * w[bnd->nb] * bnd->area;
+          break;
+      }
 
-  return mass_out;
+  return (REAL) mass_out;
 } // End of outflow()
 
 
@@ -142,47 +142,43 @@ REAL outflow(PARA_DATA *para, REAL **var, REAL *psi, int **BINDEX) {
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param psi Pointer to the variable
-///\param BINDEX Pointer to the boudnary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-REAL inflow(PARA_DATA *para, REAL **var, REAL *psi, int **BINDEX) {
-  int i, j, k;
+REAL inflow(PARA_DATA *para, REAL **var, REAL *psi) {
   int it;
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int index= para->geom->index;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ];
+  int nb_bcell = para->geom->nb_bcell;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
-  REAL mass_in=0;
-  REAL *flagp = var[FLAGP];
+  double mass_in=0;
+  BOUNDARY_CELL *bnd = para->geom->bcell;
 
   /*---------------------------------------------------------------------------
   | Compute the total inflow
   ---------------------------------------------------------------------------*/
-    for(it=0;it<index;it++) {
-		  i=BINDEX[0][it];
-      j=BINDEX[1][it];
-      k=BINDEX[2][it];
-
-        if(flagp[IX(i,j,k)]==0)	{
-					if(i==0) mass_in += psi[IX(i,j,k)]*u[IX(i,j,k)]*(gy[IX(i,j,k)]
-                              -gy[IX(i,j-1,k)])* (gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-					if(i==imax+1) mass_in += psi[IX(i,j,k)]*(-u[IX(i,j,k)])*(gy[IX(i,j,k)]
-                              -gy[IX(i,j-1,k)])* (gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-					if(j==0) mass_in += psi[IX(i,j,k)]*v[IX(i,j,k)]*(gx[IX(i,j,k)]
-                              -gx[IX(i-1,j,k)])* (gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-					if(j==jmax+1) mass_in += psi[IX(i,j,k)]*(-v[IX(i,j,k)])*(gx[IX(i,j,k)]
-                              -gx[IX(i-1,j,k)])* (gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-					if(k==0) mass_in += psi[IX(i,j,k)]*w[IX(i,j,k)]*(gx[IX(i,j,k)]
-                              -gx[IX(i-1,j,k)])* (gy[IX(i,j,k)]-gy[IX(i,j-1,k)]);
-					if(k==kmax+1) mass_in += psi[IX(i,j,k)]*(-w[IX(i,j,k)])*(gx[IX(i,j,k)]
-                              -gx[IX(i-1,j,k)])* (gy[IX(i,j,k)]-gy[IX(i,j-1,k)]);  
-			  }
-	  }
-
-	return mass_in;
+  for(it=0; it<nb_bcell; it++, bnd++)
+    if(bnd->type==INLET)
+      switch(bnd->face) {
+        case FACE_W:
+          mass_in += psi[bnd->id] * u[bnd->id] * bnd->area;
+          break;
+        case FACE_E:
+          mass_in += psi[bnd->id] * (-u[bnd->id]) * bnd->area;
+          break;
+        case FACE_S:
+          mass_in += psi[bnd->id] * v[bnd->id] * bnd->area;
+          break;
+        case FACE_N:
+          mass_in += psi[bnd->id] * (-v[bnd->id]) * bnd->area;
+          break;
+        case FACE_B:
+          mass_in += psi[bnd->id] * w[bnd->id] * bnd->area;
+          break;
+        case FACE_F:
+          mass_in += psi[bnd->id] * (-w[bnd->id]) * bnd->area;
+          break;
+      }
+
+  return (REAL) mass_in;
 } // End of inflow()
 
 
@@ -274,22 +270,24 @@ REAL average(PARA_DATA *para, REAL *psi) {
 /// The average is weighted by volume of each cell
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param psi Pointer to the variable
 ///
 ///\return Volume weighted average
 ///////////////////////////////////////////////////////////////////////////////
-REAL average_volume(PARA_DATA *para, REAL **var, REAL *psi) {
+REAL average_volume(PARA_DATA *para, REAL *psi) {
   int imax = para->geom->imax, jmax = para->geom->jmax; 
   int kmax = para->geom->kmax;
   int i, j, k;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL tmp1 = 0, tmp2 = 0, tmp3 = 0;
+  REAL tmp1 = 0;
+  double tmp2 = 0, tmp3 = 0;
+  CELL_MASK *mask = cell_mask(para);
 
+  if(mask==NULL) return 0;
 
   FOR_EACH_CELL
-    if(var[FLAGP][IX(i,j,k)]==FLUID) {
-      tmp1 = vol(para, var, i, j, k);
+    if(IS_FLUID(mask[IX(i,j,k)], MASK_P)) {
+      tmp1 = vol(para, i, j, k);
       tmp2 += psi[IX(i,j,k)]*tmp1;
       tmp3 += tmp1;
     }
@@ -300,12 +298,31 @@ REAL average_volume(PARA_DATA *para, REAL **var, REAL *psi) {
   if(tmp3==0)
     return 0;
   else
-    return tmp2 / tmp3;
+    return (REAL) (tmp2 / tmp3);
 }// End of average_volume( )
 
+///////////////////////////////////////////////////////////////////////////////
+/// Get the number of boundary and sensor values that are averaged over time
+///
+/// The sums are stored in the order walls, ports with their temperature,
+/// velocity, species and substances, room temperature and sensors.
+///
+///\param para Pointer to FFD parameters
+///
+///\return Number of values
+///////////////////////////////////////////////////////////////////////////////
+static size_t bnd_sum_size(PARA_DATA *para) {
+  return (size_t) (para->bc->nb_wall
+                   + para->bc->nb_port*(2+para->bc->nb_Xi+para->bc->nb_C)
+                   + 1 + para->sens->nb_sensor);
+} // End of bnd_sum_size()
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Calcuate time averaged value
 ///
+/// The means of the cells, boundaries and sensors are the sums of
+/// add_time_averaged_data() divided by the averaged time. The sums are not
+/// changed, so that the function can be called again after more steps.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
@@ -314,38 +331,48 @@ REAL average_volume(PARA_DATA *para, REAL **var, REAL *psi) {
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int average_time(PARA_DATA *para, REAL **var) {
-  int i, j, k;
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  int step = para->mytime->step_mean;
+  int i, j, n = 0;
+  double t = para->mytime->t_mean;
+
+  if(require_field(var, VXM)==NULL || require_field(var, VYM)==NULL
+     || require_field(var, VZM)==NULL || require_field(var, TEMPM)==NULL)
+    return 1;
+
+  // Nothing has been added yet
+  if(t<=0)
+    return 0;
+
+  // The sums are kept, so that the means can be updated again later
+  if(mean_sum!=NULL)
+    for(i=0; i<(int)field_size; i++) {
+      var[VXM][i] = (REAL) (mean_sum[i] / t);
+      var[VYM][i] = (REAL) (mean_sum[field_size+i] / t);
+      var[VZM][i] = (REAL) (mean_sum[2*field_size+i] / t);
+      var[TEMPM][i] = (REAL) (mean_sum[3*field_size+i] / t);
+    }
+
+  if(bnd_sum==NULL)
+    return 0;
 
-  FOR_ALL_CELL
-    var[VXM][IX(i,j,k)] = var[VXM][IX(i,j,k)] / step;
-    var[VYM][IX(i,j,k)] = var[VYM][IX(i,j,k)] / step;
-    var[VZM][IX(i,j,k)] = var[VZM][IX(i,j,k)] / step;
-    var[TEMPM][IX(i,j,k)] = var[TEMPM][IX(i,j,k)] / step;
-  END_FOR
-  
   // Wall surfaces
   for(i=0; i<para->bc->nb_wall; i++) 
-    para->bc->temHeaMean[i] = para->bc->temHeaMean[i] / step;
+    para->bc->temHeaMean[i] = bnd_sum[n++] / t;
 
   // Fluid ports
   for(i=0; i<para->bc->nb_port; i++) {
-    para->bc->TPortMean[i] = para->bc->TPortMean[i] / step;
-    para->bc->velPortMean[i] = para->bc->velPortMean[i] / step;
+    para->bc->TPortMean[i] = bnd_sum[n++] / t;
+    para->bc->velPortMean[i] = bnd_sum[n++] / t;
     
     for(j=0; j<para->bc->nb_Xi; j++) 
-      para->bc->XiPortMean[i][j] = para->bc->XiPortMean[i][j] / step;
+      para->bc->XiPortMean[i][j] = bnd_sum[n++] / t;
     for(j=0; j<para->bc->nb_C; j++) 
-      para->bc->CPortMean[i][j] = para->bc->CPortMean[i][j] / step;    
+      para->bc->CPortMean[i][j] = bnd_sum[n++] / t;
   }
 
   // Sensor data
-  para->sens->TRooMean = para->sens->TRooMean / step;
+  para->sens->TRooMean = bnd_sum[n++] / t;
   for(i=0; i<para->sens->nb_sensor; i++) 
-    para->sens->senValMean[i] = para->sens->senValMean[i] / step;
+    para->sens->senValMean[i] = bnd_sum[n++] / t;
 
   return 0;
 } // End of average_time()
@@ -365,12 +392,21 @@ int reset_time_averaged_data (PARA_DATA *para, REAL **var) {
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
 
+  if(require_field(var, VXM)==NULL || require_field(var, VYM)==NULL
+     || require_field(var, VZM)==NULL || require_field(var, TEMPM)==NULL)
+    return 1;
+
   FOR_ALL_CELL
     var[VXM][IX(i,j,k)] = 0;
     var[VYM][IX(i,j,k)] = 0;
     var[VZM][IX(i,j,k)] = 0;
     var[TEMPM][IX(i,j,k)] = 0;
   END_FOR
+
+  if(mean_sum!=NULL)
+    memset(mean_sum, 0, 4*field_size*sizeof(double));
+  if(bnd_sum!=NULL)
+    memset(bnd_sum, 0, bnd_sum_size(para)*sizeof(double));
   
   // Wall surfaces
   for(i=0; i<para->bc->nb_wall; i++) 
@@ -395,12 +431,18 @@ int reset_time_averaged_data (PARA_DATA *para, REAL **var) {
 
   //Reset the time step to 0
   para->mytime->step_mean = 0;
+  para->mytime->t_mean = 0;
   return 0;
 } // End of reset_time_averaged_data()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Add time averaged value for the time average later on
 ///
+/// The values are added in double precision, so that the means of long
+/// averaging windows do not lose the precision of REAL. Each value is
+/// weighted by the time step size, so that the means stay correct if the
+/// time step size is adapted.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///
@@ -408,43 +450,67 @@ int reset_time_averaged_data (PARA_DATA *para, REAL **var) {
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int add_time_averaged_data(PARA_DATA *para, REAL **var) {
-  int i, j;
+  int i, j, n = 0;
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   int size = (imax+2) * (jmax+2) * (kmax+2);
+  double dt = para->mytime->dt;
+
+  if(require_field(var, VXM)==NULL || require_field(var, VYM)==NULL
+     || require_field(var, VZM)==NULL || require_field(var, TEMPM)==NULL)
+    return 1;
+
+  // Sums of all the cells in double precision
+  if(mean_sum==NULL) {
+    mean_sum = (double *) calloc(4*field_size, sizeof(double));
+    if(mean_sum==NULL) {
+      ffd_log("add_time_averaged_data(): Could not allocate memory for the "
+              "sums.", FFD_ERROR);
+      return 1;
+    }
+  }
+
+  // Sums of the boundary and sensor data
+  if(bnd_sum==NULL) {
+    bnd_sum = (double *) calloc(bnd_sum_size(para), sizeof(double));
+    if(bnd_sum==NULL) {
+      ffd_log("add_time_averaged_data(): Could not allocate memory for the "
+              "sums of the boundary data.", FFD_ERROR);
+      return 1;
+    }
+  }
 
-  // All the cells
   for(i=0; i<size; i++) {
-    var[VXM][i] += var[VX][i];
-    var[VYM][i] += var[VY][i];
-    var[VZM][i] += var[VZ][i];
-    var[TEMPM][i] += var[TEMP][i];
+    mean_sum[i] += var[VX][i] * dt;
+    mean_sum[field_size+i] += var[VY][i] * dt;
+    mean_sum[2*field_size+i] += var[VZ][i] * dt;
+    mean_sum[3*field_size+i] += var[TEMP][i] * dt;
   }
 
   // Wall surfaces
   for(i=0; i<para->bc->nb_wall; i++) 
-    para->bc->temHeaMean[i] += para->bc->temHeaAve[i];
+    bnd_sum[n++] += para->bc->temHeaAve[i] * dt;
 
   // Fluid ports
   for(i=0; i<para->bc->nb_port; i++) {
-    para->bc->TPortMean[i] += para->bc->TPortAve[i];
-    para->bc->velPortMean[i] += para->bc->velPortAve[i];
+    bnd_sum[n++] += para->bc->TPortAve[i] * dt;
+    bnd_sum[n++] += para->bc->velPortAve[i] * dt;
     
     for(j=0; j<para->bc->nb_Xi; j++) 
-      para->bc->XiPortMean[i][j] += para->bc->XiPortAve[i][j];
+      bnd_sum[n++] += para->bc->XiPortAve[i][j] * dt;
     for(j=0; j<para->bc->nb_C; j++) 
-      para->bc->CPortMean[i][j] += para->bc->CPortAve[i][j];
+      bnd_sum[n++] += para->bc->CPortAve[i][j] * dt;
     
   }
 
   // Sensor data
-  para->sens->TRooMean += para->sens->TRoo;
+  bnd_sum[n++] += para->sens->TRoo * dt;
   for(j=0; j<para->sens->nb_sensor; j++) 
-    para->sens->senValMean[j] += para->sens->senVal[j];
+    bnd_sum[n++] += para->sens->senVal[j] * dt;
 
   // Update the step
   para->mytime->step_mean++;
+  para->mytime->t_mean += dt;
 
   return 0;
 } // End of add_time_averaged_data()
@@ -455,102 +521,27 @@ int add_time_averaged_data(PARA_DATA *para, REAL **var) {
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to the boudnary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-REAL qwall(PARA_DATA *para, REAL **var,int **BINDEX) {
-  int i, j, k;
+REAL qwall(PARA_DATA *para, REAL **var) {
   int it;
-  int index=para->geom->index;
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int nb_bcell = para->geom->nb_bcell;
   REAL *psi=var[TEMP];
-  REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ];
   REAL coeff_h=para->prob->coeff_h;
-  REAL qwall=0;
-
-  REAL *flagp = var[FLAGP];
+  double qwall=0;
+  CELL_MASK *mask = cell_mask(para);
+  BOUNDARY_CELL *bnd = para->geom->bcell;
 
-  for(it=0;it<index;it++) {
-    i=BINDEX[0][it];
-    j=BINDEX[1][it];
-    k=BINDEX[2][it];
+  if(mask==NULL) return 0;
 
-    if(flagp[IX(i,j,k)]==1)	{
-		  if(i==0) {
-			  if(flagp[IX(i+1,j,k)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i+1,j,k)])*coeff_h
-                *(gy[IX(i,j,k)]-gy[IX(i,j-1,k)])*(gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-        }
-			}
-			else if(i==imax+1) {
-	      if(flagp[IX(i-1,j,k)]<0) { 
-          qwall += (psi[IX(i,j,k)]-psi[IX(i-1,j,k)])*coeff_h
-                *(gy[IX(i,j,k)]-gy[IX(i,j-1,k)])*(gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-        }				
-      }
-		  else {
-			  if(flagp[IX(i+1,j,k)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i+1,j,k)])*coeff_h
-                *(gy[IX(i,j,k)]-gy[IX(i,j-1,k)])*(gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-        }
-				if(flagp[IX(i-1,j,k)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i-1,j,k)])*coeff_h
-                *(gy[IX(i,j,k)]-gy[IX(i,j-1,k)])*(gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-        }
-			}
-
-	  	if(j==0) {
-        if(flagp[IX(i,j+1,k)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i,j+1,k)])*coeff_h
-                *(gx[IX(i,j,k)]-gx[IX(i-1,j,k)])*(gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-       }					
-		  }
-		  else if(j==jmax+1) {
-		    if(flagp[IX(i,j-1,k)]<0) {
-         qwall += (psi[IX(i,j,k)]-psi[IX(i,j-1,k)])*coeff_h
-                *(gx[IX(i,j,k)]-gx[IX(i-1,j,k)])*(gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-        }
-	  	}
-		  else {
-		    if(flagp[IX(i,j-1,k)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i,j-1,k)])*coeff_h
-                *(gx[IX(i,j,k)]-gx[IX(i-1,j,k)])*(gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-      }
-			  if(flagp[IX(i,j+1,k)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i,j+1,k)])*coeff_h
-                *(gx[IX(i,j,k)]-gx[IX(i-1,j,k)])*(gz[IX(i,j,k)]-gz[IX(i,j,k-1)]);
-        }
-			}
-
-			if(k==0) {
-        if(flagp[IX(i,j,k+1)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i,j,k+1)])*coeff_h
-                *(gy[IX(i,j,k)]-gy[IX(i,j-1,k)])*(gx[IX(i,j,k)]-gx[IX(i-1,j,k)]);
-        }	
-			}
-			else if(k==kmax+1) {
-		    if(flagp[IX(i,j,k-1)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i,j,k-1)])*coeff_h
-                *(gy[IX(i,j,k)]-gy[IX(i,j-1,k)])*(gx[IX(i,j,k)]-gx[IX(i-1,j,k)]);
-        } 
-				}
-			else {
-			  if(flagp[IX(i,j,k+1)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i,j,k+1)])*coeff_h
-                *(gy[IX(i,j,k)]-gy[IX(i,j-1,k)])*(gx[IX(i,j,k)]-gx[IX(i-1,j,k)]);
-        } 
-				if(flagp[IX(i,j,k-1)]<0) {
-          qwall += (psi[IX(i,j,k)]-psi[IX(i,j,k-1)])*coeff_h
-                *(gy[IX(i,j,k)]-gy[IX(i,j-1,k)])*(gx[IX(i,j,k)]-gx[IX(i-1,j,k)]);
-        }					
-			}
-    }
-  }
+  // Faces of solid cells next to a fluid cell
+  for(it=0; it<nb_bcell; it++, bnd++)
+    if(bnd->type==SOLID && bnd->face!=FACE_NONE
+       && IS_FLUID(mask[bnd->nb], MASK_P))
+      qwall += (psi[bnd->id]-psi[bnd->nb])*coeff_h*bnd->area;
 
-  return qwall;
+  return (REAL) qwall;
 
 } // End of qwall()
 
@@ -563,11 +554,214 @@ REAL qwall(PARA_DATA *para, REAL **var,int **BINDEX) {
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 void free_index(int **BINDEX) { 
-  if(BINDEX[0]) free(BINDEX[0]);
-  if(BINDEX[1]) free(BINDEX[1]);
-  if(BINDEX[2]) free(BINDEX[2]);
+  int i;
+
+  for(i=0; i<5; i++)
+    if(BINDEX[i]) free(BINDEX[i]);
 } // End of free_index ()
 
+///////////////////////////////////////////////////////////////////////////////
+/// Change the number of entries of BINDEX
+///
+/// BINDEX needs up to one entry per cell while the input files are read.
+/// Once the table of boundary faces is built, it is shrunk to the number of
+/// boundary cells.
+///
+///\param BINDEX Pointer to the boudnary index
+///\param size Number of entries
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int resize_index(int **BINDEX, int size) {
+  int i;
+  int *tmp;
+
+  if(size<1) size = 1;
+
+  for(i=0; i<5; i++) {
+    tmp = (int *) realloc(BINDEX[i], size*sizeof(int));
+    if(tmp==NULL) {
+      sprintf(msg, "resize_index(): Could not allocate memory for "
+              "BINDEX[%d]", i);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+    }
+    BINDEX[i] = tmp;
+  }
+
+  return 0;
+} // End of resize_index()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Check if a variable is only allocated when it is used
+///
+///\param n Index of the variable
+///
+///\return 1 if the variable is optional, otherwise 0
+///////////////////////////////////////////////////////////////////////////////
+static int is_optional_field(int n) {
+  switch(n) {
+    case VXM: case VYM: case VZM: case TEMPM:
+    case VXS: case VYS: case VZS: case TEMPS:
+    case LOCMIN: case LOCMAX: case QFLUXBC:
+    // Only used by Chen's zero equation model
+    case NUT: case WDIST:
+    // The coordinates are stored in para->geom->mesh
+    case X: case Y: case Z: case GX: case GY: case GZ:
+    // The cell types are stored in para->geom->mask
+    case FLAGP: case FLAGU: case FLAGV: case FLAGW:
+      return 1;
+    default:
+      return 0;
+  }
+} // End of is_optional_field()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate aligned memory
+///
+///\param bytes Number of bytes
+///\param align Alignment in bytes, a power of 2
+///
+///\return Pointer to the memory, NULL if it could not be allocated
+///////////////////////////////////////////////////////////////////////////////
+static void *field_malloc(size_t bytes, size_t align) {
+#ifdef _MSC_VER
+  return _aligned_malloc(bytes, align);
+#else
+  void *ptr;
+  if(posix_memalign(&ptr, align, bytes)!=0) return NULL;
+  return ptr;
+#endif
+} // End of field_malloc()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory allocated by field_malloc()
+///
+///\param ptr Pointer to the memory
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void field_free(void *ptr) {
+#ifdef _MSC_VER
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+} // End of field_free()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the memory for FFD simulation variables
+///
+/// All the variables that are used in every run share one arena. Each
+/// variable starts at a FIELD_ALIGN byte boundary and its length is padded
+/// so that the variables do not map to the same cache sets. The optional
+/// variables (see is_optional_field()) are not allocated here but by
+/// require_field() when they are used for the first time. The memory is
+/// set to 0 by set_initial_data().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb_var Number of variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_fields(PARA_DATA *para, REAL **var, int nb_var) {
+  int i, nb_core = 0;
+  size_t bytes, align = FIELD_ALIGN;
+
+  field_size = (para->geom->imax+2)*(para->geom->jmax+2)
+             * (para->geom->kmax+2);
+  field_nb = nb_var;
+
+  // Pad each variable to full cache lines and avoid a stride of full pages
+  bytes = (field_size*sizeof(REAL) + FIELD_ALIGN - 1) / FIELD_ALIGN
+        * FIELD_ALIGN;
+  if(bytes%4096==0) bytes += FIELD_ALIGN;
+  field_stride = bytes / sizeof(REAL);
+
+  for(i=0; i<nb_var; i++) {
+    var[i] = NULL;
+    if(!is_optional_field(i)) nb_core++;
+  }
+
+  bytes = field_stride*sizeof(REAL)*nb_core;
+#ifdef FFD_HUGE_PAGE
+  align = FFD_HUGE_PAGE_SIZE;
+  bytes = (bytes + align - 1) / align * align;
+#endif
+  field_arena = (REAL *) field_malloc(bytes, align);
+  if(field_arena==NULL) {
+    sprintf(msg, "allocate_fields(): Could not allocate %lu bytes for the "
+            "variables.", (unsigned long) bytes);
+    ffd_log(msg, FFD_ERROR);
+    return 1;
+  }
+#if defined(FFD_HUGE_PAGE) && defined(MADV_HUGEPAGE)
+  if(madvise(field_arena, bytes, MADV_HUGEPAGE)!=0)
+    ffd_log("allocate_fields(): Transparent huge pages are not available.",
+            FFD_WARNING);
+#endif
+
+  nb_core = 0;
+  for(i=0; i<nb_var; i++)
+    if(!is_optional_field(i)) {
+      var[i] = field_arena + field_stride*nb_core;
+      nb_core++;
+    }
+
+  sprintf(msg, "allocate_fields(): Allocated %d of %d variables with "
+          "%lu bytes.", nb_core, nb_var, (unsigned long) bytes);
+  ffd_log(msg, FFD_NORMAL);
+
+  return 0;
+} // End of allocate_fields()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get a variable and allocate it if it is optional and not allocated yet
+///
+/// A new variable is set to 0.
+///
+///\param var Pointer to FFD simulation variables
+///\param n Index of the variable
+///
+///\return Pointer to the variable, NULL if it could not be allocated
+///////////////////////////////////////////////////////////////////////////////
+REAL *require_field(REAL **var, int n) {
+  if(var[n]!=NULL) return var[n];
+
+  var[n] = (REAL *) field_malloc(field_stride*sizeof(REAL), FIELD_ALIGN);
+  if(var[n]==NULL) {
+    sprintf(msg, "require_field(): Could not allocate memory for var[%d].",
+            n);
+    ffd_log(msg, FFD_ERROR);
+    return NULL;
+  }
+  memset(var[n], 0, field_stride*sizeof(REAL));
+
+  return var[n];
+} // End of require_field()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set all the FFD simulation variables to 0
+///
+///\param var Pointer to FFD simulation variables
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void reset_fields(REAL **var) {
+  int i, nb_core = 0;
+
+  for(i=0; i<field_nb; i++)
+    if(is_optional_field(i)) {
+      if(var[i]!=NULL) memset(var[i], 0, field_stride*sizeof(REAL));
+    }
+    else
+      nb_core++;
+
+  if(field_arena!=NULL)
+    memset(field_arena, 0, field_stride*sizeof(REAL)*nb_core);
+} // End of reset_fields()
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Free memory for FFD simulation variables
 ///
@@ -577,49 +771,452 @@ void free_index(int **BINDEX) {
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 void free_data(REAL **var) {
-  if(var[X]) free(var[X]);
-  if(var[Y]) free(var[Y]);
-  if(var[Z]) free(var[Z]);
-  if(var[VX]) free(var[VX]);
-  if(var[VY]) free(var[VY]);
-  if(var[VZ]) free(var[VZ]);
-  if(var[VXS]) free(var[VXS]);
-  if(var[VYS]) free(var[VYS]);
-  if(var[VZS]) free(var[VZS]);
-  if(var[VXM]) free(var[VXM]);
-  if(var[VYM]) free(var[VYM]);
-  if(var[VZM]) free(var[VZM]);
-  if(var[TEMP]) free(var[TEMP]);
-  if(var[TEMPM]) free(var[TEMPM]);
-  if(var[TEMPS]) free(var[TEMPS]);
-  if(var[IP]) free(var[IP]);
-  if(var[TMP1]) free(var[TMP1]);
-  if(var[TMP2]) free(var[TMP2]);
-  if(var[TMP3]) free(var[TMP3]);
-  if(var[AP]) free(var[AP]);
-  if(var[AN]) free(var[AN]);
-  if(var[AS]) free(var[AS]);
-  if(var[AE]) free(var[AE]);
-  if(var[AW]) free(var[AW]);
-  if(var[AF]) free(var[AF]);
-  if(var[AB]) free(var[AB]);
-  if(var[B])  free(var[B]);
-  if(var[GX])  free(var[GX]);
-  if(var[GY])  free(var[GY]);
-  if(var[GZ])  free(var[GZ]);
-  if(var[AP0])  free(var[AP0]);
-  if(var[PP])  free(var[PP]);
-  if(var[FLAGP])  free(var[FLAGP]);
-  if(var[FLAGU])  free(var[FLAGU]);
-  if(var[FLAGV])  free(var[FLAGV]);
-  if(var[FLAGW])  free(var[FLAGW]);
-  if(var[LOCMIN])  free(var[LOCMIN]);
-  if(var[LOCMAX])  free(var[LOCMAX]);
-  if(var[VXBC])  free(var[VXBC]);
-  if(var[VYBC])  free(var[VYBC]);
-  if(var[VZBC])  free(var[VZBC]);
-  if(var[TEMPBC])  free(var[TEMPBC]);
-  if(var[QFLUXBC])  free(var[QFLUXBC]);
-  if(var[QFLUX])  free(var[QFLUX]);
+  int i;
+
+  for(i=0; i<field_nb; i++) {
+    if(is_optional_field(i) && var[i]!=NULL) field_free(var[i]);
+    var[i] = NULL;
+  }
 
+  if(field_arena!=NULL) field_free(field_arena);
+  field_arena = NULL;
+  field_nb = 0;
+
+  if(mean_sum!=NULL) free(mean_sum);
+  mean_sum = NULL;
+  if(bnd_sum!=NULL) free(bnd_sum);
+  bnd_sum = NULL;
 } // End of free_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the memory for the packed cell types
+///
+/// The mask is the only storage of the cell types. All the locations are
+/// FLUID until the types are set by the input files.
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_cell_mask(PARA_DATA *para) {
+  int size = (para->geom->imax+2)*(para->geom->jmax+2)*(para->geom->kmax+2);
+
+  free_cell_mask(para);
+  para->geom->mask = (CELL_MASK *) calloc(size, sizeof(CELL_MASK));
+  if(para->geom->mask==NULL) {
+    ffd_log("allocate_cell_mask(): Could not allocate memory for the cell "
+            "types.", FFD_ERROR);
+    return 1;
+  }
+
+  return 0;
+} // End of allocate_cell_mask()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the boundary faces of the packed cell types
+///
+/// A cell that is not fluid gets the bit FACE_BIT(f) of each of its faces f
+/// as described for BOUNDARY_CELL in data_structure.h: the sides on the
+/// domain boundary of a cell on the boundary, or the sides of an internal
+/// cell next to a fluid pressure cell. The bits are set again from the
+/// pressure types whenever the types of the cells have changed.
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_cell_mask(PARA_DATA *para) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+  CELL_MASK *mask = cell_mask(para), m;
+
+  if(mask==NULL) return 1;
+
+  FOR_ALL_CELL
+    // Keep the cell types of the low byte
+    m = (CELL_MASK) (mask[IX(i,j,k)] & ((1<<MASK_FACE)-1));
+
+    if(!IS_FLUID(m, MASK_P)) {
+      if(i==0) m |= FACE_BIT(FACE_W);
+      if(i==imax+1) m |= FACE_BIT(FACE_E);
+      if(j==0) m |= FACE_BIT(FACE_S);
+      if(j==jmax+1) m |= FACE_BIT(FACE_N);
+      if(k==0) m |= FACE_BIT(FACE_B);
+      if(k==kmax+1) m |= FACE_BIT(FACE_F);
+
+      // Fluid neighbors of an internal cell
+      if(i>0 && i<=imax && j>0 && j<=jmax && k>0 && k<=kmax) {
+        if(IS_FLUID(mask[IX(i+1,j,k)], MASK_P)) m |= FACE_BIT(FACE_W);
+        if(IS_FLUID(mask[IX(i-1,j,k)], MASK_P)) m |= FACE_BIT(FACE_E);
+        if(IS_FLUID(mask[IX(i,j+1,k)], MASK_P)) m |= FACE_BIT(FACE_S);
+        if(IS_FLUID(mask[IX(i,j-1,k)], MASK_P)) m |= FACE_BIT(FACE_N);
+        if(IS_FLUID(mask[IX(i,j,k+1)], MASK_P)) m |= FACE_BIT(FACE_B);
+        if(IS_FLUID(mask[IX(i,j,k-1)], MASK_P)) m |= FACE_BIT(FACE_F);
+      }
+    }
+
+    mask[IX(i,j,k)] = m;
+  END_FOR
+
+  return 0;
+} // End of set_cell_mask()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the packed cell types
+///
+///\param para Pointer to FFD parameters
+///
+///\return Pointer to the cell types, NULL if they have not been allocated
+///////////////////////////////////////////////////////////////////////////////
+CELL_MASK *cell_mask(PARA_DATA *para) {
+  if(para->geom->mask==NULL)
+    ffd_log("cell_mask(): The cell types have not been allocated.",
+            FFD_ERROR);
+  return para->geom->mask;
+} // End of cell_mask()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the packed cell types
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_cell_mask(PARA_DATA *para) {
+  if(para->geom->mask!=NULL) free(para->geom->mask);
+  para->geom->mask = NULL;
+} // End of free_cell_mask()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the coordinates of the mesh in one direction
+///
+/// The block holds the arrays of the cell centers, cell surfaces, cell
+/// lengths and their reciprocals, each with n+2 entries.
+///
+///\param del Pointer to the lengths of the cells 1 to n, del[0] is 0
+///\param n Number of interior cells
+///\param L Size of the domain
+///
+///\return Pointer to the block of coordinates, NULL if there is no memory
+///////////////////////////////////////////////////////////////////////////////
+static REAL *set_mesh_axis(REAL *del, int n, REAL L) {
+  int i;
+  REAL temp = 0;
+  REAL *c = (REAL *) malloc(5*(n+2)*sizeof(REAL));
+  REAL *g, *d, *rd, *rdc;
+
+  if(c==NULL) return NULL;
+  g = c + (n+2);
+  d = g + (n+2);
+  rd = d + (n+2);
+  rdc = rd + (n+2);
+
+  // Cell surfaces
+  for(i=0; i<=n+1; i++) {
+    temp = i>=n ? L : temp + del[i];
+    g[i] = temp;
+  }
+
+  // Cell centers
+  for(i=0; i<=n+1; i++) {
+    if(i<1)
+      c[i] = 0;
+    else if(i>n)
+      c[i] = L;
+    else
+      c[i] = (REAL) 0.5 * (g[i]+g[i-1]);
+  }
+
+  for(i=0; i<=n+1; i++) {
+    d[i] = i>0 ? g[i] - g[i-1] : 0;
+    rd[i] = d[i]!=0 ? 1 / d[i] : 0;
+    rdc[i] = i<=n && c[i+1]!=c[i] ? 1 / (c[i+1]-c[i]) : 0;
+  }
+
+  return c;
+} // End of set_mesh_axis()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Build the 1D coordinates of the mesh
+///
+/// The mesh is structured so that the coordinates of cell (i,j,k) only
+/// depend on i, j or k. See MESH_DATA in data_structure.h.
+///
+///\param para Pointer to FFD parameters
+///\param delx Pointer to the cell lengths in X-direction, delx[0] is 0
+///\param dely Pointer to the cell lengths in Y-direction, dely[0] is 0
+///\param delz Pointer to the cell lengths in Z-direction, delz[0] is 0
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_mesh(PARA_DATA *para, REAL *delx, REAL *dely, REAL *delz) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  MESH_DATA *mesh;
+
+  free_mesh(para);
+  mesh = (MESH_DATA *) calloc(1, sizeof(MESH_DATA));
+  if(mesh==NULL) {
+    ffd_log("set_mesh(): Could not allocate memory for the mesh.", FFD_ERROR);
+    return 1;
+  }
+  para->geom->mesh = mesh;
+
+  mesh->x = set_mesh_axis(delx, imax, para->geom->Lx);
+  mesh->y = set_mesh_axis(dely, jmax, para->geom->Ly);
+  mesh->z = set_mesh_axis(delz, kmax, para->geom->Lz);
+  if(mesh->x==NULL || mesh->y==NULL || mesh->z==NULL) {
+    ffd_log("set_mesh(): Could not allocate memory for the coordinates.",
+            FFD_ERROR);
+    free_mesh(para);
+    return 1;
+  }
+
+  mesh->gx = mesh->x + (imax+2);
+  mesh->dx = mesh->gx + (imax+2);
+  mesh->rdx = mesh->dx + (imax+2);
+  mesh->rdxc = mesh->rdx + (imax+2);
+
+  mesh->gy = mesh->y + (jmax+2);
+  mesh->dy = mesh->gy + (jmax+2);
+  mesh->rdy = mesh->dy + (jmax+2);
+  mesh->rdyc = mesh->rdy + (jmax+2);
+
+  mesh->gz = mesh->z + (kmax+2);
+  mesh->dz = mesh->gz + (kmax+2);
+  mesh->rdz = mesh->dz + (kmax+2);
+  mesh->rdzc = mesh->rdz + (kmax+2);
+
+  return 0;
+} // End of set_mesh()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the coordinates of the mesh
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_mesh(PARA_DATA *para) {
+  MESH_DATA *mesh = para->geom->mesh;
+
+  if(mesh==NULL) return;
+  if(mesh->x!=NULL) free(mesh->x);
+  if(mesh->y!=NULL) free(mesh->y);
+  if(mesh->z!=NULL) free(mesh->z);
+  free(mesh);
+  para->geom->mesh = NULL;
+} // End of free_mesh()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Build the runs of fluid cells for the pressure and velocity locations
+///
+/// A run is a maximal set of consecutive cells in X-direction whose type is
+/// FLUID. The ranges of the cells are those of FOR_EACH_CELL, FOR_U_CELL,
+/// FOR_V_CELL and FOR_W_CELL for MASK_P, MASK_U, MASK_V and MASK_W,
+/// respectively. Loops over the runs visit only the cells that are solved and
+/// need no check of the type.
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_cell_run(PARA_DATA *para) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, n, r, s, iend, jend, kend;
+  CELL_MASK *mask = cell_mask(para);
+  RUN_LIST *list;
+
+  if(mask==NULL) return 1;
+
+  free_cell_run(para);
+  para->geom->run = (RUN_LIST *) calloc(4, sizeof(RUN_LIST));
+  if(para->geom->run==NULL) {
+    ffd_log("set_cell_run(): Could not allocate memory for the runs.",
+            FFD_ERROR);
+    return 1;
+  }
+
+  for(n=0; n<4; n++) {
+    s = 2*n;
+    list = &para->geom->run[n];
+    iend = n==1 ? imax-1 : imax;
+    jend = n==2 ? jmax-1 : jmax;
+    kend = n==3 ? kmax-1 : kmax;
+
+    // Count the runs
+    r = 0;
+    for(k=1; k<=kend; k++)
+      for(j=1; j<=jend; j++)
+        for(i=1; i<=iend; i++)
+          if(IS_FLUID(mask[IX(i,j,k)], s)
+             && (i==1 || !IS_FLUID(mask[IX(i-1,j,k)], s))) r++;
+
+    list->run = (CELL_RUN *) malloc((r+1)*sizeof(CELL_RUN));
+    list->plane = (int *) malloc((kmax+2)*sizeof(int));
+    if(list->run==NULL || list->plane==NULL) {
+      ffd_log("set_cell_run(): Could not allocate memory for the runs.",
+              FFD_ERROR);
+      free_cell_run(para);
+      return 1;
+    }
+
+    // Store the runs
+    r = 0;
+    list->plane[0] = 0;
+    for(k=1; k<=kmax; k++) {
+      list->plane[k] = r;
+      if(k>kend) continue;
+      for(j=1; j<=jend; j++)
+        for(i=1; i<=iend; i++) {
+          if(!IS_FLUID(mask[IX(i,j,k)], s)) continue;
+          if(i==1 || !IS_FLUID(mask[IX(i-1,j,k)], s)) {
+            list->run[r].i1 = i;
+            list->run[r].j = j;
+            list->run[r].k = k;
+            r++;
+          }
+          list->run[r-1].i2 = i;
+        }
+    }
+    list->plane[kmax+1] = r;
+    list->nb_run = r;
+  }
+
+  sprintf(msg, "set_cell_run(): %d, %d, %d and %d runs of fluid cells for "
+          "P, U, V and W.", para->geom->run[0].nb_run,
+          para->geom->run[1].nb_run, para->geom->run[2].nb_run,
+          para->geom->run[3].nb_run);
+  ffd_log(msg, FFD_NORMAL);
+
+  return 0;
+} // End of set_cell_run()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the runs of fluid cells of a location
+///
+/// The runs are built at the first call if mark_cell() has not done it.
+///
+///\param para Pointer to FFD parameters
+///\param s Shift of the location in the cell types: MASK_P, MASK_U, MASK_V or
+///         MASK_W
+///
+///\return Pointer to the runs, NULL if they could not be built
+///////////////////////////////////////////////////////////////////////////////
+RUN_LIST *cell_run(PARA_DATA *para, int s) {
+  if(para->geom->run==NULL && set_cell_run(para)!=0) return NULL;
+
+  return &para->geom->run[s/2];
+} // End of cell_run()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the runs of fluid cells
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_cell_run(PARA_DATA *para) {
+  int n;
+
+  if(para->geom->run==NULL) return;
+
+  for(n=0; n<4; n++) {
+    if(para->geom->run[n].run!=NULL) free(para->geom->run[n].run);
+    if(para->geom->run[n].plane!=NULL) free(para->geom->run[n].plane);
+  }
+  free(para->geom->run);
+  para->geom->run = NULL;
+
+  if(para->geom->nonfluid!=NULL) free(para->geom->nonfluid);
+  para->geom->nonfluid = NULL;
+  para->geom->nonfluid_run = NULL;
+} // End of free_cell_run()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Build the summed volume table of the cells that are not fluid
+///
+/// Only one table is kept for all locations. It needs (imax+3)*(jmax+3)*
+/// (kmax+3) int, about 4 bytes per cell, and is rebuilt when the advection
+/// switches to another location, which costs one pass over the cells.
+///
+///\param para Pointer to FFD parameters
+///\param list Pointer to the runs of the location, see cell_run()
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_nonfluid(PARA_DATA *para, RUN_LIST *list) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, s;
+  int size = (imax+3)*(jmax+3)*(kmax+3);
+  CELL_MASK *mask = cell_mask(para);
+  int *S;
+
+  if(mask==NULL) return 1;
+  if(para->geom->nonfluid_run==list) return 0;
+
+  if(para->geom->nonfluid==NULL) {
+    para->geom->nonfluid = (int *) malloc(size*sizeof(int));
+    if(para->geom->nonfluid==NULL) {
+      ffd_log("set_nonfluid(): Could not allocate memory for the table.",
+              FFD_ERROR);
+      return 1;
+    }
+  }
+  S = para->geom->nonfluid;
+  s = 2 * (int) (list - para->geom->run);
+
+  // Entry (i+1,j+1,k+1) counts the cells up to (i,j,k)
+  for(i=0; i<size; i++) S[i] = 0;
+  for(k=0; k<=kmax+1; k++)
+    for(j=0; j<=jmax+1; j++)
+      for(i=0; i<=imax+1; i++)
+        S[SVT(i+1,j+1,k+1,imax,jmax)] = !IS_FLUID(mask[IX(i,j,k)], s)
+          + S[SVT(i,j+1,k+1,imax,jmax)] + S[SVT(i+1,j,k+1,imax,jmax)]
+          + S[SVT(i+1,j+1,k,imax,jmax)] - S[SVT(i,j,k+1,imax,jmax)]
+          - S[SVT(i,j+1,k,imax,jmax)] - S[SVT(i+1,j,k,imax,jmax)]
+          + S[SVT(i,j,k,imax,jmax)];
+
+  para->geom->nonfluid_run = list;
+  return 0;
+} // End of set_nonfluid()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Count the cells that are not fluid in a box
+///
+/// The count is taken from the summed volume table of set_nonfluid() with
+/// eight lookups, independent of the size of the box.
+///
+///\param para Pointer to FFD parameters
+///\param i1 I-index of one corner of the box
+///\param j1 J-index of one corner of the box
+///\param k1 K-index of one corner of the box
+///\param i2 I-index of the opposite corner of the box
+///\param j2 J-index of the opposite corner of the box
+///\param k2 K-index of the opposite corner of the box
+///
+///\return Number of the cells that are solid, inlet or outlet
+///////////////////////////////////////////////////////////////////////////////
+int count_nonfluid(PARA_DATA *para, int i1, int j1, int k1, int i2, int j2,
+                   int k2) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int t;
+  int *S = para->geom->nonfluid;
+
+  // Lower corner i1,j1,k1 and upper corner i2+1,j2+1,k2+1 in the table
+  if(i1>i2) { t = i1; i1 = i2; i2 = t; }
+  if(j1>j2) { t = j1; j1 = j2; j2 = t; }
+  if(k1>k2) { t = k1; k1 = k2; k2 = t; }
+  i2++; j2++; k2++;
+
+  return S[SVT(i2,j2,k2,imax,jmax)] - S[SVT(i1,j2,k2,imax,jmax)]
+       - S[SVT(i2,j1,k2,imax,jmax)] - S[SVT(i2,j2,k1,imax,jmax)]
+       + S[SVT(i1,j1,k2,imax,jmax)] + S[SVT(i1,j2,k1,imax,jmax)]
+       + S[SVT(i2,j1,k1,imax,jmax)] - S[SVT(i1,j1,k1,imax,jmax)];
+} // End of count_nonfluid()
@@ -29,6 +29,15 @@
 #include "geometry.h"
 #endif
 
+#ifdef _MSC_VER
+#include <malloc.h>
+#elif defined(FFD_HUGE_PAGE)
+#include <sys/mman.h>
+#endif
+
+#define FIELD_ALIGN 64 // Alignment of the variables in bytes
+#define FFD_HUGE_PAGE_SIZE 2097152 // Alignment of the arena with -DFFD_HUGE_PAGE
+
 
 FILE *file_log;
 
@@ -60,11 +69,10 @@ void ffd_log(char *message, FFD_MSG_TYPE msg_type);
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param psi Pointer to the variable
-///\param BINDEX Pointer to the boudnary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-REAL outflow(PARA_DATA *para, REAL **var, REAL *psi, int **BINDEX);
+REAL outflow(PARA_DATA *para, REAL **var, REAL *psi);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Check the inflow rate of the scalar psi
@@ -72,11 +80,10 @@ REAL outflow(PARA_DATA *para, REAL **var, REAL *psi, int **BINDEX);
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param psi Pointer to the variable
-///\param BINDEX Pointer to the boudnary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-REAL inflow(PARA_DATA *para, REAL **var, REAL *psi, int **BINDEX);
+REAL inflow(PARA_DATA *para, REAL **var, REAL *psi);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Check the minimum value of the scalar psi at (ci,cj,ck) and its surrounding
@@ -122,12 +129,11 @@ REAL average(PARA_DATA *para, REAL *psi);
 /// The average is weighted by volume of each cell
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
 ///\param psi Pointer to the variable
 ///
 ///\return Volume weighted average
 ///////////////////////////////////////////////////////////////////////////////
-REAL average_volume(PARA_DATA *para, REAL **var, REAL *psi);
+REAL average_volume(PARA_DATA *para, REAL *psi);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Calcuate time averaged value
@@ -169,11 +175,10 @@ int add_time_averaged_data (PARA_DATA *para, REAL **var);
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param BINDEX Pointer to the boudnary index
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-REAL qwall(PARA_DATA *para, REAL **var,int **BINDEX);
+REAL qwall(PARA_DATA *para, REAL **var);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Free memory for BINDEX
@@ -185,6 +190,46 @@ REAL qwall(PARA_DATA *para, REAL **var,int **BINDEX);
 ///////////////////////////////////////////////////////////////////////////////
 void free_index(int **BINDEX);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Change the number of entries of BINDEX
+///
+///\param BINDEX Pointer to the boudnary index
+///\param size Number of entries
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int resize_index(int **BINDEX, int size);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the memory for FFD simulation variables
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb_var Number of variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_fields(PARA_DATA *para, REAL **var, int nb_var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get a variable and allocate it if it is optional and not allocated yet
+///
+///\param var Pointer to FFD simulation variables
+///\param n Index of the variable
+///
+///\return Pointer to the variable, NULL if it could not be allocated
+///////////////////////////////////////////////////////////////////////////////
+REAL *require_field(REAL **var, int n);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set all the FFD simulation variables to 0
+///
+///\param var Pointer to FFD simulation variables
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void reset_fields(REAL **var);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Free memory for FFD simulation variables
 ///
@@ -193,4 +238,116 @@ void free_index(int **BINDEX);
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-void free_data(REAL **var); 
\ No newline at end of file
+void free_data(REAL **var); 
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the memory for the packed cell types
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_cell_mask(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the boundary faces of the packed cell types
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_cell_mask(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the packed cell types
+///
+///\param para Pointer to FFD parameters
+///
+///\return Pointer to the cell types, NULL if they have not been allocated
+///////////////////////////////////////////////////////////////////////////////
+CELL_MASK *cell_mask(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the packed cell types
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_cell_mask(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Build the 1D coordinates of the mesh
+///
+///\param para Pointer to FFD parameters
+///\param delx Pointer to the cell lengths in X-direction, delx[0] is 0
+///\param dely Pointer to the cell lengths in Y-direction, dely[0] is 0
+///\param delz Pointer to the cell lengths in Z-direction, delz[0] is 0
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_mesh(PARA_DATA *para, REAL *delx, REAL *dely, REAL *delz);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the coordinates of the mesh
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_mesh(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Build the runs of fluid cells for the pressure and velocity locations
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_cell_run(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the runs of fluid cells of a location
+///
+///\param para Pointer to FFD parameters
+///\param s Shift of the location in the cell types: MASK_P, MASK_U, MASK_V or
+///         MASK_W
+///
+///\return Pointer to the runs, NULL if they could not be built
+///////////////////////////////////////////////////////////////////////////////
+RUN_LIST *cell_run(PARA_DATA *para, int s);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the runs of fluid cells
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_cell_run(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Build the summed volume table of the cells that are not fluid
+///
+///\param para Pointer to FFD parameters
+///\param list Pointer to the runs of the location, see cell_run()
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_nonfluid(PARA_DATA *para, RUN_LIST *list);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Count the cells that are not fluid in a box
+///
+///\param para Pointer to FFD parameters
+///\param i1 I-index of one corner of the box
+///\param j1 J-index of one corner of the box
+///\param k1 K-index of one corner of the box
+///\param i2 I-index of the opposite corner of the box
+///\param j2 J-index of the opposite corner of the box
+///\param k2 K-index of the opposite corner of the box
+///
+///\return Number of the cells that are solid, inlet or outlet
+///////////////////////////////////////////////////////////////////////////////
+int count_nonfluid(PARA_DATA *para, int i1, int j1, int k1, int i2, int j2,
+                   int k2);
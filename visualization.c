@@ -80,17 +80,16 @@ void ffd_display_func(PARA_DATA *para, REAL **var) {
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to all variables
-///\param BINDEX Pointer to bounary index
 ///
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void ffd_idle_func(PARA_DATA *para, REAL **var, int **BINDEX) {
+void ffd_idle_func(PARA_DATA *para, REAL **var) {
   // Get the display in XY plane
   get_xy_UI(para, var, (int)para->geom->kmax/2);
 
-  vel_step(para, var, BINDEX);
-  den_step(para, var, BINDEX);
-  temp_step(para, var, BINDEX);
+  vel_step(para, var);
+  den_step(para, var);
+  temp_step(para, var);
 
   if(para->outp->cal_mean == 1)
     average_time(para, var);
@@ -230,14 +229,17 @@ void get_xy_UI(PARA_DATA *para, REAL **var, int k) {
   int imax = para->geom->imax, jmax = para->geom->jmax;
   REAL Lx = para->geom->Lx, Ly = para->geom->Ly;
   int i, j;
-  REAL *u_s = var[VXS], *v_s = var[VYS], *d_s = var[TRACE], *T_s = var[TEMPS];
-  REAL *x = var[X], *y = var[Y];
+  REAL *u_s = require_field(var, VXS), *v_s = require_field(var, VYS);
+  REAL *d_s = var[TRACE], *T_s = require_field(var, TEMPS);
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
   REAL x0, y0, x_click, y_click;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   int win_x = para->outp->winx, win_y = para->outp->winy;
   int mx = para->outp->mx, my = para->outp->my;
   int *mouse_down = para->outp->mouse_down;
 
+  if(u_s==NULL || v_s==NULL || T_s==NULL) return;
+
   // Set initial value of source to 0
   for(i=0; i<imax+1; i++)
     for(j=0; j<jmax+1; j++)
@@ -246,24 +248,24 @@ void get_xy_UI(PARA_DATA *para, REAL **var, int k) {
   // If no mouse action, return
   if(!mouse_down[0] && !mouse_down[2] ) return;
 
-  x0 = x[IX(0,0,k)], y0 = y[IX(0,0,k)];
+  x0 = x[0], y0 = y[0];
   x_click = (mx/(REAL)win_x) * Lx;
   y_click = (1.0f - my/(REAL)win_y) * Ly;
   i = (int)( (mx/(REAL)win_x) * imax + 1);
  	j = (int)((1.0f - my/(REAL)win_y) * jmax + 1);
   
-  if(x[IX(i,j,k)] - x0 > x_click )
-    while(x[IX(i,j,k)] - x0 > x_click)
+  if(x[i] - x0 > x_click )
+    while(x[i] - x0 > x_click)
       i--;        
   else
-    while(x[IX(i,j,k)] - x0 < x_click)
+    while(x[i] - x0 < x_click)
       i++;
 
-  if(y[IX(i,j,k)]-y0 > y_click)
-    while(y[IX(i,j,k)]-y0 > y_click)
+  if(y[j]-y0 > y_click)
+    while(y[j]-y0 > y_click)
       j--;        
   else
-    while(y[IX(i,j,k)]-y0 < y_click)
+    while(y[j]-y0 < y_click)
       j++;
 
   if(i<1 || i>imax || j<1 || j>jmax) return;
@@ -295,7 +297,8 @@ void get_xy_UI(PARA_DATA *para, REAL **var, int k) {
 void draw_xy_density(PARA_DATA *para, REAL **var, int k) {
   int i, j;
   REAL d00, d01, d10, d11;
-  REAL *x = var[X], *y = var[Y], *dens = var[TRACE];
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
+  REAL *dens = var[TRACE];
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
 
@@ -308,10 +311,10 @@ void draw_xy_density(PARA_DATA *para, REAL **var, int k) {
       d10 = dens[IX(i+1,j  ,k)];
       d11 = dens[IX(i+1,j+1,k)];
 
-      glColor3f(d00, d00, d00); glVertex2f(x[IX(i  ,j,k)], y[IX(i,j  ,k)]);
-      glColor3f(d10, d10, d10); glVertex2f(x[IX(i+1,j,k)], y[IX(i,j  ,k)]);
-      glColor3f(d11, d11, d11); glVertex2f(x[IX(i+1,j,k)], y[IX(i,j+1,k)]);
-      glColor3f(d01, d01, d01); glVertex2f(x[IX(i  ,j,k)], y[IX(i,j+1,k)]);
+      glColor3f(d00, d00, d00); glVertex2f(x[i], y[j]);
+      glColor3f(d10, d10, d10); glVertex2f(x[i+1], y[j]);
+      glColor3f(d11, d11, d11); glVertex2f(x[i+1], y[j+1]);
+      glColor3f(d01, d01, d01); glVertex2f(x[i], y[j+1]);
     }
 
   glEnd();
@@ -328,7 +331,8 @@ void draw_xy_density(PARA_DATA *para, REAL **var, int k) {
 ///////////////////////////////////////////////////////////////////////////////
 void draw_xy_temperature(PARA_DATA *para, REAL **var, int k) {
   int i, j;
-  REAL *x = var[X], *y = var[Y], *z = var[Z], *temp = var[TEMP];
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
+  REAL *z = para->geom->mesh->z, *temp = var[TEMP];
   int mycolor;
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
@@ -369,10 +373,10 @@ void draw_xy_temperature(PARA_DATA *para, REAL **var, int k) {
         default:
           glColor3f(0.404253f, 0.122874f, 0.972873f); break;
       } 
-      glVertex2f(x[IX(i  ,j,k)], y[IX(i,j  ,k)]);
-      glVertex2f(x[IX(i+1,j,k)], y[IX(i,j  ,k)]);
-      glVertex2f(x[IX(i+1,j,k)], y[IX(i,j+1,k)]);
-      glVertex2f(x[IX(i  ,j,k)], y[IX(i,j+1,k)]);
+      glVertex2f(x[i], y[j]);
+      glVertex2f(x[i+1], y[j]);
+      glVertex2f(x[i+1], y[j+1]);
+      glVertex2f(x[i], y[j+1]);
     }
   }
 
@@ -391,7 +395,7 @@ void draw_xy_temperature(PARA_DATA *para, REAL **var, int k) {
 void draw_xy_velocity(PARA_DATA *para, REAL **var, int k) {
   int i, j;
   REAL x0, y0;
-  REAL *x = var[X], *y = var[Y];
+  REAL *x = para->geom->mesh->x, *y = para->geom->mesh->y;
   REAL *u = var[VX], *v = var[VY];
   int mycolor;
   int imax = para->geom->imax, jmax = para->geom->jmax;
@@ -405,10 +409,10 @@ void draw_xy_velocity(PARA_DATA *para, REAL **var, int k) {
 
   j = 1;
   for(i=1; i<=imax; i+=para->outp->i_N) {
-    x0 = x[IX(i,j,k)];
+    x0 = x[i];
 
     for(j=1; j<=jmax; j+=para->outp->j_N) {
-      y0 = y[IX(i,j,k)];
+      y0 = y[j];
       mycolor = (int) 100 * fabs(u[IX(i,j,k)]) / 
                       fabs(para->outp->v_ref); 
       mycolor = mycolor>10 ? 10: mycolor;
@@ -73,11 +73,10 @@ void ffd_display_func(PARA_DATA *para, REAL **var);
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to all variables
-///\param BINDEX Pointer to bounary index
 ///
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void ffd_idle_func(PARA_DATA *para, REAL **var, int **BINDEX);
+void ffd_idle_func(PARA_DATA *para, REAL **var);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// FFD routines for GLUT keyboard callback routines 